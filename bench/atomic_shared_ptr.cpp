@@ -0,0 +1,101 @@
+#include "bench.h"
+
+#include <inner/memory/atomic_shared_ptr.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mystd;
+
+
+struct Config
+{
+    long routes[16];
+    explicit Config(long v) { for(long& r : routes) r = v; }
+};
+
+// The three ways of publishing a snapshot that readers take on every request.
+struct mystd_atomic
+{
+    atomic_shared_ptr<Config> current{make_shared<Config>(0)};
+    shared_ptr<Config> load() { return current.load(); }
+    void store(long v) { current.store(make_shared<Config>(v)); }
+};
+
+struct mutex_guarded
+{
+    std::mutex lock;
+    shared_ptr<Config> current = make_shared<Config>(0);
+    shared_ptr<Config> load() { std::lock_guard<std::mutex> guard(lock); return current; }
+    void store(long v)
+    {
+        shared_ptr<Config> next = make_shared<Config>(v);
+        std::lock_guard<std::mutex> guard(lock);
+        current.swap(next);
+    }
+};
+
+struct std_atomic_functions
+{
+    std::shared_ptr<Config> current = std::make_shared<Config>(0);
+    std::shared_ptr<Config> load() { return std::atomic_load(&current); }
+    void store(long v) { std::atomic_store(&current, std::make_shared<Config>(v)); }
+};
+
+// Million loads per second summed over `readers` threads, while one writer swaps the config every 100us.
+template<typename Publisher>
+double throughput(int readers, long loads)
+{
+    Publisher publisher;
+    std::atomic<bool> stop(false);
+    std::thread writer([&]
+    {
+        long version = 0;
+        while(!stop.load(std::memory_order_relaxed))
+        {
+            publisher.store(++version);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(int t = 0; t < readers; ++t)
+        threads.emplace_back([&publisher, loads]
+        {
+            long sum = 0;
+            for(long i = 0; i < loads; ++i)
+                sum += publisher.load()->routes[i & 15];
+            do_not_optimize(sum);
+        });
+    for(std::thread& t : threads)
+        t.join();
+    auto stop_time = std::chrono::steady_clock::now();
+
+    stop = true;
+    writer.join();
+    double seconds = std::chrono::duration<double>(stop_time - start).count();
+    return readers * loads / seconds / 1e6;
+}
+
+int main()
+{
+    const long loads = 500000;
+    int max_threads = (int)std::thread::hardware_concurrency();
+    if(max_threads < 4)
+        max_threads = 4;
+
+    std::printf("%-10s %24s %24s %24s\n", "readers",
+        "atomic_shared_ptr (M/s)", "mutex+shared_ptr (M/s)", "std::atomic_load (M/s)");
+    for(int readers = 1; readers <= max_threads; readers *= 2)
+    {
+        double lock_free = throughput<mystd_atomic>(readers, loads);
+        double guarded = throughput<mutex_guarded>(readers, loads);
+        double functions = throughput<std_atomic_functions>(readers, loads);
+        std::printf("%-10d %24.1f %24.1f %24.1f\n", readers, lock_free, guarded, functions);
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+
+// Keeps the compiler from optimizing away a value we computed only for timing.
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(_MSC_VER)
+    const volatile void* volatile sink = &value;
+    (void)sink;
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+// Runs fn() `iterations` times, prints and returns the cost of one run in nanoseconds.
+template<typename Fn>
+double bench(const char* name, std::size_t iterations, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < iterations; ++i)
+        fn();
+    auto stop = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+    std::printf("%-48s %12.1f ns/op\n", name, ns);
+    return ns;
+}
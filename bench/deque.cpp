@@ -0,0 +1,85 @@
+#include "bench.h"
+
+#include <inner/containers/deque.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+using namespace mystd;
+
+
+// A queue that stays about n long: one push_back and one pop_front per op.
+template<typename Deque>
+void fifo(const char* name, int n)
+{
+    Deque q;
+    for(int i = 0; i < n; ++i)
+        q.push_back(i);
+    int i = n;
+    bench(name, 10000000, [&]
+    {
+        q.push_back(i++);
+        q.pop_front();
+        do_not_optimize(q.front());
+    });
+}
+
+// Fills a fresh deque with n elements, at the back or at the front.
+template<typename Deque>
+void fill_ends(const char* name, int n, bool front)
+{
+    bench(name, 200, [&]
+    {
+        Deque d;
+        for(int i = 0; i < n; ++i)
+        {
+            if(front)
+                d.push_front(i);
+            else
+                d.push_back(i);
+        }
+        do_not_optimize(d.back());
+    });
+}
+
+template<typename Deque>
+void algorithms(const char* label, size_t n)
+{
+    Deque d(n);
+    std::vector<int> out(n);
+    char name[96];
+
+    std::snprintf(name, sizeof(name), "std::fill %s", label);
+    bench(name, 200, [&] { std::fill(d.begin(), d.end(), 1); do_not_optimize(d[0]); });
+    std::snprintf(name, sizeof(name), "mystd::fill %s", label);
+    bench(name, 200, [&] { mystd::fill(d.begin(), d.end(), 2); do_not_optimize(d[0]); });
+
+    std::snprintf(name, sizeof(name), "std::copy %s", label);
+    bench(name, 200, [&] { std::copy(d.begin(), d.end(), out.begin()); do_not_optimize(out[0]); });
+    std::snprintf(name, sizeof(name), "mystd::copy %s", label);
+    bench(name, 200, [&] { mystd::copy(d.begin(), d.end(), out.begin()); do_not_optimize(out[0]); });
+
+    long sum = 0;
+    std::snprintf(name, sizeof(name), "std::for_each %s", label);
+    bench(name, 200, [&] { std::for_each(d.begin(), d.end(), [&sum](int x) { sum += x; }); do_not_optimize(sum); });
+    std::snprintf(name, sizeof(name), "mystd::for_each %s", label);
+    bench(name, 200, [&] { mystd::for_each(d.begin(), d.end(), [&sum](int x) { sum += x; }); do_not_optimize(sum); });
+}
+
+int main()
+{
+    fifo<std::deque<int>>("fifo of 100000 int, std::deque", 100000);
+    fifo<deque<int>>("fifo of 100000 int, mystd::deque", 100000);
+    fifo<deque<int, allocator<int>, 64>>("fifo of 100000 int, mystd::deque 64/block", 100000);
+
+    fill_ends<std::deque<int>>("push_back 100000 int, std::deque", 100000, false);
+    fill_ends<deque<int>>("push_back 100000 int, mystd::deque", 100000, false);
+    fill_ends<std::deque<int>>("push_front 100000 int, std::deque", 100000, true);
+    fill_ends<deque<int>>("push_front 100000 int, mystd::deque", 100000, true);
+
+    algorithms<std::deque<int>>("1M int, std::deque", 1 << 20);
+    algorithms<deque<int>>("1M int, mystd::deque", 1 << 20);
+    algorithms<deque<int, allocator<int>, 64>>("1M int, mystd::deque 64/block", 1 << 20);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "bench.h"
+
+#include <inner/memory/local_shared_ptr.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace mystd;
+
+
+// A node of a DAG whose edges own their targets (they only point forward, so there are no cycles).
+template<template<typename> class Ptr>
+struct Node
+{
+    std::vector<Ptr<Node>> edges;
+    long value;
+    unsigned visited;
+};
+
+template<typename T> using std_shared_ptr = std::shared_ptr<T>;
+
+template<typename T>
+local_shared_ptr<T> make(local_shared_ptr<T>*) { return make_local_shared<T>(); }
+template<typename T>
+shared_ptr<T> make(shared_ptr<T>*) { return make_shared<T>(); }
+template<typename T>
+std::shared_ptr<T> make(std::shared_ptr<T>*) { return std::make_shared<T>(); }
+
+template<template<typename> class Ptr>
+std::vector<Ptr<Node<Ptr>>> build(size_t count, size_t fanout)
+{
+    typedef Ptr<Node<Ptr>> NodePtr;
+    std::vector<NodePtr> nodes;
+    for(size_t i = 0; i < count; ++i)
+    {
+        nodes.push_back(make(static_cast<NodePtr*>(nullptr)));
+        nodes.back()->value = (long)i;
+        nodes.back()->visited = 0;
+    }
+    unsigned seed = 12345;
+    for(size_t i = 0; i + 1 < count; ++i)
+        for(size_t e = 0; e < fanout; ++e)
+        {
+            seed = seed * 1103515245 + 12345;
+            size_t target = i + 1 + seed % (count - i - 1);
+            nodes[i]->edges.push_back(nodes[target]);
+        }
+    return nodes;
+}
+
+// Depth-first walk that holds every node it is about to visit by value, as
+// code handing owners around would: each step copies fanout pointers.
+template<template<typename> class Ptr>
+long traverse(const Ptr<Node<Ptr>>& root, unsigned generation)
+{
+    std::vector<Ptr<Node<Ptr>>> stack;
+    stack.push_back(root);
+    long sum = 0;
+    while(!stack.empty())
+    {
+        Ptr<Node<Ptr>> node = std::move(stack.back());
+        stack.pop_back();
+        if(node->visited == generation)
+            continue;
+        node->visited = generation;
+        sum += node->value;
+        for(const Ptr<Node<Ptr>>& next : node->edges)
+            stack.push_back(next);
+    }
+    return sum;
+}
+
+template<template<typename> class Ptr>
+void run(const char* name)
+{
+    std::vector<Ptr<Node<Ptr>>> nodes = build<Ptr>(20000, 4);
+    unsigned generation = 0;
+    bench(name, 50, [&]
+    {
+        long sum = traverse<Ptr>(nodes.front(), ++generation);
+        do_not_optimize(sum);
+    });
+}
+
+int main()
+{
+    std::printf("single-threaded process\n");
+    run<local_shared_ptr>("local_shared_ptr graph traversal");
+    run<shared_ptr>("mystd::shared_ptr graph traversal");
+    run<std_shared_ptr>("std::shared_ptr graph traversal");
+
+    // libstdc++ skips its atomics until the process starts a second thread
+    std::thread([] {}).join();
+    std::printf("after starting a thread\n");
+    run<local_shared_ptr>("local_shared_ptr graph traversal");
+    run<shared_ptr>("mystd::shared_ptr graph traversal");
+    run<std_shared_ptr>("std::shared_ptr graph traversal");
+
+    return 0;
+}
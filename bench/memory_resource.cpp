@@ -0,0 +1,66 @@
+#include "bench.h"
+
+#include <inner/memory/memory_resource.h>
+#include <inner/memory/monotonic_arena.h>
+
+using namespace mystd;
+
+
+struct Node
+{
+    Node* next;
+    long value;
+    Node(long v) : next(nullptr), value(v) {}
+};
+
+const int batch = 64;
+
+// allocate a batch of nodes through allocator_traits, then free them
+template<typename Alloc>
+void churn(Alloc& alloc)
+{
+    typedef allocator_traits<Alloc> traits;
+    Node* nodes[batch];
+    for(int i = 0; i < batch; ++i)
+    {
+        nodes[i] = traits::allocate(alloc, 1);
+        traits::construct(alloc, nodes[i], i);
+    }
+    do_not_optimize(nodes);
+    for(int i = 0; i < batch; ++i)
+    {
+        traits::destroy(alloc, nodes[i]);
+        traits::deallocate(alloc, nodes[i], 1);
+    }
+}
+
+int main()
+{
+    const size_t iterations = 100000;
+
+    std::printf("-- pooled, %d nodes per op\n", batch);
+    allocator<Node> heap;
+    bench("allocator<Node>", iterations, [&] { churn(heap); });
+
+    pool_allocator<Node> pool;
+    bench("pool_allocator<Node> (static)", iterations, [&] { churn(pool); });
+
+    pmr::unsynchronized_pool_resource unsync;
+    pmr::polymorphic_allocator<Node> unsync_alloc(&unsync);
+    bench("polymorphic_allocator<Node> unsync pool", iterations, [&] { churn(unsync_alloc); });
+
+    pmr::synchronized_pool_resource sync;
+    pmr::polymorphic_allocator<Node> sync_alloc(&sync);
+    bench("polymorphic_allocator<Node> sync pool", iterations, [&] { churn(sync_alloc); });
+
+    std::printf("-- monotonic, %d nodes per op, released every op\n", batch);
+    monotonic_arena arena;
+    arena_allocator<Node> arena_alloc(arena);
+    bench("arena_allocator<Node> (static)", iterations, [&] { churn(arena_alloc); arena.release(); });
+
+    char buffer[batch * sizeof(Node) * 2];
+    pmr::monotonic_buffer_resource mono(buffer, sizeof(buffer), pmr::null_memory_resource());
+    pmr::polymorphic_allocator<Node> mono_alloc(&mono);
+    bench("polymorphic_allocator<Node> stack buffer", iterations, [&] { churn(mono_alloc); mono.release(); });
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "bench.h"
+
+#include <inner/memory/monotonic_arena.h>
+
+using namespace mystd;
+
+
+struct Node
+{
+    Node* next;
+    long value;
+    Node(long v) : next(nullptr), value(v) {}
+};
+
+// One "request": build a list of `count` nodes through allocator_traits, walk it, tear it down.
+template<typename Alloc>
+long run_request(Alloc& alloc, int count)
+{
+    typedef allocator_traits<Alloc> traits;
+    Node* head = nullptr;
+    for(int i = 0; i < count; ++i)
+    {
+        Node* n = traits::allocate(alloc, 1);
+        traits::construct(alloc, n, i);
+        n->next = head;
+        head = n;
+    }
+    long sum = 0;
+    for(Node* n = head; n != nullptr; )
+    {
+        Node* next = n->next;
+        sum += n->value;
+        traits::destroy(alloc, n);
+        traits::deallocate(alloc, n, 1);
+        n = next;
+    }
+    return sum;
+}
+
+int main()
+{
+    const int nodes_per_request[] = { 16, 256, 4096 };
+    char name[64];
+
+    for(int count : nodes_per_request)
+    {
+        std::snprintf(name, sizeof(name), "allocator<Node>, %d nodes/request", count);
+        allocator<Node> heap;
+        bench(name, 2000, [&] { do_not_optimize(run_request(heap, count)); });
+
+        std::snprintf(name, sizeof(name), "arena_allocator<Node>, %d nodes/request", count);
+        monotonic_arena arena;
+        arena_allocator<Node> bump(arena);
+        bench(name, 2000, [&] {
+            do_not_optimize(run_request(bump, count));
+            arena.release();
+        });
+    }
+    return 0;
+}
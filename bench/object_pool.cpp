@@ -0,0 +1,54 @@
+#include "bench.h"
+
+#include <inner/memory/object_pool.h>
+
+#include <string>
+#include <vector>
+
+using namespace mystd;
+
+
+struct Request
+{
+    long id;
+    char header[64];
+    std::string body;
+    explicit Request(long i = 0) : id(i) { body.reserve(256); }
+};
+
+struct clear_request
+{
+    void operator()(Request& r) const { r.id = 0; r.body.clear(); }
+};
+
+// Keeps `window` requests in flight: each step drops the oldest and creates a new one.
+template<typename Ptr, typename Make>
+void churn(const char* name, Make make)
+{
+    const size_t window = 64;
+    std::vector<Ptr> in_flight(window);
+    long i = 0;
+    bench(name, 2000000, [&]
+    {
+        Ptr& slot = in_flight[i % window];
+        slot = make(i++);
+        slot->body.append("GET /", 5);
+        do_not_optimize(slot->body.data());
+    });
+}
+
+int main()
+{
+    churn<unique_ptr<Request>>("new/delete",
+        [](long i) { return unique_ptr<Request>(new Request(i)); });
+
+    object_pool<Request> pool;
+    churn<object_pool<Request>::pointer>("object_pool (destroy on release)",
+        [&pool](long i) { return pool.acquire(i); });
+
+    object_pool<Request, clear_request> reset_pool;
+    churn<object_pool<Request, clear_request>::pointer>("object_pool (reset in place)",
+        [&reset_pool](long i) { return reset_pool.acquire(i); });
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "bench.h"
+
+#include <inner/memory/allocators.h>
+
+#include <thread>
+#include <vector>
+
+using namespace mystd;
+
+
+struct Node
+{
+    Node* next;
+    long value;
+    Node(long v) : next(nullptr), value(v) {}
+};
+
+// Each thread allocates a batch of nodes, then frees them, `rounds` times.
+template<typename Alloc>
+void churn(int rounds)
+{
+    typedef allocator_traits<Alloc> traits;
+    const int batch = 64;
+    Alloc alloc;
+    Node* nodes[batch];
+    for(int r = 0; r < rounds; ++r)
+    {
+        for(int i = 0; i < batch; ++i)
+        {
+            nodes[i] = traits::allocate(alloc, 1);
+            traits::construct(alloc, nodes[i], i);
+        }
+        do_not_optimize(nodes);
+        for(int i = 0; i < batch; ++i)
+        {
+            traits::destroy(alloc, nodes[i]);
+            traits::deallocate(alloc, nodes[i], 1);
+        }
+    }
+}
+
+// Returns allocate+deallocate pairs per second across all threads.
+template<typename Alloc>
+double throughput(int threads, int rounds)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t)
+        workers.emplace_back(churn<Alloc>, rounds);
+    for(std::thread& w : workers)
+        w.join();
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    return threads * rounds * 64.0 / seconds;
+}
+
+int main()
+{
+    const int rounds = 20000;
+    std::printf("%-10s %22s %22s\n", "threads", "allocator (Mops/s)", "pool_allocator (Mops/s)");
+    for(int threads = 1; threads <= 8; threads *= 2)
+    {
+        double heap = throughput<allocator<Node>>(threads, rounds);
+        double pool = throughput<pool_allocator<Node>>(threads, rounds);
+        std::printf("%-10d %22.1f %22.1f\n", threads, heap / 1e6, pool / 1e6);
+    }
+    return 0;
+}
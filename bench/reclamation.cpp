@@ -0,0 +1,208 @@
+#include "bench.h"
+
+#include <inner/memory/reclamation.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace mystd;
+
+
+struct Node
+{
+    std::atomic<Node*> next;
+    long value;
+    explicit Node(long v) : next(nullptr), value(v) {}
+};
+
+typedef allocator<Node> node_allocator;
+typedef allocator_traits<node_allocator> node_traits;
+
+Node* new_node(long v)
+{
+    node_allocator a;
+    Node* n = node_traits::allocate(a, 1);
+    node_traits::construct(a, n, v);
+    return n;
+}
+
+// A table of slots read on every lookup and replaced now and then, like a map's buckets.
+struct table
+{
+    static const int slots = 64;
+    std::atomic<Node*> slot[slots];
+
+    table() { for(int i = 0; i < slots; ++i) slot[i].store(new_node(i)); }
+    ~table()
+    {
+        node_allocator a;
+        for(int i = 0; i < slots; ++i)
+        {
+            Node* n = slot[i].load();
+            node_traits::destroy(a, n);
+            node_traits::deallocate(a, n, 1);
+        }
+    }
+};
+
+struct hazard_scheme
+{
+    typedef hazard_domain<> domain_type;
+    domain_type domain;
+
+    struct thread_state
+    {
+        domain_type::participant self;
+        hazard_pointer hp;
+        explicit thread_state(hazard_scheme& s) : self(s.domain), hp(s.domain) {}
+    };
+
+    static long read_all(thread_state& t, table& tab)
+    {
+        long sum = 0;
+        for(int i = 0; i < table::slots; ++i)
+            sum += t.hp.protect(tab.slot[i])->value;
+        t.hp.reset_protection();
+        return sum;
+    }
+
+    static bool pop(thread_state& t, std::atomic<Node*>& head)
+    {
+        for(;;)
+        {
+            Node* top = t.hp.protect(head);
+            if(top == nullptr)
+                return false;
+            Node* next = top->next.load(std::memory_order_relaxed);
+            if(head.compare_exchange_weak(top, next, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                t.hp.reset_protection();
+                t.self.retire(top);
+                return true;
+            }
+        }
+    }
+
+    static void retire(thread_state& t, Node* n) { t.self.retire(n); }
+};
+
+struct epoch_scheme
+{
+    typedef epoch_domain<> domain_type;
+    domain_type domain;
+
+    struct thread_state
+    {
+        domain_type::participant self;
+        explicit thread_state(epoch_scheme& s) : self(s.domain) {}
+    };
+
+    static long read_all(thread_state& t, table& tab)
+    {
+        domain_type::guard pinned = t.self.enter();
+        long sum = 0;
+        for(int i = 0; i < table::slots; ++i)
+            sum += tab.slot[i].load(std::memory_order_acquire)->value;
+        return sum;
+    }
+
+    static bool pop(thread_state& t, std::atomic<Node*>& head)
+    {
+        domain_type::guard pinned = t.self.enter();
+        Node* top = head.load(std::memory_order_acquire);
+        while(top != nullptr)
+        {
+            Node* next = top->next.load(std::memory_order_relaxed);
+            if(head.compare_exchange_weak(top, next, std::memory_order_acquire, std::memory_order_acquire))
+            {
+                t.self.retire(top);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void retire(thread_state& t, Node* n) { t.self.retire(n); }
+};
+
+void push(std::atomic<Node*>& head, Node* n)
+{
+    Node* top = head.load(std::memory_order_relaxed);
+    do
+        n->next.store(top, std::memory_order_relaxed);
+    while(!head.compare_exchange_weak(top, n, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// Million push+pop pairs per second on one Treiber stack.
+template<typename Scheme>
+double stack_throughput(int threads, int rounds)
+{
+    Scheme scheme;
+    std::atomic<Node*> head(nullptr);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t)
+        workers.emplace_back([&]
+        {
+            typename Scheme::thread_state state(scheme);
+            for(int i = 0; i < rounds; ++i)
+            {
+                push(head, new_node(i));
+                Scheme::pop(state, head);
+            }
+        });
+    for(std::thread& w : workers)
+        w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * rounds / seconds / 1e6;
+}
+
+// Million 64-slot lookups per second, while every thread also replaces a slot every 16 lookups.
+template<typename Scheme>
+double table_throughput(int threads, int rounds)
+{
+    Scheme scheme;
+    table tab;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t)
+        workers.emplace_back([&, t]
+        {
+            typename Scheme::thread_state state(scheme);
+            long sum = 0;
+            for(int i = 0; i < rounds; ++i)
+            {
+                sum += Scheme::read_all(state, tab);
+                if(i % 16 == 0)
+                {
+                    int s = (i / 16 + t) % table::slots;
+                    Scheme::retire(state, tab.slot[s].exchange(new_node(i), std::memory_order_acq_rel));
+                }
+            }
+            do_not_optimize(sum);
+        });
+    for(std::thread& w : workers)
+        w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * rounds / seconds / 1e6;
+}
+
+int main()
+{
+    int max_threads = (int)std::thread::hardware_concurrency();
+    if(max_threads < 4)
+        max_threads = 4;
+
+    std::printf("%-10s %18s %18s %18s %18s\n", "threads",
+        "stack HP (M/s)", "stack EBR (M/s)", "table HP (M/s)", "table EBR (M/s)");
+    for(int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        double stack_hp = stack_throughput<hazard_scheme>(threads, 200000);
+        double stack_ebr = stack_throughput<epoch_scheme>(threads, 200000);
+        double table_hp = table_throughput<hazard_scheme>(threads, 100000);
+        double table_ebr = table_throughput<epoch_scheme>(threads, 100000);
+        std::printf("%-10d %18.2f %18.2f %18.2f %18.2f\n", threads, stack_hp, stack_ebr, table_hp, table_ebr);
+    }
+    return 0;
+}
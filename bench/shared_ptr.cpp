@@ -0,0 +1,75 @@
+#include "bench.h"
+
+#include <inner/memory/shared_ptr.h>
+
+#include <memory>
+#include <vector>
+
+using namespace mystd;
+
+
+struct Payload
+{
+    long values[4];
+    explicit Payload(long v) : values{v, v, v, v} {}
+};
+
+// make_shared + drop: one allocation, one construction, one release.
+template<typename Ptr, typename Make>
+void create_destroy(const char* name, Make make)
+{
+    long i = 0;
+    bench(name, 2000000, [&]
+    {
+        Ptr p = make(i++);
+        do_not_optimize(p);
+    });
+}
+
+// Copies a handful of owners and drops them again: pure reference count traffic.
+template<typename Ptr>
+void copy_destroy(const char* name, const Ptr& source)
+{
+    bench(name, 2000000, [&]
+    {
+        Ptr a = source;
+        Ptr b = a;
+        Ptr c = b;
+        do_not_optimize(c);
+    });
+}
+
+// Fills a vector of owners, copies the vector, then drops both.
+template<typename Ptr, typename Make>
+void bulk(const char* name, Make make)
+{
+    bench(name, 200, [&]
+    {
+        std::vector<Ptr> objects;
+        objects.reserve(4096);
+        for(long i = 0; i < 4096; ++i)
+            objects.push_back(make(i));
+        std::vector<Ptr> copies = objects;
+        do_not_optimize(copies.back());
+    });
+}
+
+int main()
+{
+    auto make_mystd = [](long v) { return make_shared<Payload>(v); };
+    auto make_std = [](long v) { return std::make_shared<Payload>(v); };
+    auto make_pool = [](long v) { return allocate_shared<Payload>(pool_allocator<Payload>(), v); };
+
+    create_destroy<shared_ptr<Payload>>("mystd::make_shared create/destroy", make_mystd);
+    create_destroy<std::shared_ptr<Payload>>("std::make_shared create/destroy", make_std);
+    create_destroy<shared_ptr<Payload>>("mystd::allocate_shared(pool) create/destroy", make_pool);
+
+    copy_destroy("mystd::shared_ptr copy x3/destroy", make_shared<Payload>(1));
+    copy_destroy("std::shared_ptr copy x3/destroy", std::make_shared<Payload>(1));
+
+    bulk<shared_ptr<Payload>>("mystd::shared_ptr 4096 create+copy+destroy", make_mystd);
+    bulk<std::shared_ptr<Payload>>("std::shared_ptr 4096 create+copy+destroy", make_std);
+    bulk<shared_ptr<Payload>>("mystd::shared_ptr(pool) 4096 create+copy+destroy", make_pool);
+
+    return 0;
+}
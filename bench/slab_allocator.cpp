@@ -0,0 +1,104 @@
+#include "bench.h"
+
+#include <inner/memory/allocators.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace mystd;
+
+
+struct Message
+{
+    long sequence;
+    long payload[5];
+};
+
+// One single-producer/single-consumer ring between a producer and a consumer thread.
+class ring
+{
+    std::vector<std::atomic<Message*>> slots_;
+
+public:
+    explicit ring(size_t capacity) : slots_(capacity)
+    {
+        for(std::atomic<Message*>& slot : slots_)
+            slot.store(nullptr, std::memory_order_relaxed);
+    }
+
+    void push(long i, Message* m)
+    {
+        std::atomic<Message*>& slot = slots_[i % slots_.size()];
+        while(slot.load(std::memory_order_acquire) != nullptr)
+            std::this_thread::yield();
+        slot.store(m, std::memory_order_release);
+    }
+
+    Message* pop(long i)
+    {
+        std::atomic<Message*>& slot = slots_[i % slots_.size()];
+        Message* m;
+        while((m = slot.load(std::memory_order_acquire)) == nullptr)
+            std::this_thread::yield();
+        slot.store(nullptr, std::memory_order_release);
+        return m;
+    }
+};
+
+// `pairs` producer threads each allocate `count` messages that their consumer frees.
+// Returns messages per second across all pairs.
+template<typename Alloc>
+double pipeline(int pairs, long count)
+{
+    typedef allocator_traits<Alloc> traits;
+    std::vector<ring> rings;
+    for(int p = 0; p < pairs; ++p)
+        rings.emplace_back(4096);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(int p = 0; p < pairs; ++p)
+    {
+        ring& r = rings[p];
+        threads.emplace_back([&r, count] {
+            Alloc alloc;
+            for(long i = 0; i < count; ++i)
+            {
+                Message* m = traits::allocate(alloc, 1);
+                m->sequence = i;
+                r.push(i, m);
+            }
+        });
+        threads.emplace_back([&r, count] {
+            Alloc alloc;
+            long sum = 0;
+            for(long i = 0; i < count; ++i)
+            {
+                Message* m = r.pop(i);
+                sum += m->sequence;
+                traits::deallocate(alloc, m, 1);
+            }
+            do_not_optimize(sum);
+        });
+    }
+    for(std::thread& t : threads)
+        t.join();
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    return pairs * count / seconds;
+}
+
+int main()
+{
+    const long count = 500000;
+    std::printf("%-8s %20s %20s %20s\n", "pairs", "allocator (M/s)", "pool_allocator (M/s)", "slab_allocator (M/s)");
+    for(int pairs = 1; pairs <= 4; pairs *= 2)
+    {
+        double heap = pipeline<allocator<Message>>(pairs, count);
+        double pool = pipeline<pool_allocator<Message>>(pairs, count);
+        double slab = pipeline<slab_allocator<Message>>(pairs, count);
+        std::printf("%-8d %20.1f %20.1f %20.1f\n", pairs, heap / 1e6, pool / 1e6, slab / 1e6);
+    }
+    return 0;
+}
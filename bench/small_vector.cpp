@@ -0,0 +1,50 @@
+#include "bench.h"
+
+#include <inner/containers/small_vector.h>
+
+#include <vector>
+
+using namespace mystd;
+
+
+// Builds and drops a list of `count` entries, like a per-request header list.
+template<typename Vector>
+void build(const char* name, int count)
+{
+    int i = 0;
+    bench(name, 2000000, [&]
+    {
+        Vector v;
+        for(int k = 0; k < count; ++k)
+            v.push_back(i + k);
+        ++i;
+        do_not_optimize(v.data());
+    });
+}
+
+template<size_t N>
+void sizes_and_latency()
+{
+    typedef small_vector<int, N> small;
+    char name[64];
+    std::printf("small_vector<int, %zu>: %zu bytes\n", N, sizeof(small));
+    for(int count : {int(N) / 2, int(N), int(N) * 2})
+    {
+        std::snprintf(name, sizeof(name), "  %d elements, small_vector<int, %zu>", count, N);
+        build<small>(name, count);
+        std::snprintf(name, sizeof(name), "  %d elements, vector<int>", count);
+        build<vector<int>>(name, count);
+        std::snprintf(name, sizeof(name), "  %d elements, std::vector<int>", count);
+        build<std::vector<int>>(name, count);
+    }
+}
+
+int main()
+{
+    std::printf("vector<int>: %zu bytes, std::vector<int>: %zu bytes\n",
+        sizeof(vector<int>), sizeof(std::vector<int>));
+    sizes_and_latency<4>();
+    sizes_and_latency<8>();
+    sizes_and_latency<16>();
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "bench.h"
+
+#include <inner/memory/stats_allocator.h>
+
+using namespace mystd;
+
+
+struct Node
+{
+    Node* next;
+    long value;
+};
+
+struct bench_tag { static const char* name() { return "bench"; } };
+
+const int batch = 64;
+
+template<typename Alloc>
+void churn(Alloc& alloc)
+{
+    typedef allocator_traits<Alloc> traits;
+    Node* nodes[batch];
+    for(int i = 0; i < batch; ++i)
+        nodes[i] = traits::allocate(alloc, 1);
+    do_not_optimize(nodes);
+    for(int i = 0; i < batch; ++i)
+        traits::deallocate(alloc, nodes[i], 1);
+}
+
+int main()
+{
+    const size_t iterations = 100000;
+
+    allocator<Node> heap;
+    bench("allocator<Node>", iterations, [&] { churn(heap); });
+    stats_allocator<allocator<Node>, bench_tag> heap_stats;
+    bench("stats_allocator<allocator<Node>>", iterations, [&] { churn(heap_stats); });
+
+    pool_allocator<Node> pool;
+    bench("pool_allocator<Node>", iterations, [&] { churn(pool); });
+    stats_allocator<pool_allocator<Node>, bench_tag> pool_stats;
+    bench("stats_allocator<pool_allocator<Node>>", iterations, [&] { churn(pool_stats); });
+
+    std::printf("%s\n", allocation_stats<bench_tag>::snapshot().to_json().c_str());
+    return 0;
+}
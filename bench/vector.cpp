@@ -0,0 +1,104 @@
+#include "bench.h"
+
+#include <inner/containers/vector.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace mystd;
+
+
+// Fills a fresh vector with n elements, growing it one push_back at a time.
+template<typename Vector, typename Make>
+void push_back(const char* name, size_t n, Make make)
+{
+    bench(name, 2000, [&]
+    {
+        Vector v;
+        for(size_t i = 0; i < n; ++i)
+            v.push_back(make(i));
+        do_not_optimize(v.data());
+    });
+}
+
+// Inserts in the middle of a vector of n elements, then erases what it inserted.
+template<typename Vector, typename Make>
+void insert_erase(const char* name, size_t n, Make make)
+{
+    Vector v;
+    for(size_t i = 0; i < n; ++i)
+        v.push_back(make(i));
+    size_t i = 0;
+    bench(name, 200000, [&]
+    {
+        auto pos = v.begin() + (i++ % n);
+        pos = v.insert(pos, make(i));
+        v.erase(pos);
+        do_not_optimize(v.data());
+    });
+}
+
+// Erases the front run of a vector, refilling it at the back to keep its size.
+template<typename Vector, typename Make>
+void erase_front(const char* name, size_t n, Make make)
+{
+    Vector v;
+    for(size_t i = 0; i < n; ++i)
+        v.push_back(make(i));
+    size_t i = 0;
+    bench(name, 200000, [&]
+    {
+        v.erase(v.begin(), v.begin() + 4);
+        for(int k = 0; k < 4; ++k)
+            v.push_back(make(i++));
+        do_not_optimize(v.data());
+    });
+}
+
+// Refills a reused buffer with src, the way a read() loop or a decoder would.
+template<typename Grow>
+void fill_buffer(const char* name, const std::vector<char>& src, Grow grow)
+{
+    vector<char> buffer;
+    buffer.reserve(src.size());
+    bench(name, 50, [&]
+    {
+        buffer.clear();
+        char* out = grow(buffer, src.size());
+        std::memcpy(out, src.data(), src.size());
+        do_not_optimize(buffer.data());
+    });
+}
+
+int main()
+{
+    auto make_int = [](size_t i) { return (int)i; };
+    auto make_string = [](size_t i) { return std::string(32, char('a' + i % 26)); };
+
+    push_back<std::vector<int>>("push_back 10000 int, std::vector", 10000, make_int);
+    push_back<vector<int>>("push_back 10000 int, mystd::vector", 10000, make_int);
+    push_back<vector<int, allocator<int>, growth_factor<3, 2>>>("push_back 10000 int, mystd::vector 1.5x", 10000, make_int);
+    push_back<std::vector<std::string>>("push_back 1000 string, std::vector", 1000, make_string);
+    push_back<vector<std::string>>("push_back 1000 string, mystd::vector", 1000, make_string);
+
+    insert_erase<std::vector<int>>("insert+erase in 1000 int, std::vector", 1000, make_int);
+    insert_erase<vector<int>>("insert+erase in 1000 int, mystd::vector", 1000, make_int);
+    insert_erase<std::vector<std::string>>("insert+erase in 1000 string, std::vector", 1000, make_string);
+    insert_erase<vector<std::string>>("insert+erase in 1000 string, mystd::vector", 1000, make_string);
+
+    erase_front<std::vector<int>>("erase 4 at front of 1000 int, std::vector", 1000, make_int);
+    erase_front<vector<int>>("erase 4 at front of 1000 int, mystd::vector", 1000, make_int);
+    erase_front<std::vector<std::string>>("erase 4 at front of 1000 string, std::vector", 1000, make_string);
+    erase_front<vector<std::string>>("erase 4 at front of 1000 string, mystd::vector", 1000, make_string);
+
+    std::vector<char> src(64 << 20, 'x');
+    fill_buffer("fill 64 MiB, resize", src,
+        [](vector<char>& v, size_t n) { v.resize(n); return v.data(); });
+    fill_buffer("fill 64 MiB, resize_for_overwrite", src,
+        [](vector<char>& v, size_t n) { v.resize_for_overwrite(n); return v.data(); });
+    fill_buffer("fill 64 MiB, append_uninit", src,
+        [](vector<char>& v, size_t n) { return v.append_uninit(n); });
+
+    return 0;
+}
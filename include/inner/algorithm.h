@@ -0,0 +1,247 @@
+#pragma once
+
+#include "mystd.h"
+#include "type_traits.h"
+#include "iterator.h"
+
+#include <algorithm> // copy, copy_backward, move, move_backward, fill
+
+
+MYSTD_NS_BEGIN
+
+namespace detail {
+
+template<typename It>
+using is_segmented = typename segmented_iterator_traits<It>::is_segmented_iterator;
+
+// Writing through a segmented output one segment at a time needs to know how much is left to write.
+template<typename InputIt, typename OutputIt>
+using is_segmented_output = integral_constant<bool, is_segmented<OutputIt>::value
+    && is_base_of<random_access_iterator_tag, iterator_category_t<InputIt>>::value>;
+
+template<typename It, typename Fn>
+inline void for_each_segment(It first, It last, Fn& f, false_type)
+{
+    f(first, last);
+}
+
+template<typename It, typename Fn>
+inline void for_each_segment(It first, It last, Fn& f, true_type)
+{
+    typedef segmented_iterator_traits<It> traits;
+    auto seg = traits::segment(first);
+    auto last_seg = traits::segment(last);
+    if(seg == last_seg)
+    {
+        f(traits::local(first), traits::local(last));
+        return;
+    }
+    f(traits::local(first), traits::end(seg));
+    for(++seg; seg != last_seg; ++seg)
+        f(traits::begin(seg), traits::end(seg));
+    f(traits::begin(seg), traits::local(last));
+}
+
+// the same, from the last segment to the first
+template<typename It, typename Fn>
+inline void for_each_segment_backward(It first, It last, Fn& f, false_type)
+{
+    f(first, last);
+}
+
+template<typename It, typename Fn>
+inline void for_each_segment_backward(It first, It last, Fn& f, true_type)
+{
+    typedef segmented_iterator_traits<It> traits;
+    auto seg = traits::segment(first);
+    auto last_seg = traits::segment(last);
+    if(seg == last_seg)
+    {
+        f(traits::local(first), traits::local(last));
+        return;
+    }
+    f(traits::begin(last_seg), traits::local(last));
+    for(--last_seg; last_seg != seg; --last_seg)
+        f(traits::begin(last_seg), traits::end(last_seg));
+    f(traits::local(first), traits::end(seg));
+}
+
+struct copy_op
+{
+    template<typename InputIt, typename OutputIt>
+    OutputIt operator()(InputIt first, InputIt last, OutputIt out) const { return std::copy(first, last, out); }
+};
+
+struct move_op
+{
+    template<typename InputIt, typename OutputIt>
+    OutputIt operator()(InputIt first, InputIt last, OutputIt out) const { return std::move(first, last, out); }
+};
+
+struct copy_backward_op
+{
+    template<typename BidIt1, typename BidIt2>
+    BidIt2 operator()(BidIt1 first, BidIt1 last, BidIt2 d_last) const { return std::copy_backward(first, last, d_last); }
+};
+
+struct move_backward_op
+{
+    template<typename BidIt1, typename BidIt2>
+    BidIt2 operator()(BidIt1 first, BidIt1 last, BidIt2 d_last) const { return std::move_backward(first, last, d_last); }
+};
+
+// Applies op to [first, last) and out, split where out crosses into its next segment.
+template<typename InputIt, typename OutputIt, typename Op>
+inline OutputIt transfer_to(InputIt first, InputIt last, OutputIt out, Op op, false_type)
+{
+    return op(first, last, out);
+}
+
+template<typename RanIt, typename OutputIt, typename Op>
+inline OutputIt transfer_to(RanIt first, RanIt last, OutputIt out, Op op, true_type)
+{
+    typedef segmented_iterator_traits<OutputIt> traits;
+    if(first == last)
+        return out;
+    auto seg = traits::segment(out);
+    auto local = traits::local(out);
+    for(;;)
+    {
+        auto room = traits::end(seg) - local;
+        if(last - first <= room)
+            return traits::compose(seg, op(first, last, local));
+        op(first, first + room, local);
+        first += room;
+        ++seg;
+        local = traits::begin(seg);
+    }
+}
+
+template<typename InputIt, typename OutputIt, typename Op>
+inline OutputIt transfer(InputIt first, InputIt last, OutputIt out, Op op, false_type)
+{
+    return transfer_to(first, last, out, op, is_segmented_output<InputIt, OutputIt>());
+}
+
+template<typename InputIt, typename OutputIt, typename Op>
+inline OutputIt transfer(InputIt first, InputIt last, OutputIt out, Op op, true_type)
+{
+    typedef typename segmented_iterator_traits<InputIt>::local_iterator local_iterator;
+    auto run = [&](local_iterator l_first, local_iterator l_last)
+    {
+        out = transfer_to(l_first, l_last, out, op, is_segmented_output<local_iterator, OutputIt>());
+    };
+    for_each_segment(first, last, run, true_type());
+    return out;
+}
+
+// The same as transfer_to and transfer, backward from d_last.
+template<typename BidIt1, typename BidIt2, typename Op>
+inline BidIt2 transfer_backward_to(BidIt1 first, BidIt1 last, BidIt2 d_last, Op op, false_type)
+{
+    return op(first, last, d_last);
+}
+
+template<typename RanIt, typename BidIt2, typename Op>
+inline BidIt2 transfer_backward_to(RanIt first, RanIt last, BidIt2 d_last, Op op, true_type)
+{
+    typedef segmented_iterator_traits<BidIt2> traits;
+    if(first == last)
+        return d_last;
+    auto seg = traits::segment(d_last);
+    auto local = traits::local(d_last);
+    for(;;)
+    {
+        auto room = local - traits::begin(seg);
+        if(last - first <= room)
+            return traits::compose(seg, op(first, last, local));
+        op(last - room, last, local);
+        last -= room;
+        --seg;
+        local = traits::end(seg);
+    }
+}
+
+template<typename BidIt1, typename BidIt2, typename Op>
+inline BidIt2 transfer_backward(BidIt1 first, BidIt1 last, BidIt2 d_last, Op op, false_type)
+{
+    return transfer_backward_to(first, last, d_last, op, is_segmented_output<BidIt1, BidIt2>());
+}
+
+template<typename BidIt1, typename BidIt2, typename Op>
+inline BidIt2 transfer_backward(BidIt1 first, BidIt1 last, BidIt2 d_last, Op op, true_type)
+{
+    typedef typename segmented_iterator_traits<BidIt1>::local_iterator local_iterator;
+    auto run = [&](local_iterator l_first, local_iterator l_last)
+    {
+        d_last = transfer_backward_to(l_first, l_last, d_last, op, is_segmented_output<local_iterator, BidIt2>());
+    };
+    for_each_segment_backward(first, last, run, true_type());
+    return d_last;
+}
+
+} // namespace detail
+
+
+/**
+ *  Calls f(local_first, local_last) on each contiguous run of [first, last), in
+ *  order: once per segment for a segmented iterator (see segmented_iterator_traits),
+ *  once on the whole range for any other.
+*/
+template<typename InputIt, typename Fn>
+inline Fn for_each_segment(InputIt first, InputIt last, Fn f)
+{
+    detail::for_each_segment(first, last, f, detail::is_segmented<InputIt>());
+    return f;
+}
+
+/**
+ *  The algorithms below are std's, but walk segmented iterators one segment at a
+ *  time: copying or filling a deque runs one plain loop (or memmove, memset) per
+ *  block. Ranges whose iterators are not segmented go straight to std's.
+*/
+template<typename InputIt, typename Fn>
+inline Fn for_each(InputIt first, InputIt last, Fn f)
+{
+    auto run = [&f](auto l_first, auto l_last)
+    {
+        for(; l_first != l_last; ++l_first)
+            f(*l_first);
+    };
+    detail::for_each_segment(first, last, run, detail::is_segmented<InputIt>());
+    return f;
+}
+
+template<typename ForwardIt, typename T>
+inline void fill(ForwardIt first, ForwardIt last, const T& value)
+{
+    auto run = [&value](auto l_first, auto l_last) { std::fill(l_first, l_last, value); };
+    detail::for_each_segment(first, last, run, detail::is_segmented<ForwardIt>());
+}
+
+template<typename InputIt, typename OutputIt>
+inline OutputIt copy(InputIt first, InputIt last, OutputIt out)
+{
+    return detail::transfer(first, last, out, detail::copy_op(), detail::is_segmented<InputIt>());
+}
+
+template<typename InputIt, typename OutputIt>
+inline OutputIt move(InputIt first, InputIt last, OutputIt out)
+{
+    return detail::transfer(first, last, out, detail::move_op(), detail::is_segmented<InputIt>());
+}
+
+template<typename BidIt1, typename BidIt2>
+inline BidIt2 copy_backward(BidIt1 first, BidIt1 last, BidIt2 d_last)
+{
+    return detail::transfer_backward(first, last, d_last, detail::copy_backward_op(), detail::is_segmented<BidIt1>());
+}
+
+template<typename BidIt1, typename BidIt2>
+inline BidIt2 move_backward(BidIt1 first, BidIt1 last, BidIt2 d_last)
+{
+    return detail::transfer_backward(first, last, d_last, detail::move_backward_op(), detail::is_segmented<BidIt1>());
+}
+
+
+MYSTD_NS_END
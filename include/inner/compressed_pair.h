@@ -0,0 +1,107 @@
+#pragma once
+
+#include "mystd.h"
+#include "type_traits.h"
+#include <tuple> // tuple, get
+#include <utility> // forward, piecewise_construct_t, index_sequence, swap
+
+
+MYSTD_NS_BEGIN
+
+namespace detail {
+
+// One member of a compressed_pair. Index keeps the two bases distinct when T1 and T2 are the same type.
+template<typename T, int Index, bool = is_empty_v<T> && !is_final_v<T>>
+class compressed_pair_element
+{
+    T value_;
+
+public:
+    constexpr compressed_pair_element() : value_() {}
+
+    template<typename U,
+        typename = enable_if_t<!is_same_v<decay_t<U>, compressed_pair_element>>>
+    constexpr explicit compressed_pair_element(U&& u) : value_(std::forward<U>(u)) {}
+
+    template<typename... Args, size_t... I>
+    compressed_pair_element(std::tuple<Args...>& args, std::index_sequence<I...>)
+        : value_(std::forward<Args>(std::get<I>(args))...) {}
+
+    T& get() noexcept { return value_; }
+    const T& get() const noexcept { return value_; }
+};
+
+// An empty member is a base class instead, so it takes no room (empty-base optimization).
+template<typename T, int Index>
+class compressed_pair_element<T, Index, true> : private T
+{
+public:
+    constexpr compressed_pair_element() : T() {}
+
+    template<typename U,
+        typename = enable_if_t<!is_same_v<decay_t<U>, compressed_pair_element>>>
+    constexpr explicit compressed_pair_element(U&& u) : T(std::forward<U>(u)) {}
+
+    template<typename... Args, size_t... I>
+    compressed_pair_element(std::tuple<Args...>& args, std::index_sequence<I...>)
+        : T(std::forward<Args>(std::get<I>(args))...) {}
+
+    T& get() noexcept { return *this; }
+    const T& get() const noexcept { return *this; }
+};
+
+} // namespace detail
+
+
+/**
+ *  A pair whose empty members take no space. Members whose type is empty and not
+ *  final are stored as base classes, so e.g. compressed_pair<T*, default_delete<T>>
+ *  or a pointer paired with a stateless allocator is as big as the pointer alone.
+ *
+ *  The members are reached through first() and second(); either may be a reference.
+*/
+template<typename T1, typename T2>
+class compressed_pair
+    : private detail::compressed_pair_element<T1, 0>
+    , private detail::compressed_pair_element<T2, 1>
+{
+    typedef detail::compressed_pair_element<T1, 0> first_base;
+    typedef detail::compressed_pair_element<T2, 1> second_base;
+
+public:
+    typedef T1 first_type;
+    typedef T2 second_type;
+
+    constexpr compressed_pair() = default;
+
+    template<typename U1, typename U2>
+    constexpr compressed_pair(U1&& first, U2&& second)
+        : first_base(std::forward<U1>(first)), second_base(std::forward<U2>(second)) {}
+
+    // Builds each member from its own argument tuple.
+    template<typename... Args1, typename... Args2>
+    compressed_pair(std::piecewise_construct_t, std::tuple<Args1...> first, std::tuple<Args2...> second)
+        : first_base(first, std::index_sequence_for<Args1...>())
+        , second_base(second, std::index_sequence_for<Args2...>()) {}
+
+    T1& first() noexcept { return static_cast<first_base&>(*this).get(); }
+    const T1& first() const noexcept { return static_cast<const first_base&>(*this).get(); }
+
+    T2& second() noexcept { return static_cast<second_base&>(*this).get(); }
+    const T2& second() const noexcept { return static_cast<const second_base&>(*this).get(); }
+
+    void swap(compressed_pair& other)
+    {
+        using std::swap;
+        swap(first(), other.first());
+        swap(second(), other.second());
+    }
+};
+
+template<typename T1, typename T2>
+inline void swap(compressed_pair<T1, T2>& a, compressed_pair<T1, T2>& b)
+{
+    a.swap(b);
+}
+
+MYSTD_NS_END
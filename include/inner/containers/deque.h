@@ -0,0 +1,1134 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "../compressed_pair.h"
+#include "../memory/allocators.h"
+#include "../memory/uninitialized.h"
+#include "../iterator.h"
+#include "../algorithm.h"
+
+#include <initializer_list> // std::initializer_list is special to the compiler, we can't achieve it in namespace mystd. see doc/initializer_list_more.md
+#include <algorithm> // copy, copy_backward, fill, max, min, rotate, equal, lexicographical_compare
+#include <cstddef> // size_t, ptrdiff_t
+#include <limits> // numeric_limits
+#include <stdexcept> // out_of_range, length_error
+#include <utility> // forward, move, swap
+
+
+MYSTD_NS_BEGIN
+
+using std::initializer_list;
+using std::size_t;
+using std::ptrdiff_t;
+
+template<typename T, typename Allocator, size_t BlockSize>
+class deque;
+
+
+namespace detail {
+
+// Blocks of about 4 KiB, and of at least 16 elements for large ones.
+template<typename T>
+struct deque_block_size
+{
+    static constexpr size_t value = sizeof(T) < 256 ? 4096 / sizeof(T) : 16;
+};
+
+template<typename T>
+constexpr size_t deque_block_size<T>::value;
+
+
+/**
+ *  Iterator of deque: the element, the block it is in and the block's slot in the
+ *  map. It only ever points past the end of a block as the end of a segment: once
+ *  it gets there it moves on to the start of the next block.
+*/
+template<typename T, typename Block, size_t BlockSize, bool Const>
+class deque_iterator
+{
+    typedef conditional_t<Const, const T, T> element_type;
+
+public:
+    typedef random_access_iterator_tag  iterator_category;
+    typedef T                           value_type;
+    typedef ptrdiff_t                   difference_type;
+    typedef element_type*               pointer;
+    typedef element_type&               reference;
+
+    static constexpr difference_type block_size = difference_type(BlockSize);
+
+    deque_iterator() noexcept : cur_(), first_(), node_() {}
+
+    // iterator converts to const_iterator
+    template<bool OtherConst, typename = enable_if_t<Const && !OtherConst>>
+    deque_iterator(const deque_iterator<T, Block, BlockSize, OtherConst>& other) noexcept
+        : cur_(other.cur_), first_(other.first_), node_(other.node_) {}
+
+    reference operator*() const noexcept { return *cur_; }
+    pointer operator->() const noexcept { return cur_; }
+    reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+    deque_iterator& operator++() noexcept
+    {
+        if(++cur_ == first_ + block_size)
+        {
+            set_node(node_ + 1);
+            cur_ = first_;
+        }
+        return *this;
+    }
+
+    deque_iterator operator++(int) noexcept
+    {
+        deque_iterator tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+    deque_iterator& operator--() noexcept
+    {
+        if(cur_ == first_)
+        {
+            set_node(node_ - 1);
+            cur_ = first_ + block_size;
+        }
+        --cur_;
+        return *this;
+    }
+
+    deque_iterator operator--(int) noexcept
+    {
+        deque_iterator tmp(*this);
+        --*this;
+        return tmp;
+    }
+
+    deque_iterator& operator+=(difference_type n) noexcept
+    {
+        difference_type offset = n + (cur_ - first_);
+        if(offset >= 0 && offset < block_size)
+        {
+            cur_ += n;
+        }
+        else
+        {
+            difference_type node_offset = offset > 0
+                ? offset / block_size
+                : -((-offset - 1) / block_size) - 1;
+            set_node(node_ + node_offset);
+            cur_ = first_ + (offset - node_offset * block_size);
+        }
+        return *this;
+    }
+
+    deque_iterator& operator-=(difference_type n) noexcept { return *this += -n; }
+
+    friend deque_iterator operator+(deque_iterator it, difference_type n) noexcept { return it += n; }
+    friend deque_iterator operator+(difference_type n, deque_iterator it) noexcept { return it += n; }
+    friend deque_iterator operator-(deque_iterator it, difference_type n) noexcept { return it -= n; }
+
+    friend difference_type operator-(const deque_iterator& a, const deque_iterator& b) noexcept
+    {
+        return block_size * (a.node_ - b.node_) + (a.cur_ - a.first_) - (b.cur_ - b.first_);
+    }
+
+    friend bool operator==(const deque_iterator& a, const deque_iterator& b) noexcept { return a.cur_ == b.cur_; }
+    friend bool operator!=(const deque_iterator& a, const deque_iterator& b) noexcept { return a.cur_ != b.cur_; }
+
+    friend bool operator<(const deque_iterator& a, const deque_iterator& b) noexcept
+    {
+        return a.node_ == b.node_ ? a.cur_ < b.cur_ : a.node_ < b.node_;
+    }
+    friend bool operator>(const deque_iterator& a, const deque_iterator& b) noexcept { return b < a; }
+    friend bool operator<=(const deque_iterator& a, const deque_iterator& b) noexcept { return !(b < a); }
+    friend bool operator>=(const deque_iterator& a, const deque_iterator& b) noexcept { return !(a < b); }
+
+private:
+    template<typename, typename, size_t, bool> friend class deque_iterator;
+    template<typename, typename, size_t> friend class mystd::deque;
+    friend struct segmented_iterator_traits<deque_iterator>;
+
+    void set_node(Block* node) noexcept
+    {
+        node_ = node;
+        first_ = to_address(*node);
+    }
+
+    element_type* cur_;     // the element
+    element_type* first_;   // the start of its block
+    Block* node_;           // the block's slot in the map
+};
+
+template<typename T, typename Block, size_t BlockSize, bool Const>
+constexpr typename deque_iterator<T, Block, BlockSize, Const>::difference_type
+deque_iterator<T, Block, BlockSize, Const>::block_size;
+
+} // namespace detail
+
+
+// A deque_iterator's segments are the blocks, walked through the map.
+template<typename T, typename Block, size_t BlockSize, bool Const>
+struct segmented_iterator_traits<detail::deque_iterator<T, Block, BlockSize, Const>>
+{
+    typedef detail::deque_iterator<T, Block, BlockSize, Const> iterator;
+
+    typedef true_type                   is_segmented_iterator;
+    typedef Block*                      segment_iterator;
+    typedef typename iterator::pointer  local_iterator;
+
+    static segment_iterator segment(const iterator& it) noexcept { return it.node_; }
+    static local_iterator local(const iterator& it) noexcept { return it.cur_; }
+    static local_iterator begin(segment_iterator seg) noexcept { return to_address(*seg); }
+    static local_iterator end(segment_iterator seg) noexcept { return begin(seg) + BlockSize; }
+
+    static iterator compose(segment_iterator seg, local_iterator local) noexcept
+    {
+        if(local == end(seg))
+        {
+            ++seg;
+            local = begin(seg);
+        }
+        iterator it;
+        it.set_node(seg);
+        it.cur_ = local;
+        return it;
+    }
+};
+
+
+/**
+ *  A double-ended queue: elements in fixed blocks of BlockSize, found through a
+ *  map of pointers to the blocks. Adding or removing at either end never moves an
+ *  element, and growing only reallocates the map, never the elements, so a deque
+ *  suits large FIFO buffers. References to elements stay valid across push and
+ *  pop at the ends; iterators do not.
+ *
+ *  Blocks and the map come from Allocator through allocator_traits, one block at
+ *  a time; a block is given back as soon as its last element is removed. A deque
+ *  that never held an element has allocated nothing.
+ *
+ *  Its iterators are segmented (see segmented_iterator_traits): mystd::copy, fill,
+ *  for_each and the deque itself handle a range one block at a time.
+*/
+template<typename T, typename Allocator = allocator<T>, size_t BlockSize = detail::deque_block_size<T>::value>
+class deque
+{
+    static_assert(BlockSize != 0, "a deque block needs room for at least one element");
+
+    typedef allocator_traits<Allocator> alloc_traits;
+    typedef allocator_traits<typename alloc_traits::template rebind_alloc<typename alloc_traits::pointer>> map_traits;
+    typedef typename map_traits::allocator_type map_allocator;
+    typedef typename map_traits::pointer map_pointer;
+    typedef typename alloc_traits::pointer block_pointer;
+    typedef block_pointer* node_pointer;
+
+public:
+    typedef T                                       value_type;
+    typedef Allocator                               allocator_type;
+    typedef typename alloc_traits::size_type        size_type;
+    typedef typename alloc_traits::difference_type  difference_type;
+    typedef T&                                      reference;
+    typedef const T&                                const_reference;
+    typedef typename alloc_traits::pointer          pointer;
+    typedef typename alloc_traits::const_pointer    const_pointer;
+    typedef detail::deque_iterator<T, block_pointer, BlockSize, false> iterator;
+    typedef detail::deque_iterator<T, block_pointer, BlockSize, true>  const_iterator;
+    typedef std::reverse_iterator<iterator>         reverse_iterator;
+    typedef std::reverse_iterator<const_iterator>   const_reverse_iterator;
+
+    static constexpr size_type block_size = BlockSize;
+
+private:
+    compressed_pair<map_pointer, allocator_type> map_; // the map and the allocator
+    size_type map_size_;                               // slots in the map
+    iterator start_;                                   // the first element
+    iterator finish_;                                  // one past the last, always inside a block
+
+    static constexpr size_type initial_map_size = 8;
+
+    template<typename It>
+    using if_input_iterator = enable_if_t<is_convertible<iterator_category_t<It>, input_iterator_tag>::value>;
+
+public:
+    deque() noexcept(noexcept(Allocator()))
+        : map_(map_pointer(), Allocator()), map_size_(0), start_(), finish_() {}
+
+    explicit deque(const Allocator& alloc) noexcept
+        : map_(map_pointer(), alloc), map_size_(0), start_(), finish_() {}
+
+    explicit deque(size_type count, const Allocator& alloc = Allocator())
+        : deque(alloc)
+    {
+        construct_back(count, [this](T* first, T* last) { uninitialized_value_construct(first, last, get_alloc()); });
+    }
+
+    deque(size_type count, const T& value, const Allocator& alloc = Allocator())
+        : deque(alloc)
+    {
+        construct_back(count, [&](T* first, T* last) { uninitialized_fill(first, last, value, get_alloc()); });
+    }
+
+    template<typename InputIt, typename = if_input_iterator<InputIt>>
+    deque(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+        : deque(alloc)
+    {
+        append_range(first, last, iterator_category_t<InputIt>());
+    }
+
+    deque(const deque& other)
+        : deque(other, alloc_traits::select_on_container_copy_construction(other.get_alloc())) {}
+
+    deque(const deque& other, const Allocator& alloc)
+        : deque(alloc)
+    {
+        append_range(other.begin(), other.end(), random_access_iterator_tag());
+    }
+
+    deque(deque&& other) noexcept
+        : map_(other.map(), std::move(other.get_alloc())), map_size_(other.map_size_),
+        start_(other.start_), finish_(other.finish_)
+    {
+        other.reset();
+    }
+
+    deque(deque&& other, const Allocator& alloc)
+        : deque(alloc)
+    {
+        if(get_alloc() == other.get_alloc())
+            take(other);
+        else
+            append_range(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()),
+                random_access_iterator_tag());
+    }
+
+    deque(initializer_list<T> init, const Allocator& alloc = Allocator())
+        : deque(alloc)
+    {
+        append_range(init.begin(), init.end(), random_access_iterator_tag());
+    }
+
+    ~deque()
+    {
+        destroy_range(start_, finish_);
+        release();
+    }
+
+    deque& operator=(const deque& other)
+    {
+        if(this != &other)
+        {
+            copy_alloc(other.get_alloc(),
+                typename alloc_traits::propagate_on_container_copy_assignment());
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    deque& operator=(deque&& other)
+        noexcept(alloc_traits::propagate_on_container_move_assignment::value
+            || alloc_traits::is_always_equal::value)
+    {
+        if(this != &other)
+            move_assign(other, integral_constant<bool,
+                alloc_traits::propagate_on_container_move_assignment::value
+                || alloc_traits::is_always_equal::value>());
+        return *this;
+    }
+
+    deque& operator=(initializer_list<T> init)
+    {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    void assign(size_type count, const T& value)
+    {
+        if(count <= size())
+        {
+            mystd::fill(begin(), begin() + difference_type(count), value);
+            erase_at_end(begin() + difference_type(count));
+        }
+        else
+        {
+            mystd::fill(begin(), end(), value);
+            construct_back(count - size(), [&](T* first, T* last) { uninitialized_fill(first, last, value, get_alloc()); });
+        }
+    }
+
+    template<typename InputIt, typename = if_input_iterator<InputIt>>
+    void assign(InputIt first, InputIt last)
+    {
+        assign_range(first, last, iterator_category_t<InputIt>());
+    }
+
+    void assign(initializer_list<T> init)
+    {
+        assign(init.begin(), init.end());
+    }
+
+    allocator_type get_allocator() const noexcept { return get_alloc(); }
+
+
+    // element access
+
+    reference at(size_type pos)
+    {
+        check_index(pos);
+        return start_[difference_type(pos)];
+    }
+    const_reference at(size_type pos) const
+    {
+        check_index(pos);
+        return start_[difference_type(pos)];
+    }
+
+    reference operator[](size_type pos) noexcept { return start_[difference_type(pos)]; }
+    const_reference operator[](size_type pos) const noexcept { return start_[difference_type(pos)]; }
+
+    reference front() noexcept { return *start_; }
+    const_reference front() const noexcept { return *start_; }
+    reference back() noexcept { return *(finish_ - 1); }
+    const_reference back() const noexcept { return *(finish_ - 1); }
+
+
+    // iterators
+
+    iterator begin() noexcept { return start_; }
+    const_iterator begin() const noexcept { return start_; }
+    const_iterator cbegin() const noexcept { return start_; }
+    iterator end() noexcept { return finish_; }
+    const_iterator end() const noexcept { return finish_; }
+    const_iterator cend() const noexcept { return finish_; }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+
+    // capacity
+
+    bool empty() const noexcept { return start_ == finish_; }
+    size_type size() const noexcept { return size_type(finish_ - start_); }
+
+    size_type max_size() const noexcept
+    {
+        size_type by_alloc = alloc_traits::max_size(get_alloc());
+        size_type by_diff = size_type(std::numeric_limits<difference_type>::max()) / sizeof(T);
+        return by_alloc < by_diff ? by_alloc : by_diff;
+    }
+
+    // Blocks are freed as they empty, so only the map can shrink, or go with the last block.
+    void shrink_to_fit()
+    {
+        if(empty())
+        {
+            release();
+        }
+        else
+        {
+            size_type nodes = size_type(finish_.node_ - start_.node_) + 1;
+            if(nodes < map_size_)
+                move_map(allocate_map(nodes), 0, false);
+        }
+    }
+
+
+    // modifiers
+
+    void clear() noexcept
+    {
+        erase_at_end(start_);
+    }
+
+    iterator insert(const_iterator pos, const T& value)
+    {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, T&& value)
+    {
+        return emplace(pos, std::move(value));
+    }
+
+    iterator insert(const_iterator pos, size_type count, const T& value)
+    {
+        // the new elements are built before any element moves, so value may be one of them
+        return insert_construct(pos - cbegin(), count,
+            [&](T* first, T* last) { uninitialized_fill(first, last, value, get_alloc()); });
+    }
+
+    template<typename InputIt, typename = if_input_iterator<InputIt>>
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        return insert_range(pos - cbegin(), first, last, iterator_category_t<InputIt>());
+    }
+
+    iterator insert(const_iterator pos, initializer_list<T> init)
+    {
+        return insert_range(pos - cbegin(), init.begin(), init.end(), random_access_iterator_tag());
+    }
+
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        difference_type off = pos - cbegin();
+        if(off == 0)
+        {
+            emplace_front(std::forward<Args>(args)...);
+            return begin();
+        }
+        if(size_type(off) == size())
+        {
+            emplace_back(std::forward<Args>(args)...);
+            return end() - 1;
+        }
+
+        // args may refer to an element that is about to move; the nearer end makes room
+        T tmp(std::forward<Args>(args)...);
+        if(size_type(off) < size() / 2)
+        {
+            emplace_front(std::move(front()));
+            mystd::move(begin() + 2, begin() + (off + 1), begin() + 1);
+        }
+        else
+        {
+            emplace_back(std::move(back()));
+            mystd::move_backward(begin() + off, end() - 2, end() - 1);
+        }
+        iterator p = begin() + off;
+        *p = std::move(tmp);
+        return p;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    // Moves whichever side of the gap is shorter.
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        difference_type off = first - cbegin();
+        difference_type count = last - first;
+        if(count != 0)
+        {
+            iterator f = begin() + off;
+            iterator l = f + count;
+            if(size_type(off) < (size() - size_type(count)) / 2)
+                erase_at_begin(mystd::move_backward(begin(), f, l));
+            else
+                erase_at_end(mystd::move(l, end(), f));
+        }
+        return begin() + off;
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if(finish_.cur_ != nullptr && finish_.cur_ != finish_.first_ + (BlockSize - 1))
+        {
+            alloc_traits::construct(get_alloc(), finish_.cur_, std::forward<Args>(args)...);
+            return *finish_.cur_++;
+        }
+        else
+        {
+            // the last slot of the block: the end moves on to a new one
+            reserve_back(1);
+            try
+            {
+                alloc_traits::construct(get_alloc(), finish_.cur_, std::forward<Args>(args)...);
+            }
+            catch(...)
+            {
+                free_blocks_after(finish_.node_);
+                throw;
+            }
+            ++finish_;
+            return back();
+        }
+    }
+
+    void push_front(const T& value)
+    {
+        emplace_front(value);
+    }
+
+    void push_front(T&& value)
+    {
+        emplace_front(std::move(value));
+    }
+
+    template<typename... Args>
+    reference emplace_front(Args&&... args)
+    {
+        if(start_.cur_ != start_.first_)
+        {
+            alloc_traits::construct(get_alloc(), start_.cur_ - 1, std::forward<Args>(args)...);
+            return *--start_.cur_;
+        }
+        else
+        {
+            iterator new_start = reserve_front(1);
+            try
+            {
+                alloc_traits::construct(get_alloc(), new_start.cur_, std::forward<Args>(args)...);
+            }
+            catch(...)
+            {
+                free_blocks_before(start_.node_);
+                throw;
+            }
+            start_ = new_start;
+            return front();
+        }
+    }
+
+    void pop_back() noexcept
+    {
+        if(finish_.cur_ == finish_.first_)
+        {
+            free_block(finish_.node_);
+            finish_.set_node(finish_.node_ - 1);
+            finish_.cur_ = finish_.first_ + BlockSize;
+        }
+        --finish_.cur_;
+        alloc_traits::destroy(get_alloc(), finish_.cur_);
+    }
+
+    void pop_front() noexcept
+    {
+        alloc_traits::destroy(get_alloc(), start_.cur_);
+        if(++start_.cur_ == start_.first_ + BlockSize)
+        {
+            free_block(start_.node_);
+            start_.set_node(start_.node_ + 1);
+            start_.cur_ = start_.first_;
+        }
+    }
+
+    void resize(size_type count)
+    {
+        if(count <= size())
+            erase_at_end(begin() + difference_type(count));
+        else
+            construct_back(count - size(), [this](T* first, T* last) { uninitialized_value_construct(first, last, get_alloc()); });
+    }
+
+    void resize(size_type count, const T& value)
+    {
+        if(count <= size())
+            erase_at_end(begin() + difference_type(count));
+        else
+            construct_back(count - size(), [&](T* first, T* last) { uninitialized_fill(first, last, value, get_alloc()); });
+    }
+
+    void swap(deque& other)
+        noexcept(alloc_traits::propagate_on_container_swap::value || alloc_traits::is_always_equal::value)
+    {
+        swap_alloc(other, typename alloc_traits::propagate_on_container_swap());
+        using std::swap;
+        swap(map(), other.map());
+        swap(map_size_, other.map_size_);
+        swap(start_, other.start_);
+        swap(finish_, other.finish_);
+    }
+
+private:
+    map_pointer& map() noexcept { return map_.first(); }
+    const map_pointer& map() const noexcept { return map_.first(); }
+    allocator_type& get_alloc() noexcept { return map_.second(); }
+    const allocator_type& get_alloc() const noexcept { return map_.second(); }
+
+    node_pointer map_first() noexcept { return to_address(map()); }
+    node_pointer map_last() noexcept { return map_first() + map_size_; }
+
+    void check_index(size_type pos) const
+    {
+        if(pos >= size())
+            throw std::out_of_range("deque::at");
+    }
+
+    // no map, no blocks
+    void reset() noexcept
+    {
+        map() = map_pointer();
+        map_size_ = 0;
+        start_ = finish_ = iterator();
+    }
+
+    // Frees the blocks and the map, whose elements are already destroyed.
+    void release() noexcept
+    {
+        if(map_size_ == 0)
+            return;
+        for(node_pointer node = start_.node_; node <= finish_.node_; ++node)
+            alloc_traits::deallocate(get_alloc(), *node, BlockSize);
+        deallocate_map(map(), map_size_);
+        reset();
+    }
+
+    // the map: its slots are null where there is no block
+
+    allocation_result<map_pointer, size_type> allocate_map(size_type count)
+    {
+        map_allocator alloc(get_alloc());
+        auto r = map_traits::allocate_at_least(alloc, count);
+        mystd::uninitialized_value_construct(to_address(r.ptr), to_address(r.ptr) + r.count);
+        return r;
+    }
+
+    void deallocate_map(map_pointer p, size_type count) noexcept
+    {
+        mystd::destroy(to_address(p), to_address(p) + count);
+        map_allocator alloc(get_alloc());
+        map_traits::deallocate(alloc, p, count);
+    }
+
+    // A map with one empty block in its middle, for the first element.
+    void init_map()
+    {
+        auto r = allocate_map(initial_map_size);
+        node_pointer node = to_address(r.ptr) + r.count / 2;
+        try
+        {
+            *node = alloc_traits::allocate(get_alloc(), BlockSize);
+        }
+        catch(...)
+        {
+            deallocate_map(r.ptr, r.count);
+            throw;
+        }
+        map() = r.ptr;
+        map_size_ = r.count;
+        start_.set_node(node);
+        start_.cur_ = start_.first_;
+        finish_ = start_;
+    }
+
+    /**
+     *  Moves the used slots to new_map, or to the middle of this map if new_map is
+     *  null, leaving room for nodes_to_add more at the front or the back. Only the
+     *  block pointers move; the blocks and their elements stay where they are.
+    */
+    void move_map(allocation_result<map_pointer, size_type> new_map, size_type nodes_to_add, bool at_front) noexcept
+    {
+        node_pointer old_first = start_.node_;
+        node_pointer old_last = finish_.node_ + 1;
+        size_type old_nodes = size_type(old_last - old_first);
+        size_type new_nodes = old_nodes + nodes_to_add;
+        node_pointer new_first;
+        if(new_map.ptr == map_pointer())
+        {
+            new_first = map_first() + (map_size_ - new_nodes) / 2 + (at_front ? nodes_to_add : 0);
+            if(new_first < old_first)
+            {
+                std::copy(old_first, old_last, new_first);
+                std::fill(std::max(new_first + old_nodes, old_first), old_last, block_pointer());
+            }
+            else
+            {
+                std::copy_backward(old_first, old_last, new_first + old_nodes);
+                std::fill(old_first, std::min(new_first, old_last), block_pointer());
+            }
+        }
+        else
+        {
+            new_first = to_address(new_map.ptr) + (new_map.count - new_nodes) / 2 + (at_front ? nodes_to_add : 0);
+            std::copy(old_first, old_last, new_first);
+            deallocate_map(map(), map_size_);
+            map() = new_map.ptr;
+            map_size_ = new_map.count;
+        }
+        start_.set_node(new_first);
+        finish_.set_node(new_first + (old_nodes - 1));
+    }
+
+    // Makes room in the map for nodes_to_add more blocks at the front or the back.
+    void grow_map(size_type nodes_to_add, bool at_front)
+    {
+        size_type new_nodes = size_type(finish_.node_ - start_.node_) + 1 + nodes_to_add;
+        if(map_size_ > 2 * new_nodes)
+        {
+            // there is plenty of room, the blocks just drifted to one end
+            move_map({ map_pointer(), 0 }, nodes_to_add, at_front);
+        }
+        else
+        {
+            size_type grow = map_size_ > nodes_to_add ? map_size_ : nodes_to_add;
+            move_map(allocate_map(map_size_ + grow + 2), nodes_to_add, at_front);
+        }
+    }
+
+    // the blocks
+
+    void free_block(node_pointer node) noexcept
+    {
+        alloc_traits::deallocate(get_alloc(), *node, BlockSize);
+        *node = block_pointer();
+    }
+
+    // Frees the blocks reserved after node, or before it, that hold no element.
+    void free_blocks_after(node_pointer node) noexcept
+    {
+        for(++node; node != map_last() && *node != block_pointer(); ++node)
+            free_block(node);
+    }
+
+    void free_blocks_before(node_pointer node) noexcept
+    {
+        for(; node != map_first() && node[-1] != block_pointer(); --node)
+            free_block(node - 1);
+    }
+
+    /**
+     *  Allocates the blocks count more elements need after the last one, and
+     *  returns what will be the end. On failure nothing has changed but the map.
+    */
+    iterator reserve_back(size_type count)
+    {
+        if(count > max_size() - size())
+            throw std::length_error("deque: too many elements");
+        if(map_size_ == 0)
+            init_map();
+        size_type vacant = BlockSize - 1 - size_type(finish_.cur_ - finish_.first_);
+        if(count > vacant)
+        {
+            size_type blocks = (count - vacant + BlockSize - 1) / BlockSize;
+            if(blocks + 1 > size_type(map_last() - finish_.node_))
+                grow_map(blocks, false);
+            try
+            {
+                for(size_type i = 1; i <= blocks; ++i)
+                    finish_.node_[i] = alloc_traits::allocate(get_alloc(), BlockSize);
+            }
+            catch(...)
+            {
+                free_blocks_after(finish_.node_);
+                throw;
+            }
+        }
+        return finish_ + difference_type(count);
+    }
+
+    // The same before the first element; returns what will be the beginning.
+    iterator reserve_front(size_type count)
+    {
+        if(count > max_size() - size())
+            throw std::length_error("deque: too many elements");
+        if(map_size_ == 0)
+            init_map();
+        size_type vacant = size_type(start_.cur_ - start_.first_);
+        if(count > vacant)
+        {
+            size_type blocks = (count - vacant + BlockSize - 1) / BlockSize;
+            if(blocks > size_type(start_.node_ - map_first()))
+                grow_map(blocks, true);
+            try
+            {
+                for(size_type i = 1; i <= blocks; ++i)
+                    *(start_.node_ - i) = alloc_traits::allocate(get_alloc(), BlockSize);
+            }
+            catch(...)
+            {
+                free_blocks_before(start_.node_);
+                throw;
+            }
+        }
+        return start_ - difference_type(count);
+    }
+
+    /**
+     *  Adds count elements after the last one, built by construct(first, last) one
+     *  block at a time, in order. If it throws, the deque is left as it was.
+    */
+    template<typename Construct>
+    void construct_back(size_type count, Construct construct)
+    {
+        if(count == 0)
+            return;
+        iterator new_finish = reserve_back(count);
+        iterator built = finish_;
+        try
+        {
+            mystd::for_each_segment(finish_, new_finish, [&](T* first, T* last)
+            {
+                construct(first, last);
+                built += last - first;
+            });
+        }
+        catch(...)
+        {
+            destroy_range(finish_, built);
+            free_blocks_after(finish_.node_);
+            throw;
+        }
+        finish_ = new_finish;
+    }
+
+    // The same before the first element.
+    template<typename Construct>
+    void construct_front(size_type count, Construct construct)
+    {
+        if(count == 0)
+            return;
+        iterator new_start = reserve_front(count);
+        iterator built = new_start;
+        try
+        {
+            mystd::for_each_segment(new_start, start_, [&](T* first, T* last)
+            {
+                construct(first, last);
+                built += last - first;
+            });
+        }
+        catch(...)
+        {
+            destroy_range(new_start, built);
+            free_blocks_before(start_.node_);
+            throw;
+        }
+        start_ = new_start;
+    }
+
+    void destroy_range(iterator first, iterator last) noexcept
+    {
+        mystd::for_each_segment(first, last, [this](T* f, T* l) { mystd::destroy(f, l, get_alloc()); });
+    }
+
+    // Destroys the elements before pos and frees the blocks they leave empty.
+    void erase_at_begin(iterator pos) noexcept
+    {
+        destroy_range(start_, pos);
+        for(node_pointer node = start_.node_; node != pos.node_; ++node)
+            free_block(node);
+        start_ = pos;
+    }
+
+    // Destroys the elements from pos on and frees the blocks they leave empty.
+    void erase_at_end(iterator pos) noexcept
+    {
+        destroy_range(pos, finish_);
+        for(node_pointer node = finish_.node_; node != pos.node_; --node)
+            free_block(node);
+        finish_ = pos;
+    }
+
+    // copies [first, ...) into the blocks it is called on, in order
+    template<typename ForwardIt>
+    auto copy_from(ForwardIt first)
+    {
+        return [this, first](T* d_first, T* d_last) mutable
+        {
+            ForwardIt mid = first;
+            std::advance(mid, d_last - d_first);
+            uninitialized_copy(first, mid, d_first, get_alloc());
+            first = mid;
+        };
+    }
+
+    template<typename InputIt>
+    void append_range(InputIt first, InputIt last, input_iterator_tag)
+    {
+        for(; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    template<typename ForwardIt>
+    void append_range(ForwardIt first, ForwardIt last, forward_iterator_tag)
+    {
+        construct_back(size_type(std::distance(first, last)), copy_from(first));
+    }
+
+    template<typename InputIt>
+    void assign_range(InputIt first, InputIt last, input_iterator_tag)
+    {
+        iterator cur = begin();
+        for(; first != last && cur != end(); ++first, (void)++cur)
+            *cur = *first;
+        if(first == last)
+            erase_at_end(cur);
+        else
+            append_range(first, last, input_iterator_tag());
+    }
+
+    template<typename ForwardIt>
+    void assign_range(ForwardIt first, ForwardIt last, forward_iterator_tag)
+    {
+        size_type count = size_type(std::distance(first, last));
+        if(count <= size())
+        {
+            erase_at_end(mystd::copy(first, last, begin()));
+        }
+        else
+        {
+            ForwardIt mid = first;
+            std::advance(mid, size());
+            mystd::copy(first, mid, begin());
+            construct_back(count - size(), copy_from(mid));
+        }
+    }
+
+    /**
+     *  Inserts count elements at off, built by construct(first, last) at the nearer
+     *  end of the deque and then rotated into place.
+    */
+    template<typename Construct>
+    iterator insert_construct(difference_type off, size_type count, Construct construct)
+    {
+        if(size_type(off) < size() / 2)
+        {
+            construct_front(count, construct);
+            std::rotate(begin(), begin() + difference_type(count), begin() + (difference_type(count) + off));
+        }
+        else
+        {
+            difference_type old_size = difference_type(size());
+            construct_back(count, construct);
+            std::rotate(begin() + off, begin() + old_size, end());
+        }
+        return begin() + off;
+    }
+
+    template<typename InputIt>
+    iterator insert_range(difference_type off, InputIt first, InputIt last, input_iterator_tag)
+    {
+        // single pass: append, then rotate into place
+        size_type old_size = size();
+        try
+        {
+            append_range(first, last, input_iterator_tag());
+        }
+        catch(...)
+        {
+            erase_at_end(begin() + difference_type(old_size));
+            throw;
+        }
+        std::rotate(begin() + off, begin() + difference_type(old_size), end());
+        return begin() + off;
+    }
+
+    template<typename ForwardIt>
+    iterator insert_range(difference_type off, ForwardIt first, ForwardIt last, forward_iterator_tag)
+    {
+        return insert_construct(off, size_type(std::distance(first, last)), copy_from(first));
+    }
+
+    // Takes the map and blocks of other, whose allocator can free them, into this deque with none.
+    void take(deque& other) noexcept
+    {
+        map() = other.map();
+        map_size_ = other.map_size_;
+        start_ = other.start_;
+        finish_ = other.finish_;
+        other.reset();
+    }
+
+    void swap_alloc(deque& other, true_type) noexcept
+    {
+        using std::swap;
+        swap(get_alloc(), other.get_alloc());
+    }
+    void swap_alloc(deque&, false_type) noexcept {}
+
+    void copy_alloc(const allocator_type& alloc, true_type)
+    {
+        if(get_alloc() != alloc)
+        {
+            // the old blocks belong to the old allocator
+            clear();
+            release();
+        }
+        get_alloc() = alloc;
+    }
+    void copy_alloc(const allocator_type&, false_type) {}
+
+    void move_assign(deque& other, true_type) noexcept
+    {
+        clear();
+        release();
+        move_alloc(other.get_alloc(), typename alloc_traits::propagate_on_container_move_assignment());
+        take(other);
+    }
+
+    void move_assign(deque& other, false_type)
+    {
+        if(get_alloc() == other.get_alloc())
+            move_assign(other, true_type());
+        else
+            assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+    }
+
+    void move_alloc(allocator_type& alloc, true_type) noexcept { get_alloc() = std::move(alloc); }
+    void move_alloc(allocator_type&, false_type) noexcept {}
+};
+
+template<typename T, typename Allocator, size_t BlockSize>
+constexpr typename deque<T, Allocator, BlockSize>::size_type deque<T, Allocator, BlockSize>::block_size;
+
+template<typename T, typename Allocator, size_t BlockSize>
+constexpr typename deque<T, Allocator, BlockSize>::size_type deque<T, Allocator, BlockSize>::initial_map_size;
+
+
+template<typename T, typename Alloc, size_t BlockSize>
+inline bool operator==(const deque<T, Alloc, BlockSize>& a, const deque<T, Alloc, BlockSize>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template<typename T, typename Alloc, size_t BlockSize>
+inline bool operator!=(const deque<T, Alloc, BlockSize>& a, const deque<T, Alloc, BlockSize>& b)
+{
+    return !(a == b);
+}
+
+template<typename T, typename Alloc, size_t BlockSize>
+inline bool operator<(const deque<T, Alloc, BlockSize>& a, const deque<T, Alloc, BlockSize>& b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template<typename T, typename Alloc, size_t BlockSize>
+inline bool operator>(const deque<T, Alloc, BlockSize>& a, const deque<T, Alloc, BlockSize>& b)
+{
+    return b < a;
+}
+
+template<typename T, typename Alloc, size_t BlockSize>
+inline bool operator<=(const deque<T, Alloc, BlockSize>& a, const deque<T, Alloc, BlockSize>& b)
+{
+    return !(b < a);
+}
+
+template<typename T, typename Alloc, size_t BlockSize>
+inline bool operator>=(const deque<T, Alloc, BlockSize>& a, const deque<T, Alloc, BlockSize>& b)
+{
+    return !(a < b);
+}
+
+template<typename T, typename Alloc, size_t BlockSize>
+inline void swap(deque<T, Alloc, BlockSize>& a, deque<T, Alloc, BlockSize>& b) noexcept(noexcept(a.swap(b)))
+{
+    a.swap(b);
+}
+
+// The map, two iterators into the heap and the allocator.
+template<typename T, typename Allocator, size_t BlockSize>
+struct is_trivially_relocatable<deque<T, Allocator, BlockSize>> : integral_constant<bool,
+    is_trivially_relocatable<typename allocator_traits<Allocator>::pointer>::value
+    && is_trivially_relocatable<Allocator>::value> {};
+
+MYSTD_NS_END
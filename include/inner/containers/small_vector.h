@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../mystd.h"
+#include "vector.h"
+
+#include <cstddef> // size_t
+
+
+MYSTD_NS_BEGIN
+
+/**
+ *  A vector that keeps its first N elements inside the object and only takes
+ *  storage from Allocator when more are added. A small_vector that never holds
+ *  more than N elements never allocates.
+ *
+ *  It runs on the same engine as vector, so growth, relocation and the exception
+ *  guarantees are the same. Once it has spilled to the heap it stays there until
+ *  shrink_to_fit() finds the elements fit inline again.
+ *
+ *  Moving or swapping inline elements moves them one by one: it invalidates
+ *  iterators to them and is only noexcept if T's move constructor is.
+*/
+template<typename T, size_t N, typename Allocator = allocator<T>, typename Growth = growth_factor<2, 1>>
+class small_vector : public detail::vector_base<T, Allocator, Growth, N>
+{
+    static_assert(N != 0, "small_vector needs room for at least one inline element, use vector");
+
+    typedef detail::vector_base<T, Allocator, Growth, N> base;
+
+public:
+    static constexpr size_t inline_capacity = N;
+
+    using base::base;
+
+    small_vector() = default;
+
+    small_vector& operator=(initializer_list<T> init)
+    {
+        this->assign(init);
+        return *this;
+    }
+};
+
+template<typename T, size_t N, typename Allocator, typename Growth>
+constexpr size_t small_vector<T, N, Allocator, Growth>::inline_capacity;
+
+MYSTD_NS_END
@@ -1,11 +1,18 @@
 #pragma once
 
 #include "../mystd.h"
+#include "../type_traits.h"
+#include "../compressed_pair.h"
 #include "../memory/allocators.h"
+#include "../memory/uninitialized.h"
 #include "../iterator.h"
 
 #include <initializer_list> // std::initializer_list is special to the compiler, we can't achieve it in namespace mystd. see doc/initializer_list_more.md
+#include <algorithm> // copy, move, move_backward, fill_n, rotate, equal, lexicographical_compare
 #include <cstddef> // size_t, ptrdiff_t
+#include <limits> // numeric_limits
+#include <stdexcept> // out_of_range, length_error
+#include <utility> // forward, move
 
 
 MYSTD_NS_BEGIN
@@ -15,25 +22,1031 @@ using std::size_t;
 using std::ptrdiff_t;
 
 
-template<typename T, typename Allocator = allocator<T>>
-class vector
+/**
+ *  Growth policy of vector: a full vector grows to capacity * Num / Den elements,
+ *  or to what the insertion needs if that is more. 2/1 gives the fewest
+ *  reallocations; 3/2 lets a freed buffer be reused by a later one and wastes less.
+*/
+template<size_t Num, size_t Den>
+struct growth_factor
 {
+    static_assert(Den != 0 && Num > Den, "the growth factor must be greater than 1");
+
+    template<typename Size>
+    static Size grow(Size capacity, Size needed, Size max) noexcept
+    {
+        Size next = capacity > max / Num * Den
+            ? max
+            : capacity / Den * Num + capacity % Den * Num / Den;
+        return next < needed ? needed : next;
+    }
+};
+
+
+namespace detail {
+
+// Room for N elements inside the container itself, used until they no longer fit.
+template<typename T, size_t N>
+class vector_inline_buffer
+{
+    union
+    {
+        T elements_[N];
+    };
+
+public:
+    vector_inline_buffer() noexcept {}
+    ~vector_inline_buffer() {}
+
+    T* inline_data() noexcept { return elements_; }
+};
+
+template<typename T>
+class vector_inline_buffer<T, 0>
+{
+public:
+    T* inline_data() noexcept { return nullptr; }
+};
+
+
+/**
+ *  The engine shared by vector and small_vector. It keeps up to N elements in an
+ *  inline buffer and moves them to storage from Allocator when they no longer fit.
+ *  With N == 0 the inline buffer is the null pointer and it is a plain vector.
+*/
+template<typename T, typename Allocator, typename Growth, size_t N>
+class vector_base : private vector_inline_buffer<T, N>
+{
+    typedef allocator_traits<Allocator> alloc_traits;
+
+public:
+    typedef T                                       value_type;
+    typedef Allocator                               allocator_type;
+    typedef typename alloc_traits::size_type        size_type;
+    typedef typename alloc_traits::difference_type  difference_type;
+    typedef T&                                      reference;
+    typedef const T&                                const_reference;
+    typedef typename alloc_traits::pointer          pointer;
+    typedef typename alloc_traits::const_pointer    const_pointer;
+    typedef T*                                      iterator;
+    typedef const T*                                const_iterator;
+    typedef std::reverse_iterator<iterator>         reverse_iterator;
+    typedef std::reverse_iterator<const_iterator>   const_reverse_iterator;
+
+private:
+    compressed_pair<pointer, allocator_type> first_; // first element and the allocator
+    pointer last_;                                   // one past the last element
+    pointer end_;                                    // one past the end of the storage
+
+    template<typename It>
+    using if_input_iterator = enable_if_t<is_convertible<iterator_category_t<It>, input_iterator_tag>::value>;
+
+    // elements are moved with memmove and their old copies forgotten, see is_trivially_relocatable
+    typedef integral_constant<bool, is_trivially_relocatable<T>::value
+        && !alloc_customizes_construct<Allocator, T, T&&>::value
+        && !alloc_customizes_destroy<Allocator, T>::value> relocate_bitwise;
+
+    // otherwise move if that cannot throw or is all there is, copy if not
+    typedef integral_constant<bool, is_nothrow_move_constructible<T>::value
+        || !is_copy_constructible<T>::value> relocate_by_move;
+
+    // moving the elements out of the inline buffer is all that can throw
+    static constexpr bool nothrow_take = N == 0 || relocate_bitwise::value || is_nothrow_move_constructible<T>::value;
+
+public:
+    vector_base() noexcept(noexcept(Allocator()))
+        : first_(pointer(), Allocator()), last_(), end_()
+    {
+        reset();
+    }
+
+    explicit vector_base(const Allocator& alloc) noexcept
+        : first_(pointer(), alloc), last_(), end_()
+    {
+        reset();
+    }
+
+    explicit vector_base(size_type count, const Allocator& alloc = Allocator())
+        : vector_base(alloc)
+    {
+        if(count != 0)
+        {
+            allocate(count);
+            uninitialized_value_construct(begin(), begin() + count, get_alloc());
+            last_ = first() + count;
+        }
+    }
+
+    vector_base(size_type count, const T& value, const Allocator& alloc = Allocator())
+        : vector_base(alloc)
+    {
+        if(count != 0)
+        {
+            allocate(count);
+            uninitialized_fill(begin(), begin() + count, value, get_alloc());
+            last_ = first() + count;
+        }
+    }
+
+    template<typename InputIt, typename = if_input_iterator<InputIt>>
+    vector_base(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+        : vector_base(alloc)
+    {
+        init_range(first, last, iterator_category_t<InputIt>());
+    }
+
+    vector_base(const vector_base& other)
+        : vector_base(other, alloc_traits::select_on_container_copy_construction(other.get_alloc())) {}
+
+    vector_base(const vector_base& other, const Allocator& alloc)
+        : vector_base(alloc)
+    {
+        init_range(other.begin(), other.end(), random_access_iterator_tag());
+    }
+
+    vector_base(vector_base&& other) noexcept(nothrow_take)
+        : first_(pointer(), std::move(other.get_alloc())), last_(), end_()
+    {
+        reset();
+        take(other);
+    }
+
+    vector_base(vector_base&& other, const Allocator& alloc)
+        : vector_base(alloc)
+    {
+        if(get_alloc() == other.get_alloc())
+            take(other);
+        else
+            init_range(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()),
+                random_access_iterator_tag());
+    }
+
+    vector_base(initializer_list<T> init, const Allocator& alloc = Allocator())
+        : vector_base(alloc)
+    {
+        init_range(init.begin(), init.end(), random_access_iterator_tag());
+    }
+
+    ~vector_base()
+    {
+        clear();
+        deallocate();
+    }
+
+    vector_base& operator=(const vector_base& other)
+    {
+        if(this != &other)
+        {
+            copy_alloc(other.get_alloc(),
+                typename alloc_traits::propagate_on_container_copy_assignment());
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    vector_base& operator=(vector_base&& other)
+        noexcept((alloc_traits::propagate_on_container_move_assignment::value
+            || alloc_traits::is_always_equal::value) && nothrow_take)
+    {
+        if(this != &other)
+            move_assign(other, integral_constant<bool,
+                alloc_traits::propagate_on_container_move_assignment::value
+                || alloc_traits::is_always_equal::value>());
+        return *this;
+    }
+
+    vector_base& operator=(initializer_list<T> init)
+    {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    void assign(size_type count, const T& value)
+    {
+        if(count > capacity())
+        {
+            vector_base tmp(count, value, get_alloc());
+            replace(tmp);
+        }
+        else if(count > size())
+        {
+            std::fill(begin(), end(), value);
+            uninitialized_fill(end(), begin() + count, value, get_alloc());
+            last_ = first() + count;
+        }
+        else
+        {
+            std::fill_n(begin(), count, value);
+            destroy_from(begin() + count);
+        }
+    }
+
+    template<typename InputIt, typename = if_input_iterator<InputIt>>
+    void assign(InputIt first, InputIt last)
+    {
+        assign_range(first, last, iterator_category_t<InputIt>());
+    }
+
+    void assign(initializer_list<T> init)
+    {
+        assign(init.begin(), init.end());
+    }
+
+    allocator_type get_allocator() const noexcept { return get_alloc(); }
+
+
+    // element access
+
+    reference at(size_type pos)
+    {
+        check_index(pos);
+        return begin()[pos];
+    }
+    const_reference at(size_type pos) const
+    {
+        check_index(pos);
+        return begin()[pos];
+    }
+
+    reference operator[](size_type pos) noexcept { return begin()[pos]; }
+    const_reference operator[](size_type pos) const noexcept { return begin()[pos]; }
+
+    reference front() noexcept { return *begin(); }
+    const_reference front() const noexcept { return *begin(); }
+    reference back() noexcept { return end()[-1]; }
+    const_reference back() const noexcept { return end()[-1]; }
+
+    T* data() noexcept { return begin(); }
+    const T* data() const noexcept { return begin(); }
+
+
+    // iterators
+
+    iterator begin() noexcept { return to_raw(first()); }
+    const_iterator begin() const noexcept { return to_raw(first()); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return to_raw(last_); }
+    const_iterator end() const noexcept { return to_raw(last_); }
+    const_iterator cend() const noexcept { return end(); }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+
+    // capacity
+
+    bool empty() const noexcept { return first() == last_; }
+    size_type size() const noexcept { return size_type(end() - begin()); }
+    size_type capacity() const noexcept { return size_type(to_raw(end_) - begin()); }
+
+    size_type max_size() const noexcept
+    {
+        size_type by_alloc = alloc_traits::max_size(get_alloc());
+        size_type by_diff = size_type(std::numeric_limits<difference_type>::max()) / sizeof(T);
+        return by_alloc < by_diff ? by_alloc : by_diff;
+    }
+
+    void reserve(size_type new_cap)
+    {
+        if(new_cap > max_size())
+            throw std::length_error("vector::reserve");
+        if(new_cap > capacity())
+            reallocate(new_cap);
+    }
+
+    void shrink_to_fit()
+    {
+        if(first() != inline_first() && size() < capacity())
+            reallocate(size());
+    }
+
+
+    // modifiers
+
+    void clear() noexcept
+    {
+        destroy_from(begin());
+    }
+
+    iterator insert(const_iterator pos, const T& value)
+    {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, T&& value)
+    {
+        return emplace(pos, std::move(value));
+    }
+
+    iterator insert(const_iterator pos, size_type count, const T& value)
+    {
+        size_type off = size_type(pos - cbegin());
+        if(count == 0)
+            return begin() + off;
+        if(count > size_type(end_ - last_))
+        {
+            size_type new_cap = grow_to(size() + count);
+            reallocate_insert(new_cap, off, count,
+                [&](T* d) { uninitialized_fill(d, d + count, value, get_alloc()); });
+            return begin() + off;
+        }
+        T copy(value); // value may be an element that is about to move
+        insert_fill(relocate_bitwise(), begin() + off, count, copy);
+        return begin() + off;
+    }
+
+    template<typename InputIt, typename = if_input_iterator<InputIt>>
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        return insert_range(pos, first, last, iterator_category_t<InputIt>());
+    }
+
+    iterator insert(const_iterator pos, initializer_list<T> init)
+    {
+        return insert_range(pos, init.begin(), init.end(), random_access_iterator_tag());
+    }
+
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        size_type off = size_type(pos - cbegin());
+        if(last_ == end_)
+        {
+            reallocate_insert(grow_to(size() + 1), off, 1,
+                [&](T* d) { alloc_traits::construct(get_alloc(), d, std::forward<Args>(args)...); });
+        }
+        else if(off == size())
+        {
+            alloc_traits::construct(get_alloc(), end(), std::forward<Args>(args)...);
+            ++last_;
+        }
+        else
+        {
+            insert_one(relocate_bitwise(), begin() + off, std::forward<Args>(args)...);
+        }
+        return begin() + off;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        T* p = begin() + (first - cbegin());
+        if(first != last)
+            erase_range(relocate_bitwise(), p, begin() + (last - cbegin()));
+        return p;
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if(last_ != end_)
+        {
+            alloc_traits::construct(get_alloc(), end(), std::forward<Args>(args)...);
+            ++last_;
+        }
+        else
+        {
+            reallocate_insert(grow_to(size() + 1), size(), 1,
+                [&](T* d) { alloc_traits::construct(get_alloc(), d, std::forward<Args>(args)...); });
+        }
+        return back();
+    }
+
+    void pop_back() noexcept
+    {
+        --last_;
+        alloc_traits::destroy(get_alloc(), end());
+    }
+
+    void resize(size_type count)
+    {
+        if(count <= size())
+            destroy_from(begin() + count);
+        else
+            append(count - size(), [this](T* first, T* last) { uninitialized_value_construct(first, last, get_alloc()); });
+    }
+
+    void resize(size_type count, const T& value)
+    {
+        if(count <= size())
+            destroy_from(begin() + count);
+        else
+            append(count - size(), [&](T* first, T* last) { uninitialized_fill(first, last, value, get_alloc()); });
+    }
+
+    /**
+     *  Like resize(count), but new elements are default-initialized instead of
+     *  value-initialized: if T is trivially default constructible they are left
+     *  as the memory was, for the caller to overwrite, and no pass over them is
+     *  made. (An allocator with its own construct still value-initializes.)
+    */
+    void resize_for_overwrite(size_type count)
+    {
+        if(count <= size())
+            destroy_from(begin() + count);
+        else
+            append_uninit(count - size());
+    }
+
+    // Appends count default-initialized elements, as resize_for_overwrite, and returns the first of them.
+    iterator append_uninit(size_type count)
+    {
+        size_type off = size();
+        append(count, [this](T* first, T* last) { uninitialized_default_construct(first, last, get_alloc()); });
+        return begin() + off;
+    }
+
+    void swap(vector_base& other)
+        noexcept((alloc_traits::propagate_on_container_swap::value
+            || alloc_traits::is_always_equal::value) && nothrow_take)
+    {
+        swap_alloc(other, typename alloc_traits::propagate_on_container_swap());
+        if(N == 0 || (first() != inline_first() && other.first() != other.inline_first()))
+        {
+            using std::swap;
+            swap(first(), other.first());
+            swap(last_, other.last_);
+            swap(end_, other.end_);
+        }
+        else
+        {
+            // inline elements cannot trade places by pointer
+            vector_base tmp(std::move(other));
+            other.clear();
+            other.deallocate();
+            other.take(*this);
+            clear();
+            deallocate();
+            take(tmp);
+        }
+    }
+
+private:
+    pointer& first() noexcept { return first_.first(); }
+    const pointer& first() const noexcept { return first_.first(); }
+    allocator_type& get_alloc() noexcept { return first_.second(); }
+    const allocator_type& get_alloc() const noexcept { return first_.second(); }
+
+    static T* to_raw(const pointer& p) noexcept
+    {
+        return p == pointer() ? nullptr : to_address(p);
+    }
+
+    pointer inline_first() noexcept
+    {
+        return inline_first(integral_constant<bool, N == 0>());
+    }
+    pointer inline_first(true_type) noexcept
+    {
+        return pointer();
+    }
+    pointer inline_first(false_type) noexcept
+    {
+        return pointer_traits<pointer>::pointer_to(*this->inline_data());
+    }
+
+    // empty, on the inline buffer
+    void reset() noexcept
+    {
+        first() = last_ = end_ = inline_first();
+        end_ += N;
+    }
+
+    // Storage for count elements: the inline buffer if they fit, otherwise from the allocator.
+    // Never called for the inline buffer while it holds elements.
+    allocation_result<pointer, size_type> storage_for(size_type count)
+    {
+        if(count <= N)
+            return { inline_first(), N };
+        return alloc_traits::allocate_at_least(get_alloc(), count);
+    }
+
+    void free_storage(const allocation_result<pointer, size_type>& r) noexcept
+    {
+        if(r.ptr != inline_first())
+            alloc_traits::deallocate(get_alloc(), r.ptr, r.count);
+    }
+
+    void check_index(size_type pos) const
+    {
+        if(pos >= size())
+            throw std::out_of_range("vector::at");
+    }
+
+    // capacity for a vector that needs room for `needed` elements
+    size_type grow_to(size_type needed) const
+    {
+        size_type max = max_size();
+        if(needed > max || needed < size())
+            throw std::length_error("vector: too many elements");
+        return Growth::grow(capacity(), needed, max);
+    }
+
+    // empty storage only
+    void allocate(size_type count)
+    {
+        if(count > max_size())
+            throw std::length_error("vector: too many elements");
+        auto r = storage_for(count);
+        first() = last_ = r.ptr;
+        end_ = r.ptr + r.count;
+    }
+
+    // empty storage only; back to the inline buffer
+    void deallocate() noexcept
+    {
+        if(first() != inline_first())
+        {
+            alloc_traits::deallocate(get_alloc(), first(), capacity());
+            reset();
+        }
+    }
+
+    void destroy_from(T* new_end) noexcept
+    {
+        mystd::destroy(new_end, end(), get_alloc());
+        last_ = first() + (new_end - begin());
+    }
+
+    // Moves [first, last) into raw memory at d, see relocate_bitwise and relocate_by_move.
+    // Unless the move was bitwise, the old elements are still there to destroy.
+    T* relocate(T* first, T* last, T* d)
+    {
+        return relocate(first, last, d, relocate_bitwise(), relocate_by_move());
+    }
+    template<typename ByMove>
+    T* relocate(T* first, T* last, T* d, true_type, ByMove)
+    {
+        return mystd::uninitialized_relocate(first, last, d);
+    }
+    T* relocate(T* first, T* last, T* d, false_type, true_type)
+    {
+        return uninitialized_move(first, last, d, get_alloc());
+    }
+    T* relocate(T* first, T* last, T* d, false_type, false_type)
+    {
+        return uninitialized_copy(first, last, d, get_alloc());
+    }
+
+    // Ends the old elements after relocate() moved all of them.
+    void drop_relocated(true_type) noexcept { last_ = first(); }
+    void drop_relocated(false_type) noexcept { clear(); }
+
+    // Takes the new storage and frees the old one, whose elements are already relocated.
+    void adopt(pointer new_first, size_type new_size, size_type new_cap) noexcept
+    {
+        drop_relocated(relocate_bitwise());
+        deallocate();
+        first() = new_first;
+        last_ = new_first + new_size;
+        end_ = new_first + new_cap;
+    }
+
+    void reallocate(size_type new_cap)
+    {
+        auto r = storage_for(new_cap);
+        try
+        {
+            relocate(begin(), end(), to_raw(r.ptr));
+        }
+        catch(...)
+        {
+            free_storage(r);
+            throw;
+        }
+        adopt(r.ptr, size(), r.count);
+    }
+
+    /**
+     *  Reallocates to new_cap and leaves a gap of count elements at off, built by
+     *  construct(gap). The gap is built first, so it may copy from the old elements;
+     *  if anything throws, the vector is left as it was.
+    */
+    template<typename Construct>
+    void reallocate_insert(size_type new_cap, size_type off, size_type count, Construct construct)
+    {
+        auto r = storage_for(new_cap);
+        T* d = to_raw(r.ptr);
+        T* gap = d + off;
+        bool gap_built = false;
+        T* head_end = d;
+        try
+        {
+            construct(gap);
+            gap_built = true;
+            head_end = relocate(begin(), begin() + off, d);
+            relocate(begin() + off, end(), gap + count);
+        }
+        catch(...)
+        {
+            if(gap_built)
+                mystd::destroy(gap, gap + count, get_alloc());
+            if(head_end != d)
+                mystd::destroy(d, head_end, get_alloc());
+            free_storage(r);
+            throw;
+        }
+        adopt(r.ptr, size() + count, r.count);
+    }
+
+    // Appends count elements built by construct(first, last).
+    template<typename Construct>
+    void append(size_type count, Construct construct)
+    {
+        if(count <= size_type(end_ - last_))
+        {
+            construct(end(), end() + count);
+            last_ += count;
+        }
+        else
+        {
+            size_type old_size = size();
+            reallocate_insert(grow_to(old_size + count), old_size, count,
+                [&](T* d) { construct(d, d + count); });
+        }
+    }
+
+    // Only called on an empty vector whose constructor already ran, so the destructor cleans up after a throw.
+    template<typename InputIt>
+    void init_range(InputIt first, InputIt last, input_iterator_tag)
+    {
+        for(; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    template<typename ForwardIt>
+    void init_range(ForwardIt first, ForwardIt last, forward_iterator_tag)
+    {
+        size_type count = size_type(std::distance(first, last));
+        if(count == 0)
+            return;
+        allocate(count);
+        uninitialized_copy(first, last, begin(), get_alloc());
+        last_ = first_.first() + count;
+    }
+
+    template<typename InputIt>
+    void assign_range(InputIt first, InputIt last, input_iterator_tag)
+    {
+        T* cur = begin();
+        for(; first != last && cur != end(); ++first, (void)++cur)
+            *cur = *first;
+        if(first == last)
+            destroy_from(cur);
+        else
+            for(; first != last; ++first)
+                emplace_back(*first);
+    }
+
+    template<typename ForwardIt>
+    void assign_range(ForwardIt first, ForwardIt last, forward_iterator_tag)
+    {
+        size_type count = size_type(std::distance(first, last));
+        if(count > capacity())
+        {
+            vector_base tmp(get_alloc());
+            tmp.init_range(first, last, forward_iterator_tag());
+            replace(tmp);
+        }
+        else if(count > size())
+        {
+            ForwardIt mid = first;
+            std::advance(mid, size());
+            std::copy(first, mid, begin());
+            last_ = first_.first() + (uninitialized_copy(mid, last, end(), get_alloc()) - begin());
+        }
+        else
+        {
+            destroy_from(std::copy(first, last, begin()));
+        }
+    }
+
+    template<typename InputIt>
+    iterator insert_range(const_iterator pos, InputIt first, InputIt last, input_iterator_tag)
+    {
+        // single pass: append, then rotate into place
+        size_type off = size_type(pos - cbegin());
+        size_type old_size = size();
+        for(; first != last; ++first)
+            emplace_back(*first);
+        std::rotate(begin() + off, begin() + old_size, end());
+        return begin() + off;
+    }
+
+    template<typename ForwardIt>
+    iterator insert_range(const_iterator pos, ForwardIt first, ForwardIt last, forward_iterator_tag)
+    {
+        size_type off = size_type(pos - cbegin());
+        size_type count = size_type(std::distance(first, last));
+        if(count == 0)
+            return begin() + off;
+        if(count > size_type(end_ - last_))
+        {
+            reallocate_insert(grow_to(size() + count), off, count,
+                [&](T* d) { uninitialized_copy(first, last, d, get_alloc()); });
+            return begin() + off;
+        }
+        insert_copies(relocate_bitwise(), begin() + off, first, last, count);
+        return begin() + off;
+    }
+
+    // Bitwise: [p, end()) slides up by count in one memmove and fill(p, p + count)
+    // builds the gap. If fill throws, it cleans up after itself and the tail slides back.
+    template<typename Fill>
+    void fill_gap(T* p, size_type count, Fill fill)
+    {
+        mystd::uninitialized_relocate(p, end(), p + count);
+        last_ += count;
+        try
+        {
+            fill(p, p + count);
+        }
+        catch(...)
+        {
+            mystd::uninitialized_relocate(p + count, end(), p);
+            last_ -= count;
+            throw;
+        }
+    }
+
+    // Builds a new element at p < end(), with room for it at end().
+    template<typename... Args>
+    void insert_one(true_type, T* p, Args&&... args)
+    {
+        // args may refer to an element that is about to move, so build the element aside
+        typename aligned_storage<sizeof(T), alignof(T)>::type buffer;
+        T* tmp = reinterpret_cast<T*>(&buffer);
+        alloc_traits::construct(get_alloc(), tmp, std::forward<Args>(args)...);
+        fill_gap(p, 1, [tmp](T* gap, T*) noexcept { mystd::relocate_at(tmp, gap); });
+    }
+
+    template<typename... Args>
+    void insert_one(false_type, T* p, Args&&... args)
+    {
+        T tmp(std::forward<Args>(args)...); // args may refer to an element that is about to move
+        T* old_end = end();
+        alloc_traits::construct(get_alloc(), old_end, std::move(old_end[-1]));
+        ++last_;
+        std::move_backward(p, old_end - 1, old_end);
+        *p = std::move(tmp);
+    }
+
+    // Inserts count copies of value, which is not an element, at p; there is room for them.
+    void insert_fill(true_type, T* p, size_type count, const T& value)
+    {
+        fill_gap(p, count, [&](T* first, T* last) { uninitialized_fill(first, last, value, get_alloc()); });
+    }
+
+    void insert_fill(false_type, T* p, size_type count, const T& value)
+    {
+        T* old_end = end();
+        size_type after = size_type(old_end - p);
+        if(after > count)
+        {
+            uninitialized_move(old_end - count, old_end, old_end, get_alloc());
+            last_ += count;
+            std::move_backward(p, old_end - count, old_end);
+            std::fill_n(p, count, value);
+        }
+        else
+        {
+            uninitialized_fill(old_end, old_end + (count - after), value, get_alloc());
+            last_ += count - after;
+            uninitialized_move(p, old_end, end(), get_alloc());
+            last_ += after;
+            std::fill(p, old_end, value);
+        }
+    }
+
+    // Inserts the count elements of [first, last) at p; there is room for them.
+    template<typename ForwardIt>
+    void insert_copies(true_type, T* p, ForwardIt first, ForwardIt last, size_type count)
+    {
+        fill_gap(p, count, [&](T* d, T*) { uninitialized_copy(first, last, d, get_alloc()); });
+    }
+
+    template<typename ForwardIt>
+    void insert_copies(false_type, T* p, ForwardIt first, ForwardIt last, size_type count)
+    {
+        T* old_end = end();
+        size_type after = size_type(old_end - p);
+        if(after > count)
+        {
+            uninitialized_move(old_end - count, old_end, old_end, get_alloc());
+            last_ += count;
+            std::move_backward(p, old_end - count, old_end);
+            std::copy(first, last, p);
+        }
+        else
+        {
+            ForwardIt mid = first;
+            std::advance(mid, after);
+            uninitialized_copy(mid, last, old_end, get_alloc());
+            last_ += count - after;
+            uninitialized_move(p, old_end, end(), get_alloc());
+            last_ += after;
+            std::copy(first, mid, p);
+        }
+    }
+
+    void erase_range(true_type, T* first, T* last) noexcept
+    {
+        mystd::destroy(first, last, get_alloc());
+        T* new_end = mystd::uninitialized_relocate(last, end(), first);
+        last_ = this->first() + (new_end - begin());
+    }
+
+    void erase_range(false_type, T* first, T* last)
+    {
+        destroy_from(std::move(last, end(), first));
+    }
+
+    // Takes the elements of other, whose allocator can free our storage, into this
+    // empty vector: its heap storage by pointer, its inline elements one by one.
+    void take(vector_base& other) noexcept(nothrow_take)
+    {
+        if(other.first() != other.inline_first())
+        {
+            first() = other.first();
+            last_ = other.last_;
+            end_ = other.end_;
+            other.reset();
+        }
+        else
+        {
+            take_inline(relocate_bitwise(), other);
+        }
+    }
+
+    void take_inline(true_type, vector_base& other) noexcept
+    {
+        T* d = mystd::uninitialized_relocate(other.begin(), other.end(), begin());
+        last_ = first() + (d - begin());
+        other.last_ = other.first();
+    }
+
+    void take_inline(false_type, vector_base& other) noexcept(nothrow_take)
+    {
+        T* d = uninitialized_move(other.begin(), other.end(), begin(), get_alloc());
+        last_ = first() + (d - begin());
+        other.clear();
+    }
+
+    // Takes the storage of tmp, which is on the heap, in place of ours.
+    void replace(vector_base& tmp) noexcept
+    {
+        clear();
+        deallocate();
+        take(tmp);
+    }
+
+    void swap_alloc(vector_base& other, true_type) noexcept
+    {
+        using std::swap;
+        swap(get_alloc(), other.get_alloc());
+    }
+    void swap_alloc(vector_base&, false_type) noexcept {}
+
+    void copy_alloc(const allocator_type& alloc, true_type)
+    {
+        if(get_alloc() != alloc)
+        {
+            // the old storage belongs to the old allocator
+            clear();
+            deallocate();
+        }
+        get_alloc() = alloc;
+    }
+    void copy_alloc(const allocator_type&, false_type) {}
+
+    void move_assign(vector_base& other, true_type) noexcept(nothrow_take)
+    {
+        clear();
+        deallocate();
+        move_alloc(other.get_alloc(), typename alloc_traits::propagate_on_container_move_assignment());
+        take(other);
+    }
+
+    void move_assign(vector_base& other, false_type)
+    {
+        if(get_alloc() == other.get_alloc())
+            move_assign(other, true_type());
+        else
+            assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+    }
+
+    void move_alloc(allocator_type& alloc, true_type) noexcept { get_alloc() = std::move(alloc); }
+    void move_alloc(allocator_type&, false_type) noexcept {}
+};
+
+template<typename T, typename Allocator, typename Growth, size_t N>
+constexpr bool vector_base<T, Allocator, Growth, N>::nothrow_take;
+
+} // namespace detail
+
+
+template<typename T, typename Alloc, typename Growth, size_t N>
+inline bool operator==(const detail::vector_base<T, Alloc, Growth, N>& a,
+    const detail::vector_base<T, Alloc, Growth, N>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template<typename T, typename Alloc, typename Growth, size_t N>
+inline bool operator!=(const detail::vector_base<T, Alloc, Growth, N>& a,
+    const detail::vector_base<T, Alloc, Growth, N>& b)
+{
+    return !(a == b);
+}
+
+template<typename T, typename Alloc, typename Growth, size_t N>
+inline bool operator<(const detail::vector_base<T, Alloc, Growth, N>& a,
+    const detail::vector_base<T, Alloc, Growth, N>& b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template<typename T, typename Alloc, typename Growth, size_t N>
+inline bool operator>(const detail::vector_base<T, Alloc, Growth, N>& a,
+    const detail::vector_base<T, Alloc, Growth, N>& b)
+{
+    return b < a;
+}
+
+template<typename T, typename Alloc, typename Growth, size_t N>
+inline bool operator<=(const detail::vector_base<T, Alloc, Growth, N>& a,
+    const detail::vector_base<T, Alloc, Growth, N>& b)
+{
+    return !(b < a);
+}
+
+template<typename T, typename Alloc, typename Growth, size_t N>
+inline bool operator>=(const detail::vector_base<T, Alloc, Growth, N>& a,
+    const detail::vector_base<T, Alloc, Growth, N>& b)
+{
+    return !(a < b);
+}
+
+template<typename T, typename Alloc, typename Growth, size_t N>
+inline void swap(detail::vector_base<T, Alloc, Growth, N>& a, detail::vector_base<T, Alloc, Growth, N>& b)
+    noexcept(noexcept(a.swap(b)))
+{
+    a.swap(b);
+}
+
+
+/**
+ *  A sequence of elements stored contiguously, on allocator_traits.
+ *
+ *  Growing reallocates through allocate_at_least and keeps all the memory the
+ *  allocator returned as capacity. Growth sets by how much: see growth_factor.
+ *
+ *  Reallocation relocates the elements into the new buffer with memcpy when they
+ *  are trivially copyable (and the allocator does not customize construct), by
+ *  move when the move constructor is noexcept or there is no copy constructor, and
+ *  by copy otherwise, like move_if_noexcept. With a copy a throwing element leaves
+ *  the vector as it was, so push_back, emplace_back and reserve give the strong
+ *  exception guarantee.
+*/
+template<typename T, typename Allocator = allocator<T>, typename Growth = growth_factor<2, 1>>
+class vector : public detail::vector_base<T, Allocator, Growth, 0>
+{
+    typedef detail::vector_base<T, Allocator, Growth, 0> base;
+
 public:
-    typedef T           value_type;
-    typedef Allocator   allocator_type;
-    typedef size_t      size_type;
-    typedef ptrdiff_t   difference_type;
-    typedef T&          reference;
-    typedef const T&    const_reference;
-    typedef allocator_traits<Allocator>::pointer        pointer;
-    typedef allocator_traits<Allocator>::const_pointer  const_pointer;
-    typedef             iterator;
-    typedef             const_iterator;
-    typedef reverse_iterator<iterator>          reverse_iterator;
-    typedef reverse_iterator<const_iterator>    const_reverse_iterator;
-
-    vector() noexcept
+    using base::base;
 
+    vector() = default;
+
+    vector& operator=(initializer_list<T> init)
+    {
+        this->assign(init);
+        return *this;
+    }
 };
 
+// Three pointers into the heap and the allocator. small_vector is not: it may point into itself.
+template<typename T, typename Allocator, typename Growth>
+struct is_trivially_relocatable<vector<T, Allocator, Growth>> : integral_constant<bool,
+    is_trivially_relocatable<typename allocator_traits<Allocator>::pointer>::value
+    && is_trivially_relocatable<Allocator>::value> {};
+
 MYSTD_NS_END
@@ -1,20 +1,22 @@
 #pragma once
 
 #include "mystd.h"
+#include "type_traits.h"
+#include <cassert> // assert
 #include <cstddef> // ptrdiff_t
-#include <iterator> // istream_iterator, ostream_iterator, istreambuf_iterator, ostreambuf_iterator
+#include <iterator> // iterator tags, reverse_iterator, istream_iterator, ...
 
 MYSTD_NS_BEGIN
 
 using std::ptrdiff_t;
 
 
-struct input_iterator_tag {};
-struct forward_iterator_tag : input_iterator_tag {};
-struct bidirectional_iterator_tag : forward_iterator_tag {};
-struct random_access_iterator_tag : bidirectional_iterator_tag {};
-
-struct output_iterator_tag {};
+// the tags are std's, so our iterators work with std algorithms and std's with ours
+using std::input_iterator_tag;
+using std::forward_iterator_tag;
+using std::bidirectional_iterator_tag;
+using std::random_access_iterator_tag;
+using std::output_iterator_tag;
 
 template<typename Category,
     typename T,
@@ -31,6 +33,9 @@ struct iterator
 };
 
 
+template<typename Iterator, typename = void>
+struct iterator_traits_base {};
+
 template<typename Iterator>
 struct iterator_traits_base<Iterator, void_t<
         typename Iterator::iterator_category,
@@ -47,7 +52,7 @@ struct iterator_traits_base<Iterator, void_t<
 };
 
 template<typename Iterator>
-struct iterator_traits : iterator_traits_base
+struct iterator_traits : iterator_traits_base<Iterator>
 {
     // get traits from Iterator, if possible
 };
@@ -88,7 +93,7 @@ using std::insert_iterator;
 
 using std::make_reverse_iterator;
 using std::make_move_iterator;
-using std::font_inserter;
+using std::front_inserter;
 using std::back_inserter;
 using std::inserter;
 
@@ -98,7 +103,7 @@ using std::ostream_iterator;
 using std::istreambuf_iterator;
 using std::ostreambuf_iterator;
 
-using std::beign;
+using std::begin;
 using std::cbegin;
 using std::end;
 using std::cend;
@@ -111,16 +116,15 @@ using std::crend;
 
 
 template<typename InputIt, typename Diff>
-inline void advance(InputIt& it, Diff offset, input_iterator_tag)
+inline void advance_helper(InputIt& it, Diff offset, input_iterator_tag)
 {
-    if(offset < 0)
-        ; // Error("negative offset in advance");
+    assert(offset >= 0 && "negative offset in advance");
     for(; 0 < offset; --offset)
         ++it;
 }
 
 template<typename BidIt, typename Diff>
-inline void advance(BidIt& it, Diff offset, bidirectional_iterator_tag)
+inline void advance_helper(BidIt& it, Diff offset, bidirectional_iterator_tag)
 {
     for(; 0 < offset; --offset)
         ++it;
@@ -129,7 +133,7 @@ inline void advance(BidIt& it, Diff offset, bidirectional_iterator_tag)
 }
 
 template<typename RanIt, typename Diff>
-inline void advance(Ranit& it, Diff offset, random_access_iterator_tag)
+inline void advance_helper(RanIt& it, Diff offset, random_access_iterator_tag)
 {
     it += offset;
 }
@@ -157,7 +161,7 @@ inline iterator_diff_t<RanIt> distance_helper(RanIt first, RanIt last, random_ac
 }
 
 template<typename InputIt>
-inline typename iterator_diff_t<InputIt> distance(InputIt first, InputIt last)
+inline iterator_diff_t<InputIt> distance(InputIt first, InputIt last)
 {
     return distance_helper(first, last, iterator_category_t<InputIt>());
 }
@@ -169,7 +173,7 @@ inline InputIt next(InputIt first, iterator_diff_t<InputIt> offset = 1)
     static_assert(is_base_of<input_iterator_tag,
         iterator_category_t<InputIt>>::value,
         "next requires input iterator");
-    advance(first, offset);
+    mystd::advance(first, offset);
     return first;
 }
 
@@ -179,9 +183,28 @@ inline BidIt prev(BidIt first, iterator_diff_t<BidIt> offset = 1)
     static_assert(is_base_of<bidirectional_iterator_tag,
         iterator_category_t<BidIt>>::value,
         "prev requires bidirectional iterator");
-    advance(first, -offset);
+    mystd::advance(first, -offset);
     return first;
 }
 
 
+/**
+ *  Iterators over a sequence of contiguous segments, such as the blocks of a deque,
+ *  say so by specializing this with is_segmented_iterator = true_type and:
+ *
+ *      segment_iterator, local_iterator
+ *      segment(it), local(it)    the segment it is in, and its place there
+ *      begin(seg), end(seg)      the whole of a segment
+ *      compose(seg, local)       the iterator at local in seg
+ *
+ *  Algorithms such as copy, fill and for_each then run one plain loop per segment
+ *  instead of checking for the end of a segment at every element.
+*/
+template<typename Iterator>
+struct segmented_iterator_traits
+{
+    typedef false_type is_segmented_iterator;
+};
+
+
 MYSTD_NS_END
@@ -3,8 +3,25 @@
 #include "../mystd.h"
 #include "../type_traits.h"
 #include <cstddef> // size_t, ptrdiff_t
-#include <utility> // forward, declval
+#include <utility> // forward, declval, pair, index_sequence
+#include <tuple> // tuple, forward_as_tuple
 #include <limits> // numeric_limits
+#include <new> // placement new, bad_alloc
+#include <cstdint> // uintptr_t
+#include <mutex> // mutex, lock_guard
+#include <atomic> // atomic, memory_order
+#if !defined(MYSTD_NO_USABLE_SIZE)
+#  if defined(__GLIBC__) || defined(__linux__)
+#    include <malloc.h> // malloc_usable_size
+#    define MYSTD_USABLE_SIZE(p) malloc_usable_size(p)
+#  elif defined(__APPLE__)
+#    include <malloc/malloc.h> // malloc_size
+#    define MYSTD_USABLE_SIZE(p) malloc_size(p)
+#  elif defined(_MSC_VER)
+#    include <malloc.h> // _msize
+#    define MYSTD_USABLE_SIZE(p) _msize(p)
+#  endif
+#endif
 
 
 MYSTD_NS_BEGIN
@@ -14,6 +31,108 @@ using std::ptrdiff_t;
 using std::forward;
 using std::numeric_limits;
 using std::declval;
+using std::max_align_t;
+using std::uintptr_t;
+using std::mutex;
+using std::lock_guard;
+using std::atomic;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_relaxed;
+using std::memory_order_acq_rel;
+
+
+// The alignment ::operator new(size_t) guarantees. Anything stricter is over-aligned.
+#if defined(__STDCPP_DEFAULT_NEW_ALIGNMENT__)
+constexpr size_t default_new_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+#else
+constexpr size_t default_new_alignment = alignof(max_align_t);
+#endif
+
+// Padding two objects this far apart keeps them off the same cache line (avoids false sharing).
+constexpr size_t hardware_destructive_interference_size = 64;
+
+
+namespace detail {
+
+/**
+ *  Allocates `bytes` aligned to `alignment` (a power of two).
+ *  Uses the aligned ::operator new overloads when the compiler has them (C++17 or
+ *  -faligned-new); otherwise over-allocates and stashes the raw pointer in front of
+ *  the returned block.
+*/
+inline void* allocate_bytes(size_t bytes, size_t alignment)
+{
+    if(alignment <= default_new_alignment)
+        return ::operator new(bytes);
+#if defined(__cpp_aligned_new)
+    return ::operator new(bytes, std::align_val_t(alignment));
+#else
+    if(bytes > (size_t)(-1) - alignment - sizeof(void*))
+        throw std::bad_alloc();
+    uintptr_t raw = reinterpret_cast<uintptr_t>(::operator new(bytes + alignment + sizeof(void*)));
+    void** p = reinterpret_cast<void**>(
+        (raw + sizeof(void*) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    p[-1] = reinterpret_cast<void*>(raw);
+    return p;
+#endif
+}
+
+/**
+ *  Releases memory from allocate_bytes; `alignment` must match the one it was allocated with.
+ *  `bytes` may be anything between the requested size and the one reported by usable_size().
+ *  The sized operator delete must get exactly the requested size, so it is only used where
+ *  usable_size() reports no slack: for over-aligned blocks, or when MYSTD_USABLE_SIZE is off.
+*/
+inline void deallocate_bytes(void* p, size_t bytes, size_t alignment) noexcept
+{
+    (void)bytes;
+    if(alignment <= default_new_alignment)
+#if defined(__cpp_sized_deallocation) && !defined(MYSTD_USABLE_SIZE)
+        ::operator delete(p, bytes);
+#else
+        ::operator delete(p);
+#endif
+    else
+#if defined(__cpp_aligned_new) && defined(__cpp_sized_deallocation)
+        ::operator delete(p, bytes, std::align_val_t(alignment));
+#elif defined(__cpp_aligned_new)
+        ::operator delete(p, std::align_val_t(alignment));
+#else
+        ::operator delete(static_cast<void**>(p)[-1]);
+#endif
+}
+
+/**
+ *  How many bytes the heap really handed out for a block of `bytes` from allocate_bytes.
+ *  Relies on ::operator new sitting on top of malloc, which holds for the stock runtimes;
+ *  build with MYSTD_NO_USABLE_SIZE when operator new is replaced by something else.
+*/
+inline size_t usable_size(void* p, size_t bytes, size_t alignment) noexcept
+{
+#if defined(MYSTD_USABLE_SIZE)
+    if(alignment <= default_new_alignment)
+    {
+        size_t usable = MYSTD_USABLE_SIZE(p);
+        return usable > bytes ? usable : bytes;
+    }
+#else
+    (void)p;
+#endif
+    (void)alignment;
+    return bytes;
+}
+
+} // namespace detail
+
+
+// What allocate_at_least returns: the memory and how many elements it really holds.
+template<typename Pointer, typename SizeType = size_t>
+struct allocation_result
+{
+    Pointer     ptr;
+    SizeType    count;
+};
 
 
 template<typename T>
@@ -43,21 +162,35 @@ public:
     allocator(const allocator<value_type>&) noexcept {}
     template<typename Other>
     allocator(const allocator<Other>&) noexcept {}
+    allocator& operator=(const allocator&) = default;
     template<typename Other>
     allocator<value_type>& operator=(const allocator<Other>&) { return *this; }
 
     void deallocate(pointer p, size_type count)
     {
-        ::operator delete(p);
+        detail::deallocate_bytes(p, count * sizeof(T), alignof(T));
     }
     pointer allocate(size_type count)
     {
         if(count == 0) return 0;
-        void* ptr = ::operator new(count * sizeof(T));
+        if(count > max_size())
+            throw std::bad_alloc();
+        void* ptr = detail::allocate_bytes(count * sizeof(T), alignof(T)); // honours alignas(N) on T
         return static_cast<pointer>(ptr);
     }
     pointer allocate(size_type count, const void *) { return allocate(count); }
 
+    // Like allocate, but reports the slack the heap handed out too. Any count in
+    // [requested, returned] may be passed back to deallocate.
+    allocation_result<pointer, size_type> allocate_at_least(size_type count)
+    {
+        pointer p = allocate(count);
+        if(p == 0)
+            return { p, 0 };
+        size_t bytes = detail::usable_size(p, count * sizeof(T), alignof(T));
+        return { p, bytes / sizeof(T) };
+    }
+
     template<typename Obj, typename... Args>
     void construct(Obj* ptr, Args&&... args)
     {
@@ -100,6 +233,773 @@ template<typename T1, typename T2>
 inline bool operator!=(const allocator<T1>&, const allocator<T2>&) noexcept { return false; }
 
 
+namespace detail {
+
+/**
+ *  Process-wide state behind pool_allocator.
+ *
+ *  Small requests are rounded up to one of size_class_count size classes. Each
+ *  thread owns a pool_thread_cache with one free list per class; blocks are carved
+ *  from slab_size-aligned slabs whose header records the owning cache, so a free
+ *  from another thread can find its way back to the owner.
+ *
+ *  Caches are never destroyed: when a thread exits its cache (and every block in
+ *  it) is parked and adopted by the next thread that starts using the pool.
+*/
+struct pool_free_block
+{
+    pool_free_block* next;
+};
+
+class pool_thread_cache;
+
+struct pool_slab_header
+{
+    pool_thread_cache*  owner;
+    size_t              block_size;
+};
+
+class pool_heap
+{
+public:
+    static constexpr size_t granularity = alignof(max_align_t);
+    static constexpr size_t size_class_count = 32;
+    static constexpr size_t max_block_size = granularity * size_class_count;
+    static constexpr size_t slab_size = 64 * 1024;
+    static constexpr size_t slabs_per_chunk = 16;
+
+    static bool is_pooled(size_t bytes, size_t alignment) noexcept
+    {
+        return bytes != 0 && bytes <= max_block_size && alignment <= granularity;
+    }
+    static size_t size_class(size_t bytes) noexcept
+    {
+        return (bytes - 1) / granularity;
+    }
+
+    static void* allocate(size_t bytes);
+    static void deallocate(void* p) noexcept;
+
+    // Hands out a fresh slab_size-aligned slab. Slabs are kept for the life of the process.
+    static pool_slab_header* new_slab()
+    {
+        pool_heap& heap = instance();
+        lock_guard<mutex> lock(heap.mutex_);
+        if(heap.next_slab_ == heap.chunk_end_)
+        {
+            uintptr_t raw = reinterpret_cast<uintptr_t>(
+                ::operator new((slabs_per_chunk + 1) * slab_size));
+            heap.next_slab_ = (raw + slab_size - 1) & ~(uintptr_t)(slab_size - 1);
+            heap.chunk_end_ = heap.next_slab_ + slabs_per_chunk * slab_size;
+        }
+        pool_slab_header* slab = reinterpret_cast<pool_slab_header*>(heap.next_slab_);
+        heap.next_slab_ += slab_size;
+        return slab;
+    }
+
+    static pool_slab_header* slab_of(void* p) noexcept
+    {
+        return reinterpret_cast<pool_slab_header*>(
+            reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(slab_size - 1));
+    }
+
+    static pool_thread_cache& local_cache();
+
+private:
+    class cache_holder;
+
+    static pool_heap& instance()
+    {
+        static pool_heap heap;
+        return heap;
+    }
+
+    pool_heap() noexcept : idle_caches_(nullptr), next_slab_(0), chunk_end_(0) {}
+
+    mutex               mutex_;
+    pool_thread_cache*  idle_caches_;
+    uintptr_t           next_slab_;
+    uintptr_t           chunk_end_;
+};
+
+class pool_thread_cache
+{
+    friend class pool_heap;
+
+    // touched by the owner thread only
+    pool_free_block*    free_[pool_heap::size_class_count];
+    char*               bump_[pool_heap::size_class_count];
+    char*               bump_end_[pool_heap::size_class_count];
+
+    // blocks freed by other threads, drained by the owner when its own list runs dry
+    mutex               remote_mutex_;
+    pool_free_block*    remote_[pool_heap::size_class_count];
+    atomic<bool>        has_remote_;
+
+    pool_thread_cache*  next_idle_;
+
+public:
+    pool_thread_cache() noexcept : has_remote_(false), next_idle_(nullptr)
+    {
+        for(size_t i = 0; i < pool_heap::size_class_count; ++i)
+        {
+            free_[i] = remote_[i] = nullptr;
+            bump_[i] = bump_end_[i] = nullptr;
+        }
+    }
+
+    void* allocate(size_t cls)
+    {
+        pool_free_block* block = free_[cls];
+        if(block == nullptr && has_remote_.load(memory_order_acquire))
+        {
+            drain_remote();
+            block = free_[cls];
+        }
+        if(block != nullptr)
+        {
+            free_[cls] = block->next;
+            return block;
+        }
+        return carve(cls);
+    }
+
+    void deallocate_local(void* p, size_t cls) noexcept
+    {
+        pool_free_block* block = static_cast<pool_free_block*>(p);
+        block->next = free_[cls];
+        free_[cls] = block;
+    }
+
+    void deallocate_remote(void* p, size_t cls) noexcept
+    {
+        pool_free_block* block = static_cast<pool_free_block*>(p);
+        lock_guard<mutex> lock(remote_mutex_);
+        block->next = remote_[cls];
+        remote_[cls] = block;
+        has_remote_.store(true, memory_order_release);
+    }
+
+private:
+    void drain_remote() noexcept
+    {
+        lock_guard<mutex> lock(remote_mutex_);
+        for(size_t cls = 0; cls < pool_heap::size_class_count; ++cls)
+        {
+            while(remote_[cls] != nullptr)
+            {
+                pool_free_block* block = remote_[cls];
+                remote_[cls] = block->next;
+                block->next = free_[cls];
+                free_[cls] = block;
+            }
+        }
+        has_remote_.store(false, memory_order_relaxed);
+    }
+
+    void* carve(size_t cls)
+    {
+        size_t block_size = (cls + 1) * pool_heap::granularity;
+        if(bump_[cls] == nullptr || (size_t)(bump_end_[cls] - bump_[cls]) < block_size)
+        {
+            pool_slab_header* slab = pool_heap::new_slab();
+            slab->owner = this;
+            slab->block_size = block_size;
+            bump_[cls] = reinterpret_cast<char*>(slab) + pool_heap::granularity;
+            bump_end_[cls] = reinterpret_cast<char*>(slab) + pool_heap::slab_size;
+        }
+        void* p = bump_[cls];
+        bump_[cls] += block_size;
+        return p;
+    }
+};
+
+static_assert(sizeof(pool_slab_header) <= pool_heap::granularity, "slab header must fit in one granule");
+
+class pool_heap::cache_holder
+{
+public:
+    pool_thread_cache* cache;
+
+    cache_holder()
+    {
+        pool_heap& heap = instance();
+        {
+            lock_guard<mutex> lock(heap.mutex_);
+            cache = heap.idle_caches_;
+            if(cache != nullptr)
+                heap.idle_caches_ = cache->next_idle_;
+        }
+        if(cache == nullptr)
+            cache = new pool_thread_cache();
+    }
+    ~cache_holder()
+    {
+        pool_heap& heap = instance();
+        lock_guard<mutex> lock(heap.mutex_);
+        cache->next_idle_ = heap.idle_caches_;
+        heap.idle_caches_ = cache;
+    }
+};
+
+inline pool_thread_cache& pool_heap::local_cache()
+{
+    static thread_local cache_holder holder;
+    return *holder.cache;
+}
+
+inline void* pool_heap::allocate(size_t bytes)
+{
+    return local_cache().allocate(size_class(bytes));
+}
+
+inline void pool_heap::deallocate(void* p) noexcept
+{
+    pool_slab_header* slab = slab_of(p);
+    size_t cls = size_class(slab->block_size);
+    pool_thread_cache& cache = local_cache();
+    if(slab->owner == &cache)
+        cache.deallocate_local(p, cls);
+    else
+        slab->owner->deallocate_remote(p, cls);
+}
+
+} // namespace detail
+
+
+/**
+ *  Allocator for small, fixed-size objects (nodes) backed by per-thread size-class pools.
+ *
+ *  Requests up to detail::pool_heap::max_block_size bytes with fundamental alignment
+ *  are served from the calling thread's cache without taking a lock; a block freed by
+ *  another thread is handed back to the cache that allocated it. Anything else falls
+ *  back to ::operator new (the aligned overload for over-aligned types).
+*/
+template<typename T>
+class pool_allocator
+{
+public:
+    typedef T               value_type;
+    typedef value_type*     pointer;
+    typedef const T*        const_pointer;
+    typedef value_type&     reference;
+    typedef const T&        const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef true_type       propagate_on_container_move_assignment;
+    typedef true_type       is_always_equal;
+
+    template<typename Other>
+    struct rebind { typedef pool_allocator<Other> other; };
+
+    pool_allocator() noexcept {}
+    pool_allocator(const pool_allocator<value_type>&) noexcept {}
+    template<typename Other>
+    pool_allocator(const pool_allocator<Other>&) noexcept {}
+    pool_allocator& operator=(const pool_allocator&) = default;
+
+    pointer allocate(size_type count)
+    {
+        if(count == 0) return 0;
+        if(count > max_size())
+            throw std::bad_alloc();
+        size_t bytes = count * sizeof(T);
+        if(detail::pool_heap::is_pooled(bytes, alignof(T)))
+            return static_cast<pointer>(detail::pool_heap::allocate(bytes));
+        return static_cast<pointer>(detail::allocate_bytes(bytes, alignof(T)));
+    }
+
+    // Pooled requests are rounded up to their size class; the rest of the block is returned as slack.
+    allocation_result<pointer, size_type> allocate_at_least(size_type count)
+    {
+        pointer p = allocate(count);
+        if(p == 0)
+            return { p, 0 };
+        size_t bytes = count * sizeof(T);
+        if(detail::pool_heap::is_pooled(bytes, alignof(T)))
+            bytes = (detail::pool_heap::size_class(bytes) + 1) * detail::pool_heap::granularity;
+        else
+            bytes = detail::usable_size(p, bytes, alignof(T));
+        return { p, bytes / sizeof(T) };
+    }
+
+    void deallocate(pointer p, size_type count) noexcept
+    {
+        if(p == nullptr) return;
+        size_t bytes = count * sizeof(T);
+        if(detail::pool_heap::is_pooled(bytes, alignof(T)))
+            detail::pool_heap::deallocate(p);
+        else
+            detail::deallocate_bytes(p, bytes, alignof(T));
+    }
+
+    size_type max_size() const noexcept
+    {
+        return (size_type)(-1) / sizeof(T);
+    }
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const pool_allocator<T1>&, const pool_allocator<T2>&) noexcept { return true; }
+template<typename T1, typename T2>
+inline bool operator!=(const pool_allocator<T1>&, const pool_allocator<T2>&) noexcept { return false; }
+
+
+namespace detail {
+
+/**
+ *  Process-wide state behind slab_allocator.
+ *
+ *  Like pool_heap, requests are rounded up to size classes and carved from
+ *  slab_size-aligned slabs owned by one slab_thread_cache. The difference is where
+ *  a free from another thread goes: every slab has its own atomic remote-free list,
+ *  pushed with a single CAS, and the first remote free into an empty list also puts
+ *  the slab on its owner's atomic pending list. The owner only looks at that list
+ *  when it runs out of local blocks, and then takes each slab's remote list whole
+ *  with one exchange. Neither side ever takes a lock once the slab exists.
+*/
+class slab_thread_cache;
+
+struct slab_header
+{
+    slab_thread_cache*  owner;
+    size_t              size_class;
+    size_t              block_size;
+
+    // touched by the owner thread only
+    pool_free_block*    free;
+    char*               bump;
+    char*               end;
+    slab_header*        next_partial;
+    bool                partial;
+
+    // written by the thread that put the slab on the owner's pending list
+    slab_header*        next_pending;
+
+    alignas(hardware_destructive_interference_size)
+    atomic<pool_free_block*> remote_free;
+
+    void* pop_local() noexcept
+    {
+        if(pool_free_block* block = free)
+        {
+            free = block->next;
+            return block;
+        }
+        if((size_t)(end - bump) >= block_size)
+        {
+            void* p = bump;
+            bump += block_size;
+            return p;
+        }
+        return nullptr;
+    }
+
+    bool empty_local() const noexcept
+    {
+        return free == nullptr && (size_t)(end - bump) < block_size;
+    }
+
+    // Moves the whole remote-free list onto the local one.
+    void drain_remote() noexcept
+    {
+        pool_free_block* list = remote_free.exchange(nullptr, memory_order_acq_rel);
+        if(list == nullptr)
+            return;
+        pool_free_block* tail = list;
+        while(tail->next != nullptr)
+            tail = tail->next;
+        tail->next = free;
+        free = list;
+    }
+};
+
+class slab_heap
+{
+public:
+    static constexpr size_t granularity = pool_heap::granularity;
+    static constexpr size_t size_class_count = pool_heap::size_class_count;
+    static constexpr size_t max_block_size = granularity * size_class_count;
+    static constexpr size_t slab_size = pool_heap::slab_size;
+    static constexpr size_t slabs_per_chunk = pool_heap::slabs_per_chunk;
+    static constexpr size_t header_size =
+        (sizeof(slab_header) + granularity - 1) & ~(granularity - 1);
+
+    static bool is_pooled(size_t bytes, size_t alignment) noexcept
+    {
+        return pool_heap::is_pooled(bytes, alignment);
+    }
+    static size_t size_class(size_t bytes) noexcept
+    {
+        return pool_heap::size_class(bytes);
+    }
+
+    static void* allocate(size_t bytes);
+    static void deallocate(void* p) noexcept;
+
+    static slab_header* new_slab(slab_thread_cache* owner, size_t cls)
+    {
+        slab_heap& heap = instance();
+        uintptr_t addr;
+        {
+            lock_guard<mutex> lock(heap.mutex_);
+            if(heap.next_slab_ == heap.chunk_end_)
+            {
+                uintptr_t raw = reinterpret_cast<uintptr_t>(
+                    ::operator new((slabs_per_chunk + 1) * slab_size));
+                heap.next_slab_ = (raw + slab_size - 1) & ~(uintptr_t)(slab_size - 1);
+                heap.chunk_end_ = heap.next_slab_ + slabs_per_chunk * slab_size;
+            }
+            addr = heap.next_slab_;
+            heap.next_slab_ += slab_size;
+        }
+        slab_header* slab = ::new (reinterpret_cast<void*>(addr)) slab_header();
+        slab->owner = owner;
+        slab->size_class = cls;
+        slab->block_size = (cls + 1) * granularity;
+        slab->free = nullptr;
+        slab->bump = reinterpret_cast<char*>(addr) + header_size;
+        slab->end = reinterpret_cast<char*>(addr) + slab_size;
+        slab->next_partial = nullptr;
+        slab->partial = false;
+        slab->next_pending = nullptr;
+        slab->remote_free.store(nullptr, memory_order_relaxed);
+        return slab;
+    }
+
+    static slab_header* slab_of(void* p) noexcept
+    {
+        return reinterpret_cast<slab_header*>(
+            reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(slab_size - 1));
+    }
+
+    static slab_thread_cache& local_cache();
+
+private:
+    class cache_holder;
+
+    static slab_heap& instance()
+    {
+        static slab_heap heap;
+        return heap;
+    }
+
+    slab_heap() noexcept : idle_caches_(nullptr), next_slab_(0), chunk_end_(0) {}
+
+    mutex               mutex_;
+    slab_thread_cache*  idle_caches_;
+    uintptr_t           next_slab_;
+    uintptr_t           chunk_end_;
+};
+
+class slab_thread_cache
+{
+    friend class slab_heap;
+
+    // touched by the owner thread only: the slab being allocated from, and the
+    // other slabs of the class known to have free blocks
+    slab_header*        current_[slab_heap::size_class_count];
+    slab_header*        partial_[slab_heap::size_class_count];
+    slab_thread_cache*  next_idle_;
+
+    // slabs whose remote-free list went from empty to non-empty
+    alignas(hardware_destructive_interference_size)
+    atomic<slab_header*> pending_;
+
+public:
+    slab_thread_cache() noexcept : next_idle_(nullptr), pending_(nullptr)
+    {
+        for(size_t i = 0; i < slab_heap::size_class_count; ++i)
+            current_[i] = partial_[i] = nullptr;
+    }
+
+    void* allocate(size_t cls)
+    {
+        if(slab_header* slab = current_[cls])
+            if(void* p = slab->pop_local())
+                return p;
+        return refill(cls);
+    }
+
+    void deallocate_local(slab_header* slab, void* p) noexcept
+    {
+        pool_free_block* block = static_cast<pool_free_block*>(p);
+        block->next = slab->free;
+        slab->free = block;
+        make_partial(slab);
+    }
+
+    static void deallocate_remote(slab_header* slab, void* p) noexcept
+    {
+        pool_free_block* block = static_cast<pool_free_block*>(p);
+        pool_free_block* head = slab->remote_free.load(memory_order_relaxed);
+        do
+        {
+            block->next = head;
+        } while(!slab->remote_free.compare_exchange_weak(head, block,
+            memory_order_acq_rel, memory_order_relaxed));
+        if(head == nullptr)
+            slab->owner->push_pending(slab);
+    }
+
+private:
+    void push_pending(slab_header* slab) noexcept
+    {
+        slab_header* head = pending_.load(memory_order_relaxed);
+        do
+        {
+            slab->next_pending = head;
+        } while(!pending_.compare_exchange_weak(head, slab,
+            memory_order_release, memory_order_relaxed));
+    }
+
+    // Takes the remote frees of every pending slab, in one batch per slab.
+    void collect_pending() noexcept
+    {
+        if(pending_.load(memory_order_relaxed) == nullptr)
+            return;
+        slab_header* slab = pending_.exchange(nullptr, memory_order_acquire);
+        while(slab != nullptr)
+        {
+            // read before draining: once the list is empty the slab may be pushed again
+            slab_header* next = slab->next_pending;
+            slab->drain_remote();
+            make_partial(slab);
+            slab = next;
+        }
+    }
+
+    void make_partial(slab_header* slab) noexcept
+    {
+        if(slab->partial || slab == current_[slab->size_class])
+            return;
+        slab->partial = true;
+        slab->next_partial = partial_[slab->size_class];
+        partial_[slab->size_class] = slab;
+    }
+
+    void* refill(size_t cls)
+    {
+        collect_pending();
+        slab_header* slab = current_[cls];
+        if(slab != nullptr && !slab->empty_local())
+            return slab->pop_local();
+        while((slab = partial_[cls]) != nullptr)
+        {
+            partial_[cls] = slab->next_partial;
+            slab->partial = false;
+            if(!slab->empty_local())
+            {
+                current_[cls] = slab;
+                return slab->pop_local();
+            }
+        }
+        slab = slab_heap::new_slab(this, cls);
+        current_[cls] = slab;
+        return slab->pop_local();
+    }
+};
+
+static_assert(slab_heap::header_size < slab_heap::slab_size / 2, "slab header too large");
+
+class slab_heap::cache_holder
+{
+public:
+    slab_thread_cache* cache;
+
+    cache_holder()
+    {
+        slab_heap& heap = instance();
+        {
+            lock_guard<mutex> lock(heap.mutex_);
+            cache = heap.idle_caches_;
+            if(cache != nullptr)
+                heap.idle_caches_ = cache->next_idle_;
+        }
+        if(cache == nullptr) // over-aligned, plain new would not honour it before C++17
+            cache = ::new (allocate_bytes(sizeof(slab_thread_cache), alignof(slab_thread_cache)))
+                slab_thread_cache();
+    }
+    ~cache_holder()
+    {
+        slab_heap& heap = instance();
+        lock_guard<mutex> lock(heap.mutex_);
+        cache->next_idle_ = heap.idle_caches_;
+        heap.idle_caches_ = cache;
+    }
+};
+
+inline slab_thread_cache& slab_heap::local_cache()
+{
+    static thread_local cache_holder holder;
+    return *holder.cache;
+}
+
+inline void* slab_heap::allocate(size_t bytes)
+{
+    return local_cache().allocate(size_class(bytes));
+}
+
+inline void slab_heap::deallocate(void* p) noexcept
+{
+    slab_header* slab = slab_of(p);
+    slab_thread_cache& cache = local_cache();
+    if(slab->owner == &cache)
+        cache.deallocate_local(slab, p);
+    else
+        slab_thread_cache::deallocate_remote(slab, p);
+}
+
+} // namespace detail
+
+
+/**
+ *  Allocator for small objects that are often freed by a different thread than the
+ *  one that allocated them, e.g. messages passed down a producer/consumer pipeline.
+ *
+ *  Same size classes and fallback as pool_allocator, but a cross-thread free is a
+ *  lock-free push onto the slab's remote-free list, and the owning thread takes
+ *  those lists back in batches when its local blocks run out.
+*/
+template<typename T>
+class slab_allocator
+{
+public:
+    typedef T               value_type;
+    typedef value_type*     pointer;
+    typedef const T*        const_pointer;
+    typedef value_type&     reference;
+    typedef const T&        const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef true_type       propagate_on_container_move_assignment;
+    typedef true_type       is_always_equal;
+
+    template<typename Other>
+    struct rebind { typedef slab_allocator<Other> other; };
+
+    slab_allocator() noexcept {}
+    slab_allocator(const slab_allocator<value_type>&) noexcept {}
+    template<typename Other>
+    slab_allocator(const slab_allocator<Other>&) noexcept {}
+    slab_allocator& operator=(const slab_allocator&) = default;
+
+    pointer allocate(size_type count)
+    {
+        if(count == 0) return 0;
+        if(count > max_size())
+            throw std::bad_alloc();
+        size_t bytes = count * sizeof(T);
+        if(detail::slab_heap::is_pooled(bytes, alignof(T)))
+            return static_cast<pointer>(detail::slab_heap::allocate(bytes));
+        return static_cast<pointer>(detail::allocate_bytes(bytes, alignof(T)));
+    }
+
+    allocation_result<pointer, size_type> allocate_at_least(size_type count)
+    {
+        pointer p = allocate(count);
+        if(p == 0)
+            return { p, 0 };
+        size_t bytes = count * sizeof(T);
+        if(detail::slab_heap::is_pooled(bytes, alignof(T)))
+            bytes = (detail::slab_heap::size_class(bytes) + 1) * detail::slab_heap::granularity;
+        else
+            bytes = detail::usable_size(p, bytes, alignof(T));
+        return { p, bytes / sizeof(T) };
+    }
+
+    void deallocate(pointer p, size_type count) noexcept
+    {
+        if(p == nullptr) return;
+        size_t bytes = count * sizeof(T);
+        if(detail::slab_heap::is_pooled(bytes, alignof(T)))
+            detail::slab_heap::deallocate(p);
+        else
+            detail::deallocate_bytes(p, bytes, alignof(T));
+    }
+
+    size_type max_size() const noexcept
+    {
+        return (size_type)(-1) / sizeof(T);
+    }
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const slab_allocator<T1>&, const slab_allocator<T2>&) noexcept { return true; }
+template<typename T1, typename T2>
+inline bool operator!=(const slab_allocator<T1>&, const slab_allocator<T2>&) noexcept { return false; }
+
+
+/**
+ *  Like allocator<T>, but every allocation is aligned to at least Align bytes,
+ *  e.g. 32/64 so vectorized kernels can use aligned loads on arithmetic buffers,
+ *  or hardware_destructive_interference_size to keep buffers on their own cache lines.
+*/
+template<typename T, size_t Align>
+class aligned_allocator
+{
+    static_assert(Align != 0 && (Align & (Align - 1)) == 0, "Align must be a power of two");
+
+public:
+    static constexpr size_t alignment = Align > alignof(T) ? Align : alignof(T);
+
+    typedef T               value_type;
+    typedef value_type*     pointer;
+    typedef const T*        const_pointer;
+    typedef value_type&     reference;
+    typedef const T&        const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef true_type       propagate_on_container_move_assignment;
+    typedef true_type       is_always_equal;
+
+    template<typename Other>
+    struct rebind { typedef aligned_allocator<Other, Align> other; };
+
+    aligned_allocator() noexcept {}
+    aligned_allocator(const aligned_allocator&) noexcept {}
+    template<typename Other>
+    aligned_allocator(const aligned_allocator<Other, Align>&) noexcept {}
+    aligned_allocator& operator=(const aligned_allocator&) = default;
+
+    pointer allocate(size_type count)
+    {
+        if(count == 0) return 0;
+        if(count > max_size())
+            throw std::bad_alloc();
+        return static_cast<pointer>(detail::allocate_bytes(count * sizeof(T), alignment));
+    }
+
+    void deallocate(pointer p, size_type count) noexcept
+    {
+        detail::deallocate_bytes(p, count * sizeof(T), alignment);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return (size_type)(-1) / sizeof(T);
+    }
+};
+
+template<typename T, size_t Align>
+constexpr size_t aligned_allocator<T, Align>::alignment;
+
+template<typename T1, typename T2, size_t Align>
+inline bool operator==(const aligned_allocator<T1, Align>&, const aligned_allocator<T2, Align>&) noexcept { return true; }
+template<typename T1, typename T2, size_t Align>
+inline bool operator!=(const aligned_allocator<T1, Align>&, const aligned_allocator<T2, Align>&) noexcept { return false; }
+
+// The allocators above hold no state, so containers holding one may still be moved bitwise.
+template<typename T>
+struct is_trivially_relocatable<allocator<T>> : true_type {};
+template<typename T>
+struct is_trivially_relocatable<pool_allocator<T>> : true_type {};
+template<typename T>
+struct is_trivially_relocatable<slab_allocator<T>> : true_type {};
+template<typename T, size_t Align>
+struct is_trivially_relocatable<aligned_allocator<T, Align>> : true_type {};
+
+
 namespace detail {
 // addressof_impl is copied and simplified from boost 1.62.0 core/addressof.hpp
 // http://stackoverflow.com/a/6495205/273767
@@ -238,11 +1138,30 @@ struct pointer_traits<T*>
 
     static pointer pointer_to(_ref_type r) noexcept
     {
-        return addressof(r);
+        return mystd::addressof(r);
     }
 };
 
 
+/**
+ *  Obtains the raw address held by a pointer or a fancy pointer (e.g. offset_ptr),
+ *  without forming a reference to the pointee. Containers use it to hand
+ *  allocator_traits<A>::pointer values to construct/destroy.
+*/
+template<typename T>
+inline T* to_address(T* p) noexcept
+{
+    static_assert(!is_function_v<T>, "to_address requires an object pointer");
+    return p;
+}
+template<typename Ptr>
+inline auto to_address(const Ptr& p) noexcept
+        -> decltype(to_address(p.operator->()))
+{
+    return to_address(p.operator->());
+}
+
+
 template<typename Allocator>
 struct allocator_traits
 {
@@ -254,9 +1173,10 @@ struct allocator_traits
 
 #define _GET_TYPE_OR_DEFAULT(TYPE, DEFAULT)                             \
 private:                                                                \
-    static typename allocator_type::TYPE     TYPE##_helper(allocator_type*);      \
+    template<typename _Alloc>                                           \
+    static typename _Alloc::TYPE        TYPE##_helper(_Alloc*);         \
     static DEFAULT                      TYPE##_helper(...);             \
-    typedef decltype(TYPE##_helper((allocator_type*)0)) __##TYPE;            \
+    typedef decltype(TYPE##_helper((allocator_type*)0)) __##TYPE;       \
 public:
 
 
@@ -316,6 +1236,10 @@ public:
         make_unsigned_t<difference_type>)
     typedef __size_type size_type;
 
+    _GET_TYPE_OR_DEFAULT(propagate_on_container_copy_assignment,
+        false_type)
+    typedef __propagate_on_container_copy_assignment propagate_on_container_copy_assignment;
+
     _GET_TYPE_OR_DEFAULT(propagate_on_container_move_assignment,
         false_type)
     typedef __propagate_on_container_move_assignment propagate_on_container_move_assignment;
@@ -388,6 +1312,7 @@ private:
         } 
     };
 
+public:
     static pointer allocate(allocator_type& a, size_type count)
     {
         return a.allocate(count);
@@ -397,24 +1322,45 @@ private:
         return allocate_helper::Fn(0, a, count, hint);
     }
 
-    static void deallocate(allocator_type& a, pointer ptr, size_type count)
+private:
+    struct allocate_at_least_helper
     {
-        a.deallocate(ptr, count);
-    }
+        template<typename Alloc>
+        static auto Fn(int, Alloc& a, size_type count)
+                -> decltype(a.allocate_at_least(count), allocation_result<pointer, size_type>())
+        {
+            auto r = a.allocate_at_least(count);
+            return { r.ptr, r.count };
+        }
+
+        template<typename Alloc>
+        static allocation_result<pointer, size_type> Fn(detail::_Wrap_int, Alloc& a, size_type count)
+        {
+            return { a.allocate(count), count };
+        }
+    };
 
 public:
-    template<typename T, typename... Args>
-    static auto construct(allocator_type& a, T* ptr, Args&&... args)
-            -> decltype(construct_helper(a, ptr, forward<Args>(args)...))
+    /**
+     *  @brief Allocates room for at least @a count elements
+     *  @return a.allocate_at_least(count) if well formed, otherwise {a.allocate(count), count}
+     *
+     *  Growable containers keep the returned count as their capacity; deallocate
+     *  accepts it back.
+     */
+    static allocation_result<pointer, size_type> allocate_at_least(allocator_type& a, size_type count)
+    {
+        return allocate_at_least_helper::Fn(0, a, count);
+    }
+
+    static void deallocate(allocator_type& a, pointer ptr, size_type count)
     {
-        construct_helper(a, ptr, forward<Args>(args)...);
+        a.deallocate(ptr, count);
     }
 
 
 private:
             // STRUCT TEMPLATE _Unwrap_alloc
-    template<class _Ty>
-        class allocator;
     template<class _Alloc>
         struct _Wrap_alloc;
 
@@ -623,6 +1569,191 @@ public:
     }
 };
 
-// todo: allocator_arg_t, allocator_arg, uses_allocator
+/**
+ *  Tag that selects the allocator-extended constructors, T(allocator_arg, alloc, args...).
+*/
+struct allocator_arg_t
+{
+    explicit allocator_arg_t() = default;
+};
+
+constexpr allocator_arg_t allocator_arg{};
+
+
+namespace detail {
+
+template<typename T, typename Alloc, typename = void>
+struct has_convertible_allocator_type : false_type {};
+template<typename T, typename Alloc>
+struct has_convertible_allocator_type<T, Alloc, void_t<typename T::allocator_type>>
+    : integral_constant<bool, is_convertible_v<Alloc, typename T::allocator_type>> {};
+
+} // namespace detail
+
+/**
+ *  Whether T takes an allocator of type Alloc when it is built with uses-allocator
+ *  construction. True when T::allocator_type exists and Alloc converts to it;
+ *  specialize it for types that take an allocator without naming allocator_type.
+*/
+template<typename T, typename Alloc>
+struct uses_allocator : detail::has_convertible_allocator_type<T, Alloc> {};
+
+template<typename T, typename Alloc>
+constexpr bool uses_allocator_v = uses_allocator<T, Alloc>::value;
+
+
+namespace detail {
+
+template<typename T>
+struct is_std_pair : false_type {};
+template<typename T1, typename T2>
+struct is_std_pair<std::pair<T1, T2>> : true_type {};
+
+// How T(args...) takes an allocator: not at all, leading (allocator_arg, a, args...) or trailing (args..., a).
+template<typename T, typename Alloc, typename... Args>
+struct uses_allocator_form : integral_constant<int,
+    !uses_allocator<T, Alloc>::value ? 0
+    : is_constructible<T, allocator_arg_t, const Alloc&, Args...>::value ? 1
+    : is_constructible<T, Args..., const Alloc&>::value ? 2
+    : 3> {};
+
+template<typename T, typename Alloc, typename... Args>
+inline std::tuple<Args&&...> uses_allocator_args(integral_constant<int, 0>, const Alloc&, Args&&... args)
+{
+    return std::forward_as_tuple(forward<Args>(args)...);
+}
+
+template<typename T, typename Alloc, typename... Args>
+inline std::tuple<allocator_arg_t, const Alloc&, Args&&...>
+    uses_allocator_args(integral_constant<int, 1>, const Alloc& alloc, Args&&... args)
+{
+    return std::tuple<allocator_arg_t, const Alloc&, Args&&...>(allocator_arg, alloc, forward<Args>(args)...);
+}
+
+template<typename T, typename Alloc, typename... Args>
+inline std::tuple<Args&&..., const Alloc&>
+    uses_allocator_args(integral_constant<int, 2>, const Alloc& alloc, Args&&... args)
+{
+    return std::tuple<Args&&..., const Alloc&>(forward<Args>(args)..., alloc);
+}
+
+template<typename T, typename Alloc, typename... Args>
+inline void uses_allocator_args(integral_constant<int, 3>, const Alloc&, Args&&...)
+{
+    static_assert(uses_allocator_form<T, Alloc, Args...>::value != 3,
+        "T uses the allocator but has no allocator-extended constructor for these arguments");
+}
+
+} // namespace detail
+
+
+/**
+ *  The arguments that build a T from args... with uses-allocator construction, as
+ *  a tuple to pass to T's constructor: alloc is inserted as (allocator_arg, alloc,
+ *  args...) or appended as (args..., alloc) when T uses it, and args... are passed
+ *  through unchanged otherwise.
+ *
+ *  std::pair is built piecewise, each member getting the allocator on its own, so
+ *  map-like containers of strings share their allocator with the strings too.
+*/
+template<typename T, typename Alloc, typename... Args,
+    typename = enable_if_t<!detail::is_std_pair<T>::value>>
+inline auto uses_allocator_construction_args(const Alloc& alloc, Args&&... args)
+    -> decltype(detail::uses_allocator_args<T>(detail::uses_allocator_form<T, Alloc, Args...>(),
+        alloc, forward<Args>(args)...))
+{
+    return detail::uses_allocator_args<T>(detail::uses_allocator_form<T, Alloc, Args...>(),
+        alloc, forward<Args>(args)...);
+}
+
+namespace detail {
+
+template<typename T, typename Alloc, typename Tuple, size_t... I>
+inline auto uses_allocator_args_from_tuple(const Alloc& alloc, Tuple&& args, std::index_sequence<I...>)
+    -> decltype(uses_allocator_construction_args<T>(alloc, std::get<I>(forward<Tuple>(args))...))
+{
+    return uses_allocator_construction_args<T>(alloc, std::get<I>(forward<Tuple>(args))...);
+}
+
+} // namespace detail
+
+template<typename T, typename Alloc, typename Tuple1, typename Tuple2,
+    typename = enable_if_t<detail::is_std_pair<T>::value>>
+inline auto uses_allocator_construction_args(const Alloc& alloc, std::piecewise_construct_t,
+    Tuple1&& x, Tuple2&& y)
+{
+    typedef typename T::first_type T1;
+    typedef typename T::second_type T2;
+    return std::make_tuple(std::piecewise_construct,
+        detail::uses_allocator_args_from_tuple<T1>(alloc, forward<Tuple1>(x),
+            std::make_index_sequence<std::tuple_size<decay_t<Tuple1>>::value>()),
+        detail::uses_allocator_args_from_tuple<T2>(alloc, forward<Tuple2>(y),
+            std::make_index_sequence<std::tuple_size<decay_t<Tuple2>>::value>()));
+}
+
+template<typename T, typename Alloc,
+    typename = enable_if_t<detail::is_std_pair<T>::value>>
+inline auto uses_allocator_construction_args(const Alloc& alloc)
+{
+    return uses_allocator_construction_args<T>(alloc, std::piecewise_construct, std::tuple<>(), std::tuple<>());
+}
+
+template<typename T, typename Alloc, typename U, typename V,
+    typename = enable_if_t<detail::is_std_pair<T>::value>>
+inline auto uses_allocator_construction_args(const Alloc& alloc, U&& u, V&& v)
+{
+    return uses_allocator_construction_args<T>(alloc, std::piecewise_construct,
+        std::forward_as_tuple(forward<U>(u)), std::forward_as_tuple(forward<V>(v)));
+}
+
+template<typename T, typename Alloc, typename U, typename V,
+    typename = enable_if_t<detail::is_std_pair<T>::value>>
+inline auto uses_allocator_construction_args(const Alloc& alloc, const std::pair<U, V>& p)
+{
+    return uses_allocator_construction_args<T>(alloc, std::piecewise_construct,
+        std::forward_as_tuple(p.first), std::forward_as_tuple(p.second));
+}
+
+template<typename T, typename Alloc, typename U, typename V,
+    typename = enable_if_t<detail::is_std_pair<T>::value>>
+inline auto uses_allocator_construction_args(const Alloc& alloc, std::pair<U, V>&& p)
+{
+    return uses_allocator_construction_args<T>(alloc, std::piecewise_construct,
+        std::forward_as_tuple(std::move(p).first), std::forward_as_tuple(std::move(p).second));
+}
+
+namespace detail {
+
+template<typename T, typename Tuple, size_t... I>
+inline T* construct_from_tuple(T* p, Tuple&& args, std::index_sequence<I...>)
+{
+    return ::new (static_cast<void*>(p)) T(std::get<I>(forward<Tuple>(args))...);
+}
+
+template<typename T, typename Tuple, size_t... I>
+inline T make_from_tuple(Tuple&& args, std::index_sequence<I...>)
+{
+    return T(std::get<I>(forward<Tuple>(args))...);
+}
+
+} // namespace detail
+
+// Builds a T at p from args..., handing it alloc if T uses one.
+template<typename T, typename Alloc, typename... Args>
+inline T* uninitialized_construct_using_allocator(T* p, const Alloc& alloc, Args&&... args)
+{
+    auto t = uses_allocator_construction_args<T>(alloc, forward<Args>(args)...);
+    return detail::construct_from_tuple(p, std::move(t),
+        std::make_index_sequence<std::tuple_size<decltype(t)>::value>());
+}
+
+// Returns a T built from args..., handing it alloc if T uses one.
+template<typename T, typename Alloc, typename... Args>
+inline T make_obj_using_allocator(const Alloc& alloc, Args&&... args)
+{
+    auto t = uses_allocator_construction_args<T>(alloc, forward<Args>(args)...);
+    return detail::make_from_tuple<T>(std::move(t),
+        std::make_index_sequence<std::tuple_size<decltype(t)>::value>());
+}
 
 MYSTD_NS_END
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "shared_ptr.h"
+#include <atomic> // atomic, memory_order
+#include <cstdint> // uint64_t, uintptr_t
+#include <new> // bad_alloc
+#include <utility> // move
+
+
+MYSTD_NS_BEGIN
+
+using std::uint64_t;
+using std::memory_order;
+using std::memory_order_seq_cst;
+
+
+namespace detail {
+
+// The immutable holder of one value stored in an atomic_shared_ptr.
+template<typename T>
+struct atomic_shared_node
+{
+    atomic<long>    refs;
+    shared_ptr<T>   value;
+
+    explicit atomic_shared_node(shared_ptr<T>&& v) noexcept : refs(1), value(std::move(v)) {}
+
+    // Adds delta references (or drops -delta) and frees the node when none are left.
+    void adjust(long delta) noexcept
+    {
+        if(delta > 0)
+            refs.fetch_add(delta, memory_order_relaxed);
+        else if(delta < 0 && refs.fetch_sub(-delta, memory_order_acq_rel) == -delta)
+            delete this;
+    }
+};
+
+inline memory_order at_least_acquire(memory_order order) noexcept
+{
+    return order == memory_order_seq_cst ? order : memory_order_acq_rel;
+}
+
+} // namespace detail
+
+
+/**
+ *  A shared_ptr<T> that can be loaded, stored and compared-and-exchanged from any
+ *  number of threads without a lock, for values read far more often than they are
+ *  replaced (configuration, routing tables).
+ *
+ *  It uses split reference counts. The value lives in a node, and one 64-bit word
+ *  holds the node's address in its low 48 bits and a count of readers in its high
+ *  16 bits. A reader adds itself to that count with one fetch_add, which keeps the
+ *  node alive. It then copies the shared_ptr and removes itself with a CAS. A
+ *  writer that swaps the node out turns the readers still counted in the old word
+ *  into references on the node, so each of those readers drops a reference
+ *  instead. No reader ever waits for a writer or takes a lock.
+ *
+ *  Every store allocates one node. Up to 65535 threads may be inside load() at once.
+ *  Every operation is at least acquire/release; seq_cst is honoured when requested.
+*/
+template<typename T>
+class atomic_shared_ptr
+{
+    typedef detail::atomic_shared_node<T> node;
+
+    static constexpr int        pointer_bits = 48;
+    static constexpr uint64_t   pointer_mask = ((uint64_t)1 << pointer_bits) - 1;
+    static constexpr uint64_t   one_reader = (uint64_t)1 << pointer_bits;
+
+    // User-space addresses take at most 48 bits on x86-64 and AArch64 (unless a
+    // process opts into 5-level paging); make_word() checks every node anyway.
+    static_assert(sizeof(void*) <= sizeof(uint64_t), "node addresses must fit in a 64-bit word");
+
+    mutable atomic<uint64_t> word_;
+
+    static node* node_of(uint64_t word) noexcept
+    {
+        return reinterpret_cast<node*>(static_cast<uintptr_t>(word & pointer_mask));
+    }
+
+    static long readers_of(uint64_t word) noexcept
+    {
+        return static_cast<long>(word >> pointer_bits);
+    }
+
+    // An empty value is stored as a null node, so it allocates nothing.
+    static uint64_t make_word(shared_ptr<T>&& value)
+    {
+        if(value.get() == nullptr && value.use_count() == 0)
+            return 0;
+        node* n = new node(std::move(value));
+        uint64_t addr = reinterpret_cast<uintptr_t>(n);
+        if((addr & ~pointer_mask) != 0)
+        {
+            // the reader count would overwrite the top of the address
+            value = std::move(n->value);
+            delete n;
+            throw std::bad_alloc();
+        }
+        return addr;
+    }
+
+    // Takes the node in an old word out of service: the readers still counted there
+    // become references, then `owned` references held by the caller are dropped.
+    static void retire(uint64_t old, long owned) noexcept
+    {
+        if(node* n = node_of(old))
+            n->adjust(readers_of(old) - owned);
+    }
+
+    static bool equivalent(const shared_ptr<T>& a, const shared_ptr<T>& b) noexcept
+    {
+        return a.get() == b.get() && !a.owner_before(b) && !b.owner_before(a);
+    }
+
+    // Registers the caller as a reader of the current node, which keeps that node alive.
+    uint64_t pin(memory_order order) const noexcept
+    {
+        return word_.fetch_add(one_reader, detail::at_least_acquire(order));
+    }
+
+    // Withdraws a pin taken on n. If n was swapped out meanwhile, the pin has
+    // become a reference and is dropped as one.
+    void unpin(node* n) const noexcept
+    {
+        uint64_t word = word_.load(memory_order_relaxed);
+        while(node_of(word) == n && readers_of(word) > 0)
+            if(word_.compare_exchange_weak(word, word - one_reader, memory_order_release, memory_order_relaxed))
+                return;
+        if(n != nullptr)
+            n->adjust(-1);
+    }
+
+public:
+    typedef shared_ptr<T> value_type;
+
+    static constexpr bool is_always_lock_free = ATOMIC_LLONG_LOCK_FREE == 2;
+
+    constexpr atomic_shared_ptr() noexcept : word_(0) {}
+    atomic_shared_ptr(shared_ptr<T> desired) : word_(make_word(std::move(desired))) {}
+
+    atomic_shared_ptr(const atomic_shared_ptr&) = delete;
+    atomic_shared_ptr& operator=(const atomic_shared_ptr&) = delete;
+
+    ~atomic_shared_ptr()
+    {
+        retire(word_.load(memory_order_relaxed), 1);
+    }
+
+    bool is_lock_free() const noexcept { return word_.is_lock_free(); }
+
+    shared_ptr<T> load(memory_order order = memory_order_seq_cst) const noexcept
+    {
+        uint64_t word = word_.load(memory_order_acquire);
+        if(word == 0)
+            return shared_ptr<T>();
+
+        node* n = node_of(pin(order));
+        shared_ptr<T> result;
+        if(n != nullptr)
+            result = n->value;
+        unpin(n);
+        return result;
+    }
+
+    operator shared_ptr<T>() const noexcept { return load(); }
+
+    void store(shared_ptr<T> desired, memory_order order = memory_order_seq_cst)
+    {
+        retire(word_.exchange(make_word(std::move(desired)), detail::at_least_acquire(order)), 1);
+    }
+
+    atomic_shared_ptr& operator=(shared_ptr<T> desired)
+    {
+        store(std::move(desired));
+        return *this;
+    }
+
+    shared_ptr<T> exchange(shared_ptr<T> desired, memory_order order = memory_order_seq_cst)
+    {
+        uint64_t old = word_.exchange(make_word(std::move(desired)), detail::at_least_acquire(order));
+        shared_ptr<T> result;
+        // pinned readers may still be copying the value, so it is copied rather than moved
+        if(node* n = node_of(old))
+            result = n->value;
+        retire(old, 1);
+        return result;
+    }
+
+    /**
+     *  Replaces the value with desired if it is equivalent to expected (same pointer
+     *  and same owner); otherwise copies the current value into expected. The node
+     *  for desired is allocated only once a match has been seen.
+    */
+    bool compare_exchange_strong(shared_ptr<T>& expected, shared_ptr<T> desired,
+        memory_order success, memory_order failure)
+    {
+        uint64_t fresh = 0;
+        bool made = false;
+        for(;;)
+        {
+            node* n = node_of(pin(failure));
+            shared_ptr<T> empty;
+            const shared_ptr<T>& current = n != nullptr ? n->value : empty;
+            if(!equivalent(current, expected))
+            {
+                expected = current;
+                unpin(n);
+                if(made)
+                    retire(fresh, 1);
+                return false;
+            }
+
+            if(!made)
+            {
+                try
+                {
+                    fresh = make_word(std::move(desired));
+                }
+                catch(...)
+                {
+                    unpin(n);
+                    throw;
+                }
+                made = true;
+            }
+
+            // still n, whatever the other readers are doing: swap it out, our own pin included
+            uint64_t word = word_.load(memory_order_relaxed);
+            while(node_of(word) == n && readers_of(word) > 0)
+                if(word_.compare_exchange_weak(word, fresh, detail::at_least_acquire(success), memory_order_relaxed))
+                {
+                    retire(word, 2);
+                    return true;
+                }
+
+            // another writer got there first; our pin became a reference
+            if(n != nullptr)
+                n->adjust(-1);
+        }
+    }
+
+    bool compare_exchange_strong(shared_ptr<T>& expected, shared_ptr<T> desired,
+        memory_order order = memory_order_seq_cst)
+    {
+        return compare_exchange_strong(expected, std::move(desired), order, order);
+    }
+
+    // Never fails spuriously; provided for the std::atomic interface.
+    bool compare_exchange_weak(shared_ptr<T>& expected, shared_ptr<T> desired,
+        memory_order success, memory_order failure)
+    {
+        return compare_exchange_strong(expected, std::move(desired), success, failure);
+    }
+
+    bool compare_exchange_weak(shared_ptr<T>& expected, shared_ptr<T> desired,
+        memory_order order = memory_order_seq_cst)
+    {
+        return compare_exchange_strong(expected, std::move(desired), order, order);
+    }
+};
+
+template<typename T>
+constexpr bool atomic_shared_ptr<T>::is_always_lock_free;
+
+MYSTD_NS_END
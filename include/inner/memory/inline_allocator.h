@@ -0,0 +1,183 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include "../compressed_pair.h"
+#include <cstddef> // size_t, max_align_t
+#include <cstdint> // uintptr_t
+#include <new> // bad_alloc
+
+
+MYSTD_NS_BEGIN
+
+using std::size_t;
+using std::max_align_t;
+using std::uintptr_t;
+
+
+/**
+ *  A fixed buffer of N bytes, usually on the stack, handed out bump-pointer style.
+ *
+ *  allocate() returns nullptr instead of throwing when the buffer is full, so the
+ *  caller can go elsewhere. deallocate() gives memory back only when it was the last
+ *  block handed out, which covers the grow-then-free-the-old-buffer pattern of
+ *  containers. The arena must outlive every allocator and container using it.
+*/
+template<size_t N, size_t Align = alignof(max_align_t)>
+class inline_arena
+{
+    static_assert(Align != 0 && (Align & (Align - 1)) == 0, "alignment must be a power of two");
+
+    alignas(Align) char buf_[N];
+    char* ptr_;
+
+public:
+    static constexpr size_t size = N;
+    static constexpr size_t alignment = Align;
+
+    inline_arena() noexcept : ptr_(buf_) {}
+
+    inline_arena(const inline_arena&) = delete;
+    inline_arena& operator=(const inline_arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align) noexcept
+    {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(ptr_) + align - 1) & ~(uintptr_t)(align - 1);
+        uintptr_t end = reinterpret_cast<uintptr_t>(buf_ + N);
+        if(p > end || bytes > end - p)
+            return nullptr;
+        ptr_ = reinterpret_cast<char*>(p + bytes);
+        return reinterpret_cast<void*>(p);
+    }
+
+    void deallocate(void* p, size_t bytes) noexcept
+    {
+        if(static_cast<char*>(p) + bytes == ptr_)
+            ptr_ = static_cast<char*>(p);
+    }
+
+    bool owns(const void* p) const noexcept
+    {
+        return buf_ <= static_cast<const char*>(p) && static_cast<const char*>(p) < buf_ + N;
+    }
+
+    size_t used() const noexcept { return static_cast<size_t>(ptr_ - buf_); }
+
+    // Makes the whole buffer available again. Nothing may still be using it.
+    void reset() noexcept { ptr_ = buf_; }
+};
+
+template<size_t N, size_t Align>
+constexpr size_t inline_arena<N, Align>::size;
+template<size_t N, size_t Align>
+constexpr size_t inline_arena<N, Align>::alignment;
+
+
+/**
+ *  An allocator that serves requests from an inline_arena and spills to the
+ *  Upstream allocator once the arena is full.
+ *
+ *  The arena belongs to one object, so the allocator never travels with a copy:
+ *  select_on_container_copy_construction() returns an allocator without an arena
+ *  (a copied container goes straight to Upstream) and none of the propagation
+ *  traits are set. Two inline_allocators compare equal only when they share the
+ *  same arena (or both have none) and their upstreams are equal.
+*/
+template<typename T, size_t N, size_t Align = alignof(max_align_t), typename Upstream = allocator<T>>
+class inline_allocator
+{
+    template<typename U, size_t M, size_t A, typename Up> friend class inline_allocator;
+
+    typedef allocator_traits<Upstream> upstream_traits;
+
+public:
+    typedef inline_arena<N, Align>  arena_type;
+    typedef Upstream                upstream_allocator_type;
+
+    typedef T               value_type;
+    typedef value_type*     pointer;
+    typedef const T*        const_pointer;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef false_type      propagate_on_container_copy_assignment;
+    typedef false_type      propagate_on_container_move_assignment;
+    typedef false_type      propagate_on_container_swap;
+    typedef false_type      is_always_equal;
+
+    static_assert(is_same<typename upstream_traits::value_type, T>::value, "Upstream must allocate T");
+    static_assert(is_same<typename upstream_traits::pointer, T*>::value, "Upstream must use raw pointers");
+
+    template<typename Other>
+    struct rebind
+    {
+        typedef inline_allocator<Other, N, Align,
+            typename upstream_traits::template rebind_alloc<Other>> other;
+    };
+
+    explicit inline_allocator(arena_type& arena, const Upstream& upstream = Upstream()) noexcept
+        : state_(&arena, upstream) {}
+    inline_allocator(const inline_allocator& other) noexcept
+        : state_(other.state_.first(), other.state_.second()) {}
+    template<typename Other, typename OtherUpstream>
+    inline_allocator(const inline_allocator<Other, N, Align, OtherUpstream>& other) noexcept
+        : state_(other.state_.first(), other.state_.second()) {}
+
+    inline_allocator& operator=(const inline_allocator&) = delete;
+
+    pointer allocate(size_type count)
+    {
+        if(count > max_size())
+            throw std::bad_alloc();
+        if(state_.first() != nullptr && alignof(T) <= Align)
+            if(void* p = state_.first()->allocate(count * sizeof(T), alignof(T)))
+                return static_cast<pointer>(p);
+        return upstream_traits::allocate(state_.second(), count);
+    }
+
+    void deallocate(pointer p, size_type count) noexcept
+    {
+        if(state_.first() != nullptr && state_.first()->owns(p))
+            state_.first()->deallocate(p, count * sizeof(T));
+        else
+            upstream_traits::deallocate(state_.second(), p, count);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return upstream_traits::max_size(state_.second());
+    }
+
+    // A copied container must not share the source's buffer.
+    inline_allocator select_on_container_copy_construction() const
+    {
+        return inline_allocator(upstream_traits::select_on_container_copy_construction(state_.second()));
+    }
+
+    // nullptr for an allocator that only uses Upstream
+    arena_type* arena() const noexcept { return state_.first(); }
+
+    const Upstream& upstream() const noexcept { return state_.second(); }
+
+private:
+    explicit inline_allocator(const Upstream& upstream) noexcept
+        : state_(nullptr, upstream) {}
+
+    // a stateless upstream takes no room next to the arena pointer
+    compressed_pair<arena_type*, Upstream> state_;
+};
+
+template<typename T1, typename U1, typename T2, typename U2, size_t N, size_t Align>
+inline bool operator==(const inline_allocator<T1, N, Align, U1>& lhs,
+    const inline_allocator<T2, N, Align, U2>& rhs) noexcept
+{
+    return lhs.arena() == rhs.arena() && lhs.upstream() == rhs.upstream();
+}
+template<typename T1, typename U1, typename T2, typename U2, size_t N, size_t Align>
+inline bool operator!=(const inline_allocator<T1, N, Align, U1>& lhs,
+    const inline_allocator<T2, N, Align, U2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+MYSTD_NS_END
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include <cstddef> // nullptr_t
+#include <utility> // swap
+
+
+MYSTD_NS_BEGIN
+
+/**
+ *  A shared pointer to an object that keeps its own reference count. The handle is
+ *  a single pointer and needs no control block, so nothing is allocated beside the
+ *  object and the count sits on the object's own cache lines.
+ *
+ *  The count is managed through two functions found by argument-dependent lookup:
+ *
+ *      void intrusive_ptr_add_ref(T* p);
+ *      void intrusive_ptr_release(T* p);   // frees *p when the count reaches zero
+ *
+ *  Deriving from intrusive_ref_counter provides both.
+*/
+template<typename T>
+class intrusive_ptr
+{
+    template<typename Y> friend class intrusive_ptr;
+
+    T* ptr_;
+
+    template<typename Y>
+    using _Compatible = enable_if_t<is_convertible_v<Y*, T*>>;
+
+public:
+    typedef T element_type;
+
+    constexpr intrusive_ptr() noexcept : ptr_(nullptr) {}
+    constexpr intrusive_ptr(nullptr_t) noexcept : ptr_(nullptr) {}
+
+    // With add_ref == false the pointer takes over a reference the caller already holds.
+    intrusive_ptr(T* p, bool add_ref = true) : ptr_(p)
+    {
+        if(ptr_ != nullptr && add_ref)
+            intrusive_ptr_add_ref(ptr_);
+    }
+
+    intrusive_ptr(const intrusive_ptr& r) : ptr_(r.ptr_)
+    {
+        if(ptr_ != nullptr)
+            intrusive_ptr_add_ref(ptr_);
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    intrusive_ptr(const intrusive_ptr<Y>& r) : ptr_(r.ptr_)
+    {
+        if(ptr_ != nullptr)
+            intrusive_ptr_add_ref(ptr_);
+    }
+
+    intrusive_ptr(intrusive_ptr&& r) noexcept : ptr_(r.ptr_)
+    {
+        r.ptr_ = nullptr;
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    intrusive_ptr(intrusive_ptr<Y>&& r) noexcept : ptr_(r.ptr_)
+    {
+        r.ptr_ = nullptr;
+    }
+
+    ~intrusive_ptr()
+    {
+        if(ptr_ != nullptr)
+            intrusive_ptr_release(ptr_);
+    }
+
+    intrusive_ptr& operator=(const intrusive_ptr& r)
+    {
+        intrusive_ptr(r).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    intrusive_ptr& operator=(const intrusive_ptr<Y>& r)
+    {
+        intrusive_ptr(r).swap(*this);
+        return *this;
+    }
+
+    intrusive_ptr& operator=(intrusive_ptr&& r) noexcept
+    {
+        intrusive_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    intrusive_ptr& operator=(intrusive_ptr<Y>&& r) noexcept
+    {
+        intrusive_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    intrusive_ptr& operator=(T* p)
+    {
+        intrusive_ptr(p).swap(*this);
+        return *this;
+    }
+
+    void reset() { intrusive_ptr().swap(*this); }
+    void reset(T* p) { intrusive_ptr(p).swap(*this); }
+    void reset(T* p, bool add_ref) { intrusive_ptr(p, add_ref).swap(*this); }
+
+    // Gives up the pointer without releasing it; the caller now owns that reference.
+    T* detach() noexcept
+    {
+        T* p = ptr_;
+        ptr_ = nullptr;
+        return p;
+    }
+
+    void swap(intrusive_ptr& r) noexcept { std::swap(ptr_, r.ptr_); }
+
+    T* get() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+};
+
+template<typename T>
+inline void swap(intrusive_ptr<T>& a, intrusive_ptr<T>& b) noexcept { a.swap(b); }
+
+template<typename T>
+struct is_trivially_relocatable<intrusive_ptr<T>> : true_type {};
+
+template<typename T, typename U>
+inline bool operator==(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) noexcept { return a.get() == b.get(); }
+template<typename T, typename U>
+inline bool operator!=(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) noexcept { return a.get() != b.get(); }
+template<typename T, typename U>
+inline bool operator<(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) noexcept { return a.get() < b.get(); }
+template<typename T>
+inline bool operator==(const intrusive_ptr<T>& a, nullptr_t) noexcept { return !a; }
+template<typename T>
+inline bool operator==(nullptr_t, const intrusive_ptr<T>& a) noexcept { return !a; }
+template<typename T>
+inline bool operator!=(const intrusive_ptr<T>& a, nullptr_t) noexcept { return bool(a); }
+template<typename T>
+inline bool operator!=(nullptr_t, const intrusive_ptr<T>& a) noexcept { return bool(a); }
+
+template<typename T, typename U>
+inline intrusive_ptr<T> static_pointer_cast(const intrusive_ptr<U>& r)
+{
+    return intrusive_ptr<T>(static_cast<T*>(r.get()));
+}
+
+template<typename T, typename U>
+inline intrusive_ptr<T> const_pointer_cast(const intrusive_ptr<U>& r)
+{
+    return intrusive_ptr<T>(const_cast<T*>(r.get()));
+}
+
+template<typename T, typename U>
+inline intrusive_ptr<T> dynamic_pointer_cast(const intrusive_ptr<U>& r)
+{
+    return intrusive_ptr<T>(dynamic_cast<T*>(r.get()));
+}
+
+
+// Counter policy for objects shared between threads.
+struct thread_safe_counter
+{
+    typedef atomic<unsigned long> type;
+
+    static unsigned long load(const type& count) noexcept { return count.load(memory_order_acquire); }
+    static void increment(type& count) noexcept { count.fetch_add(1, memory_order_relaxed); }
+    static unsigned long decrement(type& count) noexcept { return count.fetch_sub(1, memory_order_acq_rel) - 1; }
+};
+
+// Counter policy for objects that never leave one thread.
+struct thread_unsafe_counter
+{
+    typedef unsigned long type;
+
+    static unsigned long load(const type& count) noexcept { return count; }
+    static void increment(type& count) noexcept { ++count; }
+    static unsigned long decrement(type& count) noexcept { return --count; }
+};
+
+template<typename Derived, typename CounterPolicy = thread_safe_counter>
+class intrusive_ref_counter;
+
+template<typename Derived, typename CounterPolicy>
+inline void intrusive_ptr_add_ref(const intrusive_ref_counter<Derived, CounterPolicy>* p) noexcept;
+template<typename Derived, typename CounterPolicy>
+inline void intrusive_ptr_release(const intrusive_ref_counter<Derived, CounterPolicy>* p) noexcept;
+
+/**
+ *  A base class that gives Derived a reference count and the two intrusive_ptr
+ *  hooks. The last release deletes the object as a Derived, so Derived needs no
+ *  virtual destructor. Copying an object does not copy its count.
+*/
+template<typename Derived, typename CounterPolicy>
+class intrusive_ref_counter
+{
+    friend void intrusive_ptr_add_ref<Derived, CounterPolicy>(const intrusive_ref_counter* p) noexcept;
+    friend void intrusive_ptr_release<Derived, CounterPolicy>(const intrusive_ref_counter* p) noexcept;
+
+    mutable typename CounterPolicy::type count_;
+
+public:
+    intrusive_ref_counter() noexcept : count_(0) {}
+    intrusive_ref_counter(const intrusive_ref_counter&) noexcept : count_(0) {}
+    intrusive_ref_counter& operator=(const intrusive_ref_counter&) noexcept { return *this; }
+
+    unsigned long use_count() const noexcept { return CounterPolicy::load(count_); }
+
+protected:
+    ~intrusive_ref_counter() = default;
+};
+
+template<typename Derived, typename CounterPolicy>
+inline void intrusive_ptr_add_ref(const intrusive_ref_counter<Derived, CounterPolicy>* p) noexcept
+{
+    CounterPolicy::increment(p->count_);
+}
+
+template<typename Derived, typename CounterPolicy>
+inline void intrusive_ptr_release(const intrusive_ref_counter<Derived, CounterPolicy>* p) noexcept
+{
+    if(CounterPolicy::decrement(p->count_) == 0)
+        delete static_cast<const Derived*>(p);
+}
+
+MYSTD_NS_END
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "shared_ptr.h"
+#include <cstddef> // nullptr_t
+#include <functional> // reference_wrapper
+#include <utility> // move, forward, swap
+
+
+MYSTD_NS_BEGIN
+
+/**
+ *  Shared ownership for objects that never leave one thread. It works like
+ *  shared_ptr, but the reference counts are plain integers, so a copy is an
+ *  increment rather than a locked instruction.
+ *
+ *  Copying or releasing local_shared_ptrs to the same object from two threads is a
+ *  data race. To keep that from happening silently, local_shared_ptr and
+ *  shared_ptr do not convert to each other in either direction. There is no
+ *  weak_ptr counterpart.
+*/
+template<typename T>
+class local_shared_ptr
+{
+    template<typename Y> friend class local_shared_ptr;
+    template<typename Y, typename Alloc, typename... Args>
+    friend local_shared_ptr<Y> allocate_local_shared(const Alloc& alloc, Args&&... args);
+
+    typedef detail::basic_control_block<detail::shared_count_local> control_block;
+
+    T*              ptr_;
+    control_block*  ctrl_;
+
+    template<typename Y>
+    using _Compatible = enable_if_t<is_convertible_v<Y*, T*>>;
+
+    // adopts a block that already counts this reference
+    local_shared_ptr(detail::shared_adopt_t, T* p, control_block* ctrl) noexcept : ptr_(p), ctrl_(ctrl) {}
+
+    template<typename Y, typename Deleter, typename Alloc>
+    void adopt(Y* p, Deleter d, const Alloc& a)
+    {
+        ctrl_ = detail::shared_pointer_block<Y*, Deleter, Alloc, detail::shared_count_local>::create(p, std::move(d), a);
+        ptr_ = p;
+    }
+
+public:
+    typedef T element_type;
+
+    constexpr local_shared_ptr() noexcept : ptr_(nullptr), ctrl_(nullptr) {}
+    constexpr local_shared_ptr(nullptr_t) noexcept : ptr_(nullptr), ctrl_(nullptr) {}
+
+    template<typename Y, typename = _Compatible<Y>>
+    explicit local_shared_ptr(Y* p) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        adopt(p, default_delete<Y>(), allocator<Y>());
+    }
+
+    template<typename Y, typename Deleter, typename = _Compatible<Y>>
+    local_shared_ptr(Y* p, Deleter d) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        adopt(p, std::move(d), allocator<Y>());
+    }
+
+    template<typename Y, typename Deleter, typename Alloc, typename = _Compatible<Y>>
+    local_shared_ptr(Y* p, Deleter d, Alloc a) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        adopt(p, std::move(d), a);
+    }
+
+    // Aliasing constructor: shares r's ownership but points at p.
+    template<typename Y>
+    local_shared_ptr(const local_shared_ptr<Y>& r, element_type* p) noexcept : ptr_(p), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->add_ref();
+    }
+
+    local_shared_ptr(const local_shared_ptr& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->add_ref();
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    local_shared_ptr(const local_shared_ptr<Y>& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->add_ref();
+    }
+
+    local_shared_ptr(local_shared_ptr&& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        r.ptr_ = nullptr;
+        r.ctrl_ = nullptr;
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    local_shared_ptr(local_shared_ptr<Y>&& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        r.ptr_ = nullptr;
+        r.ctrl_ = nullptr;
+    }
+
+    template<typename Y, typename Deleter, typename = _Compatible<typename unique_ptr<Y, Deleter>::element_type>>
+    local_shared_ptr(unique_ptr<Y, Deleter>&& r) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        typedef conditional_t<is_reference_v<Deleter>,
+            std::reference_wrapper<remove_reference_t<Deleter>>, Deleter> stored_deleter;
+        if(r.get() == nullptr)
+            return;
+        adopt(r.get(), stored_deleter(r.get_deleter()), allocator<Y>());
+        r.release();
+    }
+
+    // Sharing with the thread-safe family would let plain counts be updated from several threads.
+    template<typename Y>
+    local_shared_ptr(const shared_ptr<Y>&) = delete;
+    template<typename Y>
+    local_shared_ptr(const weak_ptr<Y>&) = delete;
+
+    ~local_shared_ptr()
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->release();
+    }
+
+    local_shared_ptr& operator=(const local_shared_ptr& r) noexcept
+    {
+        local_shared_ptr(r).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    local_shared_ptr& operator=(const local_shared_ptr<Y>& r) noexcept
+    {
+        local_shared_ptr(r).swap(*this);
+        return *this;
+    }
+
+    local_shared_ptr& operator=(local_shared_ptr&& r) noexcept
+    {
+        local_shared_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    local_shared_ptr& operator=(local_shared_ptr<Y>&& r) noexcept
+    {
+        local_shared_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    template<typename Y, typename Deleter>
+    local_shared_ptr& operator=(unique_ptr<Y, Deleter>&& r)
+    {
+        local_shared_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { local_shared_ptr().swap(*this); }
+
+    template<typename Y>
+    void reset(Y* p) { local_shared_ptr(p).swap(*this); }
+
+    template<typename Y, typename Deleter>
+    void reset(Y* p, Deleter d) { local_shared_ptr(p, std::move(d)).swap(*this); }
+
+    void swap(local_shared_ptr& r) noexcept
+    {
+        std::swap(ptr_, r.ptr_);
+        std::swap(ctrl_, r.ctrl_);
+    }
+
+    element_type* get() const noexcept { return ptr_; }
+
+    template<typename U = T>
+    enable_if_t<!is_void<U>::value, U&> operator*() const noexcept { return *ptr_; }
+
+    element_type* operator->() const noexcept { return ptr_; }
+
+    long use_count() const noexcept { return ctrl_ == nullptr ? 0 : ctrl_->use_count(); }
+
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    template<typename Y>
+    bool owner_before(const local_shared_ptr<Y>& other) const noexcept { return ctrl_ < other.ctrl_; }
+};
+
+
+// allocate_shared for local_shared_ptr: one allocation from alloc, rebound to the block.
+template<typename T, typename Alloc, typename... Args>
+inline local_shared_ptr<T> allocate_local_shared(const Alloc& alloc, Args&&... args)
+{
+    typedef detail::shared_inplace_block<T, Alloc, detail::shared_count_local> block_type;
+    block_type* block = block_type::create(alloc, std::forward<Args>(args)...);
+    return local_shared_ptr<T>(detail::shared_adopt_t(), block->object(), block);
+}
+
+template<typename T, typename... Args>
+inline local_shared_ptr<T> make_local_shared(Args&&... args)
+{
+    return allocate_local_shared<T>(allocator<T>(), std::forward<Args>(args)...);
+}
+
+
+template<typename T, typename U>
+inline local_shared_ptr<T> static_pointer_cast(const local_shared_ptr<U>& r) noexcept
+{
+    return local_shared_ptr<T>(r, static_cast<T*>(r.get()));
+}
+
+template<typename T, typename U>
+inline local_shared_ptr<T> const_pointer_cast(const local_shared_ptr<U>& r) noexcept
+{
+    return local_shared_ptr<T>(r, const_cast<T*>(r.get()));
+}
+
+template<typename T, typename U>
+inline local_shared_ptr<T> dynamic_pointer_cast(const local_shared_ptr<U>& r) noexcept
+{
+    if(T* p = dynamic_cast<T*>(r.get()))
+        return local_shared_ptr<T>(r, p);
+    return local_shared_ptr<T>();
+}
+
+
+template<typename T>
+inline void swap(local_shared_ptr<T>& a, local_shared_ptr<T>& b) noexcept { a.swap(b); }
+
+template<typename T>
+struct is_trivially_relocatable<local_shared_ptr<T>> : true_type {};
+
+template<typename T, typename U>
+inline bool operator==(const local_shared_ptr<T>& a, const local_shared_ptr<U>& b) noexcept { return a.get() == b.get(); }
+template<typename T, typename U>
+inline bool operator!=(const local_shared_ptr<T>& a, const local_shared_ptr<U>& b) noexcept { return a.get() != b.get(); }
+template<typename T, typename U>
+inline bool operator<(const local_shared_ptr<T>& a, const local_shared_ptr<U>& b) noexcept { return a.get() < b.get(); }
+template<typename T>
+inline bool operator==(const local_shared_ptr<T>& a, nullptr_t) noexcept { return !a; }
+template<typename T>
+inline bool operator==(nullptr_t, const local_shared_ptr<T>& a) noexcept { return !a; }
+template<typename T>
+inline bool operator!=(const local_shared_ptr<T>& a, nullptr_t) noexcept { return bool(a); }
+template<typename T>
+inline bool operator!=(nullptr_t, const local_shared_ptr<T>& a) noexcept { return bool(a); }
+
+MYSTD_NS_END
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include "offset_ptr.h"
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <cerrno> // errno
+#include <new> // bad_alloc
+#include <stdexcept> // runtime_error, invalid_argument
+#include <system_error> // system_error
+#include <utility> // forward
+
+#if defined(_WIN32)
+#  error "mapped_file_allocator is only implemented for POSIX systems"
+#else
+#  include <sys/mman.h> // mmap, munmap, msync
+#  include <sys/stat.h> // fstat
+#  include <fcntl.h> // open
+#  include <unistd.h> // ftruncate, close
+#endif
+
+
+MYSTD_NS_BEGIN
+
+using std::size_t;
+using std::uint64_t;
+
+
+/**
+ *  The bookkeeping at the start of a mapped file. Everything in it is an offset from
+ *  the segment itself, so it stays valid wherever the file is mapped.
+ *
+ *  Blocks are power-of-two sized (16 bytes and up) with a 16-byte header recording
+ *  their class; freed blocks go to a per-class free list and new ones are bumped from
+ *  the unused tail of the file. The capacity is fixed when the file is created.
+*/
+class mapped_segment
+{
+public:
+    static constexpr uint64_t magic_value = 0x6d79737464736567ULL; // "mystdseg"
+    static constexpr size_t class_count = 48;
+    static constexpr size_t block_header_size = 16;
+    static constexpr size_t min_block_size = 16;
+
+    // The smallest capacity that holds the header and one block.
+    static size_t min_capacity() noexcept
+    {
+        return first_block_offset() + block_header_size + min_block_size;
+    }
+
+    // Lays a fresh segment over `capacity` bytes of zeroed memory, at least min_capacity().
+    static mapped_segment* create(void* memory, size_t capacity) noexcept
+    {
+        mapped_segment* s = static_cast<mapped_segment*>(memory);
+        s->magic = magic_value;
+        s->capacity = capacity;
+        s->used = first_block_offset();
+        s->root = 0;
+        for(size_t i = 0; i < class_count; ++i)
+            s->free_heads[i] = 0;
+        return s;
+    }
+
+    // Checks the header of an existing segment; nullptr if it is not one of ours.
+    static mapped_segment* open(void* memory, size_t size) noexcept
+    {
+        mapped_segment* s = static_cast<mapped_segment*>(memory);
+        if(size < sizeof(mapped_segment) || s->magic != magic_value || s->capacity != size)
+            return nullptr;
+        return s;
+    }
+
+    void* allocate(size_t bytes)
+    {
+        size_t cls = size_class(bytes);
+        if(cls == class_count)
+            throw std::bad_alloc();
+        if(free_heads[cls] != 0)
+        {
+            char* block = base() + free_heads[cls];
+            free_heads[cls] = *reinterpret_cast<uint64_t*>(block + block_header_size);
+            return block + block_header_size;
+        }
+        size_t block_size = block_header_size + (min_block_size << cls);
+        if(block_size > capacity - used)
+            throw std::bad_alloc();
+        char* block = base() + used;
+        used += block_size;
+        *reinterpret_cast<uint64_t*>(block) = cls;
+        return block + block_header_size;
+    }
+
+    void deallocate(void* p) noexcept
+    {
+        char* block = static_cast<char*>(p) - block_header_size;
+        size_t cls = (size_t)*reinterpret_cast<uint64_t*>(block);
+        *reinterpret_cast<uint64_t*>(p) = free_heads[cls];
+        free_heads[cls] = block - base();
+    }
+
+    void* root_object() noexcept { return root == 0 ? nullptr : base() + root; }
+    void set_root_object(void* p) noexcept { root = p == nullptr ? 0 : static_cast<char*>(p) - base(); }
+
+    size_t size() const noexcept { return (size_t)capacity; }
+    size_t bytes_used() const noexcept { return (size_t)used; }
+
+private:
+    static size_t first_block_offset() noexcept
+    {
+        return (sizeof(mapped_segment) + 15) & ~(size_t)15;
+    }
+
+    static size_t size_class(size_t bytes) noexcept
+    {
+        size_t cls = 0;
+        while(cls < class_count && (min_block_size << cls) < bytes)
+            ++cls;
+        return cls;
+    }
+
+    char* base() noexcept { return reinterpret_cast<char*>(this); }
+
+    uint64_t magic;
+    uint64_t capacity;
+    uint64_t used;
+    uint64_t root;
+    uint64_t free_heads[class_count];
+};
+
+
+/**
+ *  An allocator whose pointer type is offset_ptr<T> and whose memory comes from a
+ *  mapped_segment. It stores an offset_ptr to the segment, so a container that lives
+ *  inside the file (allocator included) can be used again after the file is reopened
+ *  at another address, without any deserialization.
+*/
+template<typename T>
+class mapped_file_allocator
+{
+    template<typename U> friend class mapped_file_allocator;
+
+    offset_ptr<mapped_segment> segment_;
+
+public:
+    typedef T                       value_type;
+    typedef offset_ptr<T>           pointer;
+    typedef offset_ptr<const T>     const_pointer;
+    typedef offset_ptr<void>        void_pointer;
+    typedef offset_ptr<const void>  const_void_pointer;
+    typedef size_t                  size_type;
+    typedef ptrdiff_t               difference_type;
+    typedef true_type               propagate_on_container_copy_assignment;
+    typedef true_type               propagate_on_container_move_assignment;
+    typedef true_type               propagate_on_container_swap;
+    typedef false_type              is_always_equal;
+
+    template<typename Other>
+    struct rebind { typedef mapped_file_allocator<Other> other; };
+
+    mapped_file_allocator(mapped_segment& segment) noexcept : segment_(&segment) {}
+    mapped_file_allocator(const mapped_file_allocator& other) noexcept : segment_(other.segment_) {}
+    template<typename Other>
+    mapped_file_allocator(const mapped_file_allocator<Other>& other) noexcept : segment_(other.segment_) {}
+
+    mapped_file_allocator& operator=(const mapped_file_allocator& other) noexcept
+    {
+        segment_ = other.segment_;
+        return *this;
+    }
+
+    pointer allocate(size_type count)
+    {
+        static_assert(alignof(T) <= mapped_segment::block_header_size, "over-aligned types are not supported");
+        if(count > max_size())
+            throw std::bad_alloc();
+        return pointer(static_cast<T*>(segment_->allocate(count * sizeof(T))));
+    }
+
+    void deallocate(pointer p, size_type) noexcept
+    {
+        if(p)
+            segment_->deallocate(p.get());
+    }
+
+    size_type max_size() const noexcept
+    {
+        return segment_->size() / sizeof(T);
+    }
+
+    mapped_segment& segment() const noexcept { return *segment_; }
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const mapped_file_allocator<T1>& a, const mapped_file_allocator<T2>& b) noexcept
+{
+    return &a.segment() == &b.segment();
+}
+template<typename T1, typename T2>
+inline bool operator!=(const mapped_file_allocator<T1>& a, const mapped_file_allocator<T2>& b) noexcept
+{
+    return !(a == b);
+}
+
+
+/**
+ *  A file mapped shared into memory and managed as a mapped_segment.
+ *
+ *  Opening a file that does not exist creates it with the given capacity, which must be
+ *  at least mapped_segment::min_capacity(); opening an existing one maps it as it is (the
+ *  capacity argument is then ignored). Objects are reached again through a single root
+ *  object, see find_or_construct_root().
+*/
+class mapped_file
+{
+    int             fd_;
+    void*           base_;
+    size_t          size_;
+    mapped_segment* segment_;
+    bool            created_;
+
+public:
+    mapped_file(const char* path, size_t capacity)
+        : fd_(-1), base_(nullptr), size_(0), segment_(nullptr), created_(false)
+    {
+        fd_ = ::open(path, O_RDWR | O_CREAT, 0644);
+        if(fd_ < 0)
+            throw std::system_error(errno, std::generic_category(), "mapped_file: open");
+
+        struct stat st;
+        if(::fstat(fd_, &st) != 0)
+            fail("mapped_file: fstat");
+        created_ = st.st_size == 0;
+        if(created_ && capacity < mapped_segment::min_capacity())
+        {
+            close();
+            throw std::invalid_argument("mapped_file: capacity too small for the segment header");
+        }
+        size_ = created_ ? capacity : (size_t)st.st_size;
+        if(created_ && ::ftruncate(fd_, (off_t)size_) != 0)
+            fail("mapped_file: ftruncate");
+
+        base_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if(base_ == MAP_FAILED)
+        {
+            base_ = nullptr;
+            fail("mapped_file: mmap");
+        }
+
+        segment_ = created_ ? mapped_segment::create(base_, size_) : mapped_segment::open(base_, size_);
+        if(segment_ == nullptr)
+        {
+            close();
+            throw std::runtime_error("mapped_file: not a mystd mapped segment");
+        }
+    }
+
+    ~mapped_file() { close(); }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    // True when this open created the file.
+    bool created() const noexcept { return created_; }
+
+    mapped_segment& segment() const noexcept { return *segment_; }
+
+    template<typename T>
+    mapped_file_allocator<T> get_allocator() const noexcept
+    {
+        return mapped_file_allocator<T>(*segment_);
+    }
+
+    /**
+     *  Returns the root object of the file, constructing it in the file from args the
+     *  first time. The caller must ask for the same T every time the file is opened.
+     */
+    template<typename T, typename... Args>
+    T* find_or_construct_root(Args&&... args)
+    {
+        if(void* root = segment_->root_object())
+            return static_cast<T*>(root);
+        T* p = get_allocator<T>().allocate(1).get();
+        ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+        segment_->set_root_object(p);
+        return p;
+    }
+
+    // Writes dirty pages back to the file.
+    void flush()
+    {
+        if(base_ != nullptr && ::msync(base_, size_, MS_SYNC) != 0)
+            throw std::system_error(errno, std::generic_category(), "mapped_file: msync");
+    }
+
+private:
+    void close() noexcept
+    {
+        if(base_ != nullptr)
+            ::munmap(base_, size_);
+        if(fd_ >= 0)
+            ::close(fd_);
+        base_ = nullptr;
+        fd_ = -1;
+    }
+
+    void fail(const char* what)
+    {
+        int err = errno;
+        close();
+        throw std::system_error(err, std::generic_category(), what);
+    }
+};
+
+MYSTD_NS_END
@@ -0,0 +1,593 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include <cstddef> // size_t, max_align_t
+#include <cstdint> // uintptr_t
+#include <new> // operator new, bad_alloc
+#include <atomic> // atomic
+#include <mutex> // mutex, lock_guard
+
+
+MYSTD_NS_BEGIN
+
+namespace pmr {
+
+using std::size_t;
+using std::max_align_t;
+using std::uintptr_t;
+
+
+/**
+ *  Abstract interface to an allocation strategy. Containers that allocate through
+ *  polymorphic_allocator can be switched between resources at run time without
+ *  changing their type.
+*/
+class memory_resource
+{
+public:
+    virtual ~memory_resource() {}
+
+    void* allocate(size_t bytes, size_t alignment = alignof(max_align_t))
+    {
+        return do_allocate(bytes, alignment);
+    }
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(max_align_t))
+    {
+        do_deallocate(p, bytes, alignment);
+    }
+    bool is_equal(const memory_resource& other) const noexcept
+    {
+        return do_is_equal(other);
+    }
+
+private:
+    virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+    virtual void do_deallocate(void* p, size_t bytes, size_t alignment) = 0;
+    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource& a, const memory_resource& b) noexcept
+{
+    return &a == &b || a.is_equal(b);
+}
+inline bool operator!=(const memory_resource& a, const memory_resource& b) noexcept
+{
+    return !(a == b);
+}
+
+
+namespace detail {
+
+inline size_t align_up(size_t n, size_t alignment) noexcept
+{
+    return (n + alignment - 1) & ~(alignment - 1);
+}
+
+inline void* align_up(void* p, size_t alignment) noexcept
+{
+    return reinterpret_cast<void*>(align_up(reinterpret_cast<uintptr_t>(p), alignment));
+}
+
+class new_delete_resource_impl : public memory_resource
+{
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        return mystd::detail::allocate_bytes(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        mystd::detail::deallocate_bytes(p, bytes, alignment);
+    }
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+class null_memory_resource_impl : public memory_resource
+{
+    void* do_allocate(size_t, size_t) override { throw std::bad_alloc(); }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+inline std::atomic<memory_resource*>& default_resource_slot() noexcept;
+
+} // namespace detail
+
+
+// A resource that uses ::operator new and ::operator delete.
+inline memory_resource* new_delete_resource() noexcept
+{
+    static detail::new_delete_resource_impl resource;
+    return &resource;
+}
+
+// A resource whose allocate() always throws bad_alloc.
+inline memory_resource* null_memory_resource() noexcept
+{
+    static detail::null_memory_resource_impl resource;
+    return &resource;
+}
+
+namespace detail {
+inline std::atomic<memory_resource*>& default_resource_slot() noexcept
+{
+    static std::atomic<memory_resource*> slot(new_delete_resource());
+    return slot;
+}
+} // namespace detail
+
+inline memory_resource* get_default_resource() noexcept
+{
+    return detail::default_resource_slot().load(std::memory_order_acquire);
+}
+
+// Sets the default resource (new_delete_resource() for nullptr) and returns the previous one.
+inline memory_resource* set_default_resource(memory_resource* r) noexcept
+{
+    if(r == nullptr)
+        r = new_delete_resource();
+    return detail::default_resource_slot().exchange(r, std::memory_order_acq_rel);
+}
+
+
+/**
+ *  A stateful allocator that forwards to a memory_resource.
+ *  Copying a container does not propagate the resource: the copy uses the default one.
+*/
+template<typename T>
+class polymorphic_allocator
+{
+    template<typename U> friend class polymorphic_allocator;
+
+    memory_resource* resource_;
+
+public:
+    typedef T               value_type;
+    typedef value_type*     pointer;
+    typedef const T*        const_pointer;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+
+    template<typename Other>
+    struct rebind { typedef polymorphic_allocator<Other> other; };
+
+    polymorphic_allocator() noexcept : resource_(get_default_resource()) {}
+    polymorphic_allocator(memory_resource* r) noexcept : resource_(r) {}
+    polymorphic_allocator(const polymorphic_allocator& other) = default;
+    template<typename Other>
+    polymorphic_allocator(const polymorphic_allocator<Other>& other) noexcept
+        : resource_(other.resource_) {}
+
+    polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+    pointer allocate(size_type count)
+    {
+        if(count > max_size())
+            throw std::bad_alloc();
+        return static_cast<pointer>(resource_->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer p, size_type count)
+    {
+        resource_->deallocate(p, count * sizeof(T), alignof(T));
+    }
+
+    size_type max_size() const noexcept
+    {
+        return (size_type)(-1) / sizeof(T);
+    }
+
+    // Elements that take an allocator are given this one, so nested containers share the resource.
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        uninitialized_construct_using_allocator(p, *this, forward<Args>(args)...);
+    }
+
+    polymorphic_allocator select_on_container_copy_construction() const
+    {
+        return polymorphic_allocator();
+    }
+
+    memory_resource* resource() const noexcept { return resource_; }
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const polymorphic_allocator<T1>& a, const polymorphic_allocator<T2>& b) noexcept
+{
+    return *a.resource() == *b.resource();
+}
+template<typename T1, typename T2>
+inline bool operator!=(const polymorphic_allocator<T1>& a, const polymorphic_allocator<T2>& b) noexcept
+{
+    return !(a == b);
+}
+
+
+/**
+ *  Serves allocations by bumping a pointer through an optional initial buffer (for
+ *  example one on the stack), then through geometrically growing blocks taken from
+ *  the upstream resource. deallocate() is a no-op; release() returns every block.
+*/
+class monotonic_buffer_resource : public memory_resource
+{
+    struct block_header
+    {
+        block_header*   next;
+        size_t          size;
+    };
+
+    memory_resource*    upstream_;
+    void*               initial_buffer_;
+    size_t              initial_size_;
+    block_header*       blocks_;
+    char*               cur_;
+    size_t              space_;
+    size_t              next_block_size_;
+
+    static constexpr size_t min_block_size = 64;
+
+public:
+    static constexpr size_t default_block_size = 1024;
+
+    explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource())
+        : monotonic_buffer_resource(nullptr, 0, default_block_size, upstream) {}
+
+    monotonic_buffer_resource(size_t initial_size, memory_resource* upstream = get_default_resource())
+        : monotonic_buffer_resource(nullptr, 0, initial_size, upstream) {}
+
+    monotonic_buffer_resource(void* buffer, size_t buffer_size,
+            memory_resource* upstream = get_default_resource())
+        : monotonic_buffer_resource(buffer, buffer_size, buffer_size * 2, upstream) {}
+
+    ~monotonic_buffer_resource() { release(); }
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    // Returns every block to upstream; the initial buffer is reused from its start.
+    void release() noexcept
+    {
+        while(blocks_ != nullptr)
+        {
+            block_header* next = blocks_->next;
+            upstream_->deallocate(blocks_, blocks_->size, alignof(max_align_t));
+            blocks_ = next;
+        }
+        cur_ = static_cast<char*>(initial_buffer_);
+        space_ = initial_buffer_ != nullptr ? initial_size_ : 0;
+        next_block_size_ = initial_buffer_ != nullptr ? initial_size_ * 2 : initial_size_;
+        if(next_block_size_ < min_block_size)
+            next_block_size_ = min_block_size;
+    }
+
+    memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+private:
+    monotonic_buffer_resource(void* buffer, size_t buffer_size, size_t next_size,
+            memory_resource* upstream)
+        : upstream_(upstream), initial_buffer_(buffer), initial_size_(buffer != nullptr ? buffer_size : next_size),
+        blocks_(nullptr), cur_(nullptr), space_(0), next_block_size_(0)
+    {
+        release();
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* p = detail::align_up(cur_, alignment);
+        size_t padding = static_cast<char*>(p) - cur_;
+        if(cur_ == nullptr || padding > space_ || bytes > space_ - padding)
+        {
+            const size_t max_size = (size_t)(-1);
+            if(bytes > max_size - sizeof(block_header) - alignment)
+                throw std::bad_alloc();
+            size_t need = sizeof(block_header) + bytes + alignment;
+            size_t size = next_block_size_;
+            while(size < need)
+                size = size > max_size / 2 ? need : size * 2; // doubling would wrap around
+            block_header* block = static_cast<block_header*>(
+                upstream_->allocate(size, alignof(max_align_t)));
+            block->next = blocks_;
+            block->size = size;
+            blocks_ = block;
+            cur_ = reinterpret_cast<char*>(block + 1);
+            space_ = size - sizeof(block_header);
+            next_block_size_ = size > max_size / 2 ? size : size * 2;
+
+            p = detail::align_up(cur_, alignment);
+            padding = static_cast<char*>(p) - cur_;
+        }
+        cur_ += padding + bytes;
+        space_ -= padding + bytes;
+        return p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+
+struct pool_options
+{
+    size_t max_blocks_per_chunk = 0;        // 0: implementation default
+    size_t largest_required_pool_block = 0; // 0: implementation default
+};
+
+
+/**
+ *  A resource that keeps one free list per power-of-two block size. Blocks come from
+ *  chunks obtained from upstream; requests larger than the largest pool (or more
+ *  aligned than a block) go straight to upstream. Not thread safe.
+*/
+class unsynchronized_pool_resource : public memory_resource
+{
+    struct free_block
+    {
+        free_block* next;
+    };
+    struct chunk_header
+    {
+        chunk_header*   next;
+        size_t          size;
+    };
+    struct oversized_header
+    {
+        oversized_header*   prev;
+        oversized_header*   next;
+        size_t              size;
+        size_t              alignment;
+    };
+    struct pool
+    {
+        free_block*     free;
+        chunk_header*   chunks;
+        size_t          next_chunk_blocks;
+    };
+
+    static constexpr size_t min_block_size = 8;
+    static constexpr size_t max_pool_count = 16; // 8 bytes .. 256 KiB
+    static constexpr size_t default_largest_block = 4096;
+    static constexpr size_t default_max_blocks_per_chunk = 1024;
+    static constexpr size_t first_chunk_blocks = 16;
+
+    memory_resource*    upstream_;
+    pool_options        options_;
+    size_t              pool_count_;
+    pool                pools_[max_pool_count];
+    oversized_header*   oversized_;
+
+public:
+    unsynchronized_pool_resource()
+        : unsynchronized_pool_resource(pool_options(), get_default_resource()) {}
+    explicit unsynchronized_pool_resource(memory_resource* upstream)
+        : unsynchronized_pool_resource(pool_options(), upstream) {}
+    explicit unsynchronized_pool_resource(const pool_options& opts)
+        : unsynchronized_pool_resource(opts, get_default_resource()) {}
+
+    unsynchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+        : upstream_(upstream), options_(opts), pool_count_(0), oversized_(nullptr)
+    {
+        if(options_.max_blocks_per_chunk == 0)
+            options_.max_blocks_per_chunk = default_max_blocks_per_chunk;
+        if(options_.largest_required_pool_block == 0)
+            options_.largest_required_pool_block = default_largest_block;
+
+        // larger requests than the last pool's blocks go straight to upstream
+        size_t block = min_block_size;
+        for(pool_count_ = 1; pool_count_ < max_pool_count && block < options_.largest_required_pool_block; ++pool_count_)
+            block *= 2;
+        options_.largest_required_pool_block = block;
+
+        for(size_t i = 0; i < max_pool_count; ++i)
+        {
+            pools_[i].free = nullptr;
+            pools_[i].chunks = nullptr;
+            pools_[i].next_chunk_blocks = first_chunk_blocks;
+        }
+    }
+
+    ~unsynchronized_pool_resource() { release(); }
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+    unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+    // Returns all memory to upstream, whether or not it was deallocated.
+    void release() noexcept
+    {
+        for(size_t i = 0; i < pool_count_; ++i)
+        {
+            pool& p = pools_[i];
+            while(p.chunks != nullptr)
+            {
+                chunk_header* next = p.chunks->next;
+                upstream_->deallocate(p.chunks, p.chunks->size, chunk_alignment(i));
+                p.chunks = next;
+            }
+            p.free = nullptr;
+            p.next_chunk_blocks = first_chunk_blocks;
+        }
+        while(oversized_ != nullptr)
+        {
+            oversized_header* next = oversized_->next;
+            deallocate_oversized(oversized_);
+            oversized_ = next;
+        }
+    }
+
+    memory_resource* upstream_resource() const noexcept { return upstream_; }
+    pool_options options() const noexcept { return options_; }
+
+private:
+    static size_t block_size(size_t index) noexcept { return min_block_size << index; }
+
+    static size_t chunk_alignment(size_t index) noexcept
+    {
+        size_t size = block_size(index);
+        return size < alignof(max_align_t) ? size : alignof(max_align_t);
+    }
+
+    size_t pool_index(size_t bytes, size_t alignment) const noexcept
+    {
+        size_t need = bytes > alignment ? bytes : alignment;
+        size_t index = 0;
+        while(index < pool_count_ && block_size(index) < need)
+            ++index;
+        return index; // == pool_count_ when no pool fits
+    }
+
+    static size_t oversized_offset(size_t alignment) noexcept
+    {
+        return detail::align_up(sizeof(oversized_header), alignment);
+    }
+
+    void deallocate_oversized(oversized_header* h) noexcept
+    {
+        size_t offset = oversized_offset(h->alignment);
+        upstream_->deallocate(reinterpret_cast<char*>(h + 1) - offset,
+            h->size + offset, h->alignment);
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        size_t index = pool_index(bytes, alignment);
+        if(index == pool_count_ || alignment > alignof(max_align_t))
+        {
+            if(alignment < alignof(oversized_header))
+                alignment = alignof(oversized_header);
+            size_t offset = oversized_offset(alignment);
+            char* raw = static_cast<char*>(upstream_->allocate(bytes + offset, alignment));
+            oversized_header* h = reinterpret_cast<oversized_header*>(raw + offset) - 1;
+            h->prev = nullptr;
+            h->next = oversized_;
+            h->size = bytes;
+            h->alignment = alignment;
+            if(oversized_ != nullptr)
+                oversized_->prev = h;
+            oversized_ = h;
+            return raw + offset;
+        }
+
+        pool& p = pools_[index];
+        if(p.free == nullptr)
+            refill(p, index);
+        free_block* block = p.free;
+        p.free = block->next;
+        return block;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        size_t index = pool_index(bytes, alignment);
+        if(index == pool_count_ || alignment > alignof(max_align_t))
+        {
+            oversized_header* h = static_cast<oversized_header*>(ptr) - 1;
+            if(h->prev != nullptr)
+                h->prev->next = h->next;
+            else
+                oversized_ = h->next;
+            if(h->next != nullptr)
+                h->next->prev = h->prev;
+            deallocate_oversized(h);
+            return;
+        }
+
+        free_block* block = static_cast<free_block*>(ptr);
+        block->next = pools_[index].free;
+        pools_[index].free = block;
+    }
+
+    void refill(pool& p, size_t index)
+    {
+        size_t size = block_size(index);
+        size_t alignment = chunk_alignment(index);
+        size_t header = detail::align_up(sizeof(chunk_header), alignment);
+        size_t count = p.next_chunk_blocks;
+        size_t bytes = header + count * size;
+
+        chunk_header* chunk = static_cast<chunk_header*>(upstream_->allocate(bytes, alignment));
+        chunk->next = p.chunks;
+        chunk->size = bytes;
+        p.chunks = chunk;
+
+        char* first = reinterpret_cast<char*>(chunk) + header;
+        for(size_t i = count; i > 0; --i)
+        {
+            free_block* block = reinterpret_cast<free_block*>(first + (i - 1) * size);
+            block->next = p.free;
+            p.free = block;
+        }
+
+        if(p.next_chunk_blocks < options_.max_blocks_per_chunk)
+            p.next_chunk_blocks *= 2;
+        if(p.next_chunk_blocks > options_.max_blocks_per_chunk)
+            p.next_chunk_blocks = options_.max_blocks_per_chunk;
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+
+// An unsynchronized_pool_resource guarded by a mutex, safe to share between threads.
+class synchronized_pool_resource : public memory_resource
+{
+    mutable std::mutex              mutex_;
+    unsynchronized_pool_resource    pools_;
+
+public:
+    synchronized_pool_resource()
+        : pools_() {}
+    explicit synchronized_pool_resource(memory_resource* upstream)
+        : pools_(upstream) {}
+    explicit synchronized_pool_resource(const pool_options& opts)
+        : pools_(opts) {}
+    synchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+        : pools_(opts, upstream) {}
+
+    synchronized_pool_resource(const synchronized_pool_resource&) = delete;
+    synchronized_pool_resource& operator=(const synchronized_pool_resource&) = delete;
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pools_.release();
+    }
+
+    memory_resource* upstream_resource() const noexcept { return pools_.upstream_resource(); }
+    pool_options options() const noexcept { return pools_.options(); }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pools_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pools_.deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+} // namespace pmr
+
+MYSTD_NS_END
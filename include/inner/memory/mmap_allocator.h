@@ -0,0 +1,254 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include <cstddef> // size_t
+#include <cstdint> // uintptr_t
+#include <new> // bad_alloc
+
+#if defined(_WIN32)
+#  include <windows.h> // VirtualAlloc, VirtualFree
+#else
+#  include <sys/mman.h> // mmap, munmap, madvise
+#  include <unistd.h> // sysconf
+#  include <cstdio> // fopen
+#  include <cstring> // strstr
+#endif
+
+
+MYSTD_NS_BEGIN
+
+using std::size_t;
+using std::uintptr_t;
+
+
+namespace detail {
+
+/**
+ *  Page mapping primitives behind mmap_allocator.
+ *
+ *  Mappings of at least huge_page_size bytes are rounded up to whole huge pages,
+ *  aligned to a huge page boundary and advised with MADV_HUGEPAGE, provided the
+ *  kernel has transparent huge pages enabled. Otherwise they are plain page-sized
+ *  mappings. map_length() is a pure function of the request size, so unmap() can
+ *  recompute exactly what map() mapped.
+*/
+struct page_mapper
+{
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+    static size_t page_size() noexcept
+    {
+#if defined(_WIN32)
+        static const size_t size = [] { SYSTEM_INFO info; GetSystemInfo(&info); return (size_t)info.dwPageSize; }();
+#else
+        static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+        return size;
+    }
+
+    // True when /sys/kernel/mm/transparent_hugepage/enabled is "always" or "madvise".
+    static bool transparent_huge_pages() noexcept
+    {
+#if defined(MADV_HUGEPAGE)
+        static const bool enabled = [] {
+            std::FILE* f = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+            if(f == nullptr)
+                return false;
+            char mode[128] = {};
+            size_t n = std::fread(mode, 1, sizeof(mode) - 1, f);
+            std::fclose(f);
+            mode[n] = '\0';
+            return std::strstr(mode, "[never]") == nullptr;
+        }();
+        return enabled;
+#else
+        return false;
+#endif
+    }
+
+    static bool use_huge_pages(size_t bytes) noexcept
+    {
+        return bytes >= huge_page_size && transparent_huge_pages();
+    }
+
+    static size_t map_length(size_t bytes) noexcept
+    {
+        size_t unit = use_huge_pages(bytes) ? huge_page_size : page_size();
+        return (bytes + unit - 1) & ~(unit - 1);
+    }
+
+    static void* map(size_t bytes)
+    {
+        size_t length = map_length(bytes);
+        if(length < bytes)
+            throw std::bad_alloc();
+#if defined(_WIN32)
+        void* p = VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if(p == nullptr)
+            throw std::bad_alloc();
+        return p;
+#else
+        if(!use_huge_pages(bytes))
+        {
+            void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(p == MAP_FAILED)
+                throw std::bad_alloc();
+            return p;
+        }
+
+        // over-map by one huge page and trim both ends to get an aligned region
+        size_t padded = length + huge_page_size;
+        void* raw = ::mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(raw == MAP_FAILED)
+            throw std::bad_alloc();
+        uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (begin + huge_page_size - 1) & ~(uintptr_t)(huge_page_size - 1);
+        if(aligned != begin)
+            ::munmap(raw, aligned - begin);
+        size_t tail = (begin + padded) - (aligned + length);
+        if(tail != 0)
+            ::munmap(reinterpret_cast<void*>(aligned + length), tail);
+#  if defined(MADV_HUGEPAGE)
+        ::madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE); // only a hint, failure is fine
+#  endif
+        return reinterpret_cast<void*>(aligned);
+#endif
+    }
+
+    static void unmap(void* p, size_t bytes) noexcept
+    {
+#if defined(_WIN32)
+        (void)bytes;
+        VirtualFree(p, 0, MEM_RELEASE);
+#else
+        ::munmap(p, map_length(bytes));
+#endif
+    }
+
+    // Gives the physical pages back to the OS but keeps the address range mapped (reads as zero).
+    static void discard(void* p, size_t bytes) noexcept
+    {
+        size_t page = page_size();
+        uintptr_t begin = (reinterpret_cast<uintptr_t>(p) + page - 1) & ~(uintptr_t)(page - 1);
+        uintptr_t end = (reinterpret_cast<uintptr_t>(p) + bytes) & ~(uintptr_t)(page - 1);
+        if(end <= begin)
+            return;
+#if defined(_WIN32)
+        VirtualAlloc(reinterpret_cast<void*>(begin), end - begin, MEM_RESET, PAGE_READWRITE);
+#else
+        ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+#endif
+    }
+};
+
+} // namespace detail
+
+
+/**
+ *  An allocator for large buffers that maps them straight from the OS.
+ *
+ *  Requests of at least mmap_threshold bytes get their own anonymous mapping
+ *  (backed by transparent huge pages when they are big enough and the kernel allows
+ *  it) and are unmapped on deallocate, so freed memory does not stay resident.
+ *  Smaller requests go through the regular heap like allocator<T>.
+*/
+template<typename T>
+class mmap_allocator
+{
+public:
+    static constexpr size_t mmap_threshold = 256 * 1024;
+
+    typedef T               value_type;
+    typedef value_type*     pointer;
+    typedef const T*        const_pointer;
+    typedef value_type&     reference;
+    typedef const T&        const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef true_type       propagate_on_container_move_assignment;
+    typedef true_type       is_always_equal;
+
+    template<typename Other>
+    struct rebind { typedef mmap_allocator<Other> other; };
+
+    mmap_allocator() noexcept {}
+    mmap_allocator(const mmap_allocator&) noexcept {}
+    template<typename Other>
+    mmap_allocator(const mmap_allocator<Other>&) noexcept {}
+    mmap_allocator& operator=(const mmap_allocator&) = default;
+
+    pointer allocate(size_type count)
+    {
+        if(count == 0) return 0;
+        if(count > max_size())
+            throw std::bad_alloc();
+        size_t bytes = count * sizeof(T);
+        if(is_mapped(bytes))
+            return static_cast<pointer>(detail::page_mapper::map(bytes));
+        return static_cast<pointer>(detail::allocate_bytes(bytes, alignof(T)));
+    }
+
+    /**
+     *  Mapped requests are rounded up to whole (huge) pages; the rest is returned as slack.
+     *  Heap slack stays below mmap_threshold, so deallocate() called with the returned
+     *  count still sees a heap block and does not hand it to munmap.
+     */
+    allocation_result<pointer, size_type> allocate_at_least(size_type count)
+    {
+        pointer p = allocate(count);
+        if(p == 0)
+            return { p, 0 };
+        size_t bytes = count * sizeof(T);
+        if(is_mapped(bytes))
+            bytes = detail::page_mapper::map_length(bytes);
+        else
+        {
+            bytes = detail::usable_size(p, bytes, alignof(T));
+            if(bytes >= mmap_threshold)
+                bytes = mmap_threshold - 1;
+        }
+        return { p, bytes / sizeof(T) };
+    }
+
+    void deallocate(pointer p, size_type count) noexcept
+    {
+        if(p == 0) return;
+        size_t bytes = count * sizeof(T);
+        if(is_mapped(bytes))
+            detail::page_mapper::unmap(p, bytes);
+        else
+            detail::deallocate_bytes(p, bytes, alignof(T));
+    }
+
+    /**
+     *  Drops the physical pages under [p, p + count) without giving up the memory:
+     *  the elements read back as zero bytes afterwards. Only whole pages inside the
+     *  range are affected.
+     */
+    void discard(pointer p, size_type count) noexcept
+    {
+        detail::page_mapper::discard(p, count * sizeof(T));
+    }
+
+    size_type max_size() const noexcept
+    {
+        return (size_type)(-1) / sizeof(T);
+    }
+
+    static bool is_mapped(size_t bytes) noexcept
+    {
+        return bytes >= mmap_threshold && alignof(T) <= detail::page_mapper::page_size();
+    }
+};
+
+template<typename T>
+constexpr size_t mmap_allocator<T>::mmap_threshold;
+
+template<typename T1, typename T2>
+inline bool operator==(const mmap_allocator<T1>&, const mmap_allocator<T2>&) noexcept { return true; }
+template<typename T1, typename T2>
+inline bool operator!=(const mmap_allocator<T1>&, const mmap_allocator<T2>&) noexcept { return false; }
+
+MYSTD_NS_END
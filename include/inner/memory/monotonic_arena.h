@@ -0,0 +1,174 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include <cstddef> // size_t, max_align_t
+#include <cstdint> // uintptr_t
+#include <new> // operator new, bad_alloc
+
+
+MYSTD_NS_BEGIN
+
+using std::size_t;
+using std::max_align_t;
+using std::uintptr_t;
+
+
+/**
+ *  A bump-pointer arena. Memory is carved out of geometrically growing blocks,
+ *  deallocate() is a no-op and everything is given back at once by release()
+ *  (or by the destructor).
+ *
+ *  Not thread safe: one arena is meant to live as long as one request.
+*/
+class monotonic_arena
+{
+    struct block_header
+    {
+        block_header*   next;
+        size_t          size; // bytes, including the header
+    };
+
+    block_header*   head_;
+    char*           cur_;
+    char*           end_;
+    size_t          initial_block_size_;
+    size_t          next_block_size_;
+    size_t          bytes_allocated_;
+
+public:
+    static constexpr size_t default_block_size = 4096;
+
+    explicit monotonic_arena(size_t initial_block_size = default_block_size) noexcept
+        : head_(nullptr), cur_(nullptr), end_(nullptr),
+        initial_block_size_(initial_block_size < sizeof(block_header) * 2
+            ? sizeof(block_header) * 2 : initial_block_size),
+        next_block_size_(initial_block_size_), bytes_allocated_(0)
+    {}
+
+    ~monotonic_arena() noexcept { release(); }
+
+    monotonic_arena(const monotonic_arena&) = delete;
+    monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(max_align_t))
+    {
+        char* p = align_up(cur_, alignment);
+        if(cur_ == nullptr || bytes > static_cast<size_t>(end_ - cur_)
+            || p + bytes > end_)
+        {
+            grow(bytes, alignment);
+            p = align_up(cur_, alignment);
+        }
+        cur_ = p + bytes;
+        bytes_allocated_ += bytes;
+        return p;
+    }
+
+    // Memory is only reclaimed by release().
+    void deallocate(void*, size_t) noexcept {}
+
+    // Frees every block at once. All pointers handed out become invalid.
+    void release() noexcept
+    {
+        while(head_ != nullptr)
+        {
+            block_header* next = head_->next;
+            ::operator delete(head_);
+            head_ = next;
+        }
+        cur_ = end_ = nullptr;
+        next_block_size_ = initial_block_size_;
+        bytes_allocated_ = 0;
+    }
+
+    size_t bytes_allocated() const noexcept { return bytes_allocated_; }
+
+private:
+    static char* align_up(char* p, size_t alignment) noexcept
+    {
+        uintptr_t v = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((v + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    void grow(size_t bytes, size_t alignment)
+    {
+        const size_t max_size = (size_t)(-1);
+        if(bytes > max_size - sizeof(block_header) - alignment)
+            throw std::bad_alloc();
+        size_t need = sizeof(block_header) + bytes + alignment;
+        size_t size = next_block_size_;
+        while(size < need)
+            size = size > max_size / 2 ? need : size * 2; // doubling would wrap around
+
+        block_header* block = static_cast<block_header*>(::operator new(size));
+        block->next = head_;
+        block->size = size;
+        head_ = block;
+        cur_ = reinterpret_cast<char*>(block + 1);
+        end_ = reinterpret_cast<char*>(block) + size;
+        next_block_size_ = size > max_size / 2 ? size : size * 2;
+    }
+};
+
+
+/**
+ *  An allocator that takes its memory from a monotonic_arena.
+ *  It only stores a pointer to the arena, so copies and rebound copies
+ *  all share the same arena and compare equal.
+*/
+template<typename T>
+class arena_allocator
+{
+    template<typename U> friend class arena_allocator;
+
+    monotonic_arena* arena_;
+
+public:
+    typedef T               value_type;
+    typedef value_type*     pointer;
+    typedef const T*        const_pointer;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef true_type       propagate_on_container_copy_assignment;
+    typedef true_type       propagate_on_container_move_assignment;
+    typedef true_type       propagate_on_container_swap;
+    typedef false_type      is_always_equal;
+
+    template<typename Other>
+    struct rebind { typedef arena_allocator<Other> other; };
+
+    arena_allocator(monotonic_arena& arena) noexcept : arena_(&arena) {}
+    template<typename Other>
+    arena_allocator(const arena_allocator<Other>& other) noexcept : arena_(other.arena_) {}
+
+    pointer allocate(size_type count)
+    {
+        if(count > max_size())
+            throw std::bad_alloc();
+        return static_cast<pointer>(arena_->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(pointer, size_type) noexcept {}
+
+    size_type max_size() const noexcept
+    {
+        return (size_type)(-1) / sizeof(T);
+    }
+
+    monotonic_arena& arena() const noexcept { return *arena_; }
+};
+
+template<typename T1, typename T2>
+inline bool operator==(const arena_allocator<T1>& lhs, const arena_allocator<T2>& rhs) noexcept
+{
+    return &lhs.arena() == &rhs.arena();
+}
+template<typename T1, typename T2>
+inline bool operator!=(const arena_allocator<T1>& lhs, const arena_allocator<T2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+MYSTD_NS_END
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include "unique_ptr.h"
+#include <cassert> // assert
+#include <cstddef> // size_t
+#include <utility> // forward
+
+
+MYSTD_NS_BEGIN
+
+template<typename T, typename Reset = void, typename Alloc = allocator<T>>
+class object_pool;
+
+
+namespace detail {
+
+// The part of an object_pool a pool_deleter needs, whatever the pool's Reset and Alloc.
+template<typename T>
+class object_pool_base
+{
+public:
+    // Takes back an object handed out by the pool.
+    virtual void recycle(T* p) noexcept = 0;
+
+protected:
+    ~object_pool_base() = default;
+};
+
+// Storage for one pooled object. next links the slot into the free list.
+template<typename T>
+struct object_pool_slot
+{
+    union
+    {
+        T value;
+    };
+    object_pool_slot* next;
+
+    object_pool_slot() noexcept {}
+    ~object_pool_slot() {}
+
+    static object_pool_slot* of(T* p) noexcept
+    {
+        return reinterpret_cast<object_pool_slot*>(p);
+    }
+};
+
+} // namespace detail
+
+
+/**
+ *  The deleter of the unique_ptrs an object_pool hands out: it gives the object
+ *  back to its pool instead of deleting it. It holds a single pointer, so such a
+ *  unique_ptr is two pointers wide.
+*/
+template<typename T>
+class pool_deleter
+{
+    detail::object_pool_base<T>* pool_;
+
+public:
+    pool_deleter() noexcept : pool_(nullptr) {}
+    explicit pool_deleter(detail::object_pool_base<T>& pool) noexcept : pool_(&pool) {}
+
+    void operator()(T* p) const noexcept
+    {
+        pool_->recycle(p);
+    }
+};
+
+
+/**
+ *  Recycles the storage of objects that are created and dropped over and over.
+ *
+ *  acquire(args...) returns a unique_ptr<T, pool_deleter<T>>. When that unique_ptr
+ *  lets go, the slot goes back on a free list and the next acquire() reuses it.
+ *  Slots are carved from blocks taken from Alloc, each block twice the size of the
+ *  one before, and are only returned to Alloc when the pool dies.
+ *
+ *  If Reset is void, a released object is destroyed and the next one is built from
+ *  acquire()'s arguments. Otherwise Reset()(object) runs on release and the object
+ *  stays alive for the next acquire(), which returns it as it is and ignores its
+ *  arguments. That saves a destroy/construct cycle and keeps whatever buffers
+ *  the object owns. acquire() only builds a new object from its arguments when
+ *  there is nothing to recycle.
+ *
+ *  A pool belongs to one thread. It must outlive every object it handed out.
+*/
+template<typename T, typename Reset, typename Alloc>
+class object_pool final : private detail::object_pool_base<T>
+{
+    typedef detail::object_pool_slot<T> slot;
+
+    struct block
+    {
+        block*  next;
+        slot*   slots;
+        size_t  count;
+    };
+
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<slot> slot_allocator;
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<block> block_allocator;
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<T> object_allocator;
+
+    static constexpr bool keeps_objects = !is_void<Reset>::value;
+
+    Alloc   alloc_;
+    slot*   free_;          // in keeps_objects mode, these slots hold live objects
+    slot*   fresh_;         // never used slots of the newest block
+    slot*   fresh_end_;
+    block*  blocks_;
+    size_t  next_block_;
+    size_t  outstanding_;
+
+public:
+    typedef T                               value_type;
+    typedef pool_deleter<T>                 deleter_type;
+    typedef unique_ptr<T, pool_deleter<T>>  pointer;
+    typedef Alloc                           allocator_type;
+
+    explicit object_pool(size_t initial_capacity = 32, const Alloc& alloc = Alloc())
+        : alloc_(alloc), free_(nullptr), fresh_(nullptr), fresh_end_(nullptr), blocks_(nullptr)
+        , next_block_(initial_capacity != 0 ? initial_capacity : 1), outstanding_(0) {}
+
+    object_pool(const object_pool&) = delete;
+    object_pool& operator=(const object_pool&) = delete;
+
+    ~object_pool()
+    {
+        assert(outstanding_ == 0 && "object_pool destroyed while objects are still in use");
+        destroy_kept(integral_constant<bool, keeps_objects>());
+
+        block_allocator ba(alloc_);
+        slot_allocator sa(alloc_);
+        while(blocks_ != nullptr)
+        {
+            block* b = blocks_;
+            blocks_ = b->next;
+            allocator_traits<slot_allocator>::deallocate(sa, b->slots, b->count);
+            allocator_traits<block_allocator>::deallocate(ba, b, 1);
+        }
+    }
+
+    template<typename... Args>
+    pointer acquire(Args&&... args)
+    {
+        T* p = take(integral_constant<bool, keeps_objects>(), std::forward<Args>(args)...);
+        ++outstanding_;
+        return pointer(p, pool_deleter<T>(*this));
+    }
+
+    // number of objects handed out and not yet released
+    size_t outstanding() const noexcept { return outstanding_; }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+private:
+    void recycle(T* p) noexcept override
+    {
+        slot* s = slot::of(p);
+        release(integral_constant<bool, keeps_objects>(), p);
+        s->next = free_;
+        free_ = s;
+        --outstanding_;
+    }
+
+    slot* take_slot()
+    {
+        if(free_ != nullptr)
+        {
+            slot* s = free_;
+            free_ = s->next;
+            return s;
+        }
+        if(fresh_ == fresh_end_)
+            grow();
+        return fresh_++;
+    }
+
+    void grow()
+    {
+        slot_allocator sa(alloc_);
+        block_allocator ba(alloc_);
+        slot* slots = to_address(allocator_traits<slot_allocator>::allocate(sa, next_block_));
+        block* b;
+        try
+        {
+            b = to_address(allocator_traits<block_allocator>::allocate(ba, 1));
+        }
+        catch(...)
+        {
+            allocator_traits<slot_allocator>::deallocate(sa, slots, next_block_);
+            throw;
+        }
+        b->next = blocks_;
+        b->slots = slots;
+        b->count = next_block_;
+        blocks_ = b;
+        fresh_ = slots;
+        fresh_end_ = slots + next_block_;
+        next_block_ *= 2;
+    }
+
+    template<typename... Args>
+    T* construct_in(slot* s, Args&&... args)
+    {
+        object_allocator oa(alloc_);
+        T* p = mystd::addressof(s->value);
+        try
+        {
+            allocator_traits<object_allocator>::construct(oa, p, std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            s->next = free_;
+            free_ = s;
+            throw;
+        }
+        return p;
+    }
+
+    // Reset is void: every slot on the free list is raw storage.
+    template<typename... Args>
+    T* take(false_type, Args&&... args)
+    {
+        return construct_in(take_slot(), std::forward<Args>(args)...);
+    }
+
+    void release(false_type, T* p) noexcept
+    {
+        object_allocator oa(alloc_);
+        allocator_traits<object_allocator>::destroy(oa, p);
+    }
+
+    void destroy_kept(false_type) noexcept {}
+
+    // Reset given: the free list holds live objects that are handed out again as they are.
+    template<typename... Args>
+    T* take(true_type, Args&&... args)
+    {
+        if(free_ != nullptr)
+        {
+            slot* s = free_;
+            free_ = s->next;
+            return mystd::addressof(s->value);
+        }
+        if(fresh_ == fresh_end_)
+            grow();
+        slot* s = fresh_++;
+        object_allocator oa(alloc_);
+        T* p = mystd::addressof(s->value);
+        try
+        {
+            allocator_traits<object_allocator>::construct(oa, p, std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            --fresh_;
+            throw;
+        }
+        return p;
+    }
+
+    void release(true_type, T* p) noexcept
+    {
+        Reset()(*p);
+    }
+
+    void destroy_kept(true_type) noexcept
+    {
+        object_allocator oa(alloc_);
+        for(slot* s = free_; s != nullptr; s = s->next)
+            allocator_traits<object_allocator>::destroy(oa, mystd::addressof(s->value));
+        free_ = nullptr;
+    }
+};
+
+template<typename T, typename Reset, typename Alloc>
+constexpr bool object_pool<T, Reset, Alloc>::keeps_objects;
+
+MYSTD_NS_END
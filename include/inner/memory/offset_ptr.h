@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include <cstddef> // ptrdiff_t, nullptr_t
+#include <cstdint> // uintptr_t
+#include <iterator> // random_access_iterator_tag
+
+
+MYSTD_NS_BEGIN
+
+using std::ptrdiff_t;
+using std::nullptr_t;
+using std::uintptr_t;
+
+
+/**
+ *  A fancy pointer that stores the distance from itself to its target instead of an
+ *  address. A structure linked with offset_ptr stays valid wherever the memory that
+ *  holds it (pointer and pointee together) is mapped, e.g. a file mapped at a
+ *  different address in another process.
+ *
+ *  Copying recomputes the offset for the new location, so offset_ptr can be passed
+ *  around by value like a raw pointer. The null pointer is stored as offset 1, which
+ *  can never point at a valid object of the pointer's own storage.
+ *
+ *  The offset is kept as an unsigned address difference: subtracting pointers to
+ *  unrelated objects is undefined and compilers do exploit it.
+*/
+template<typename T>
+class offset_ptr
+{
+    template<typename U> friend class offset_ptr;
+
+    static constexpr uintptr_t null_offset = 1;
+
+    uintptr_t offset_;
+
+    uintptr_t address() const noexcept { return reinterpret_cast<uintptr_t>(this); }
+
+    void set(T* p) noexcept
+    {
+        offset_ = p == nullptr ? null_offset : reinterpret_cast<uintptr_t>(p) - address();
+    }
+
+public:
+    typedef T                               element_type;
+    typedef remove_cv_t<T>                  value_type;
+    typedef ptrdiff_t                       difference_type;
+    typedef offset_ptr                      pointer;
+    typedef std::random_access_iterator_tag iterator_category;
+
+    template<typename U>
+    using rebind = offset_ptr<U>;
+
+    offset_ptr() noexcept : offset_(null_offset) {}
+    offset_ptr(nullptr_t) noexcept : offset_(null_offset) {}
+    offset_ptr(T* p) noexcept { set(p); }
+    offset_ptr(const offset_ptr& other) noexcept { set(other.get()); }
+    template<typename U,
+        typename = enable_if_t<is_convertible<U*, T*>::value>>
+    offset_ptr(const offset_ptr<U>& other) noexcept { set(other.get()); }
+
+    offset_ptr& operator=(const offset_ptr& other) noexcept { set(other.get()); return *this; }
+    offset_ptr& operator=(T* p) noexcept { set(p); return *this; }
+    offset_ptr& operator=(nullptr_t) noexcept { offset_ = null_offset; return *this; }
+    template<typename U,
+        typename = enable_if_t<is_convertible<U*, T*>::value>>
+    offset_ptr& operator=(const offset_ptr<U>& other) noexcept { set(other.get()); return *this; }
+
+    T* get() const noexcept
+    {
+        if(offset_ == null_offset)
+            return nullptr;
+        return reinterpret_cast<T*>(address() + offset_);
+    }
+
+    T* operator->() const noexcept { return get(); }
+
+    template<typename U = T>
+    enable_if_t<!is_void<U>::value, U&> operator*() const noexcept { return *get(); }
+
+    template<typename U = T>
+    enable_if_t<!is_void<U>::value, U&> operator[](difference_type i) const noexcept { return get()[i]; }
+
+    explicit operator bool() const noexcept { return offset_ != null_offset; }
+
+    // used by pointer_traits<offset_ptr<T>>::pointer_to
+    template<typename U = T>
+    static offset_ptr pointer_to(enable_if_t<!is_void<U>::value, U>& r) noexcept
+    {
+        return offset_ptr(&r);
+    }
+
+    offset_ptr& operator++() noexcept { offset_ += sizeof(T); return *this; }
+    offset_ptr& operator--() noexcept { offset_ -= sizeof(T); return *this; }
+    offset_ptr operator++(int) noexcept { offset_ptr old(*this); ++*this; return old; }
+    offset_ptr operator--(int) noexcept { offset_ptr old(*this); --*this; return old; }
+    offset_ptr& operator+=(difference_type n) noexcept { offset_ += (uintptr_t)n * sizeof(T); return *this; }
+    offset_ptr& operator-=(difference_type n) noexcept { offset_ -= (uintptr_t)n * sizeof(T); return *this; }
+
+    friend offset_ptr operator+(const offset_ptr& p, difference_type n) noexcept { return offset_ptr(p.get() + n); }
+    friend offset_ptr operator+(difference_type n, const offset_ptr& p) noexcept { return offset_ptr(p.get() + n); }
+    friend offset_ptr operator-(const offset_ptr& p, difference_type n) noexcept { return offset_ptr(p.get() - n); }
+    friend difference_type operator-(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() - b.get(); }
+
+    friend bool operator==(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() == b.get(); }
+    friend bool operator!=(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() != b.get(); }
+    friend bool operator<(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() < b.get(); }
+    friend bool operator>(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() > b.get(); }
+    friend bool operator<=(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() <= b.get(); }
+    friend bool operator>=(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() >= b.get(); }
+    friend bool operator==(const offset_ptr& a, nullptr_t) noexcept { return !a; }
+    friend bool operator==(nullptr_t, const offset_ptr& a) noexcept { return !a; }
+    friend bool operator!=(const offset_ptr& a, nullptr_t) noexcept { return bool(a); }
+    friend bool operator!=(nullptr_t, const offset_ptr& a) noexcept { return bool(a); }
+};
+
+template<typename T>
+constexpr uintptr_t offset_ptr<T>::null_offset;
+
+
+template<typename T, typename U>
+inline offset_ptr<T> static_pointer_cast(const offset_ptr<U>& p) noexcept
+{
+    return offset_ptr<T>(static_cast<T*>(p.get()));
+}
+
+template<typename T, typename U>
+inline offset_ptr<T> const_pointer_cast(const offset_ptr<U>& p) noexcept
+{
+    return offset_ptr<T>(const_cast<T*>(p.get()));
+}
+
+MYSTD_NS_END
@@ -0,0 +1,656 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include <algorithm> // sort, binary_search
+#include <atomic> // atomic, atomic_thread_fence
+#include <cassert> // assert
+#include <cstddef> // size_t, nullptr_t
+#include <cstdint> // uint64_t
+#include <utility> // swap
+
+
+MYSTD_NS_BEGIN
+
+using std::uint64_t;
+using std::atomic_thread_fence;
+using std::memory_order_seq_cst;
+
+
+namespace detail {
+
+// Destroys and frees an object that was allocated with Alloc rebound to T.
+template<typename T, typename Alloc>
+void reclaim_object(Alloc& alloc, void* p) noexcept
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<T> object_allocator;
+    object_allocator a(alloc);
+    allocator_traits<object_allocator>::destroy(a, static_cast<T*>(p));
+    allocator_traits<object_allocator>::deallocate(a, static_cast<T*>(p), 1);
+}
+
+// A batch of retired objects, linked into lists that can be handed between threads.
+template<typename Alloc>
+struct retired_chunk
+{
+    static constexpr size_t capacity = 62;
+
+    typedef void (*reclaim_fn)(Alloc&, void*);
+
+    struct entry
+    {
+        void*       object;
+        reclaim_fn  reclaim;
+    };
+
+    retired_chunk*  next;
+    size_t          count;
+    entry           entries[capacity];
+};
+
+/**
+ *  Objects waiting to be freed, owned by one thread. They are stored in chunks of
+ *  retired_chunk::capacity, so retiring allocates once per chunk and reclaiming
+ *  walks contiguous memory. Chunks come from Alloc, rebound.
+*/
+template<typename Alloc>
+class retired_list
+{
+    typedef retired_chunk<Alloc> chunk;
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<chunk> chunk_allocator;
+    typedef allocator_traits<chunk_allocator> chunk_traits;
+
+    chunk*  head_;
+    size_t  size_;
+
+    static void free_chunk(Alloc& alloc, chunk* c) noexcept
+    {
+        chunk_allocator a(alloc);
+        chunk_traits::deallocate(a, c, 1);
+    }
+
+public:
+    retired_list() noexcept : head_(nullptr), size_(0) {}
+    retired_list(const retired_list&) = delete;
+    retired_list& operator=(const retired_list&) = delete;
+    ~retired_list() { assert(head_ == nullptr && "reclaim_all() must run before the list goes away"); }
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    void push(Alloc& alloc, void* object, typename chunk::reclaim_fn reclaim)
+    {
+        if(head_ == nullptr || head_->count == chunk::capacity)
+        {
+            chunk_allocator a(alloc);
+            chunk* c = to_address(chunk_traits::allocate(a, 1));
+            c->next = head_;
+            c->count = 0;
+            head_ = c;
+        }
+        head_->entries[head_->count++] = { object, reclaim };
+        ++size_;
+    }
+
+    // Frees every object for which is_protected(object) is false and packs the rest to the front.
+    template<typename Pred>
+    void reclaim_unless(Alloc& alloc, Pred is_protected) noexcept
+    {
+        chunk* out = head_;
+        size_t out_count = 0;
+        size_ = 0;
+        for(chunk* in = head_; in != nullptr; in = in->next)
+            for(size_t i = 0; i < in->count; ++i)
+            {
+                typename chunk::entry e = in->entries[i];
+                if(!is_protected(e.object))
+                {
+                    e.reclaim(alloc, e.object);
+                    continue;
+                }
+                if(out_count == chunk::capacity)
+                {
+                    out->count = out_count;
+                    out = out->next;
+                    out_count = 0;
+                }
+                out->entries[out_count++] = e;
+                ++size_;
+            }
+
+        // the chunks after the last one written to are empty now
+        chunk* spare;
+        if(size_ == 0)
+        {
+            spare = head_;
+            head_ = nullptr;
+        }
+        else
+        {
+            out->count = out_count;
+            spare = out->next;
+            out->next = nullptr;
+        }
+        for(out = spare; out != nullptr; )
+        {
+            chunk* next = out->next;
+            free_chunk(alloc, out);
+            out = next;
+        }
+    }
+
+    void reclaim_all(Alloc& alloc) noexcept
+    {
+        reclaim_unless(alloc, [](void*) { return false; });
+    }
+
+    // Gives up the chunks, e.g. to park them in a domain when the owning thread leaves.
+    chunk* detach() noexcept
+    {
+        chunk* c = head_;
+        head_ = nullptr;
+        size_ = 0;
+        return c;
+    }
+
+    // Takes over a chain of chunks from detach().
+    void attach(chunk* chain) noexcept
+    {
+        while(chain != nullptr)
+        {
+            chunk* next = chain->next;
+            chain->next = head_;
+            head_ = chain;
+            size_ += chain->count;
+            chain = next;
+        }
+    }
+};
+
+// A lock-free stack of chunk chains left behind by threads that stopped participating.
+template<typename Alloc>
+class orphan_stack
+{
+    typedef retired_chunk<Alloc> chunk;
+
+    atomic<chunk*> head_;
+
+public:
+    orphan_stack() noexcept : head_(nullptr) {}
+
+    bool empty() const noexcept { return head_.load(memory_order_relaxed) == nullptr; }
+
+    void push(chunk* chain) noexcept
+    {
+        if(chain == nullptr)
+            return;
+        chunk* tail = chain;
+        while(tail->next != nullptr)
+            tail = tail->next;
+        chunk* head = head_.load(memory_order_relaxed);
+        do
+            tail->next = head;
+        while(!head_.compare_exchange_weak(head, chain, memory_order_release, memory_order_relaxed));
+    }
+
+    chunk* take_all() noexcept
+    {
+        return head_.exchange(nullptr, memory_order_acquire);
+    }
+};
+
+// Records are handed out to threads and reused, never freed before their domain.
+template<typename Record, typename Alloc>
+class record_registry
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<Record> record_allocator;
+
+    atomic<Record*> head_;
+    atomic<size_t>  count_;
+
+public:
+    record_registry() noexcept : head_(nullptr), count_(0) {}
+
+    Record* head() const noexcept { return head_.load(memory_order_acquire); }
+    size_t count() const noexcept { return count_.load(memory_order_relaxed); }
+
+    Record* acquire(Alloc& alloc)
+    {
+        for(Record* r = head(); r != nullptr; r = r->next)
+        {
+            bool free = false;
+            if(!r->in_use.load(memory_order_relaxed)
+                && r->in_use.compare_exchange_strong(free, true, memory_order_acquire, memory_order_relaxed))
+                return r;
+        }
+
+        record_allocator a(alloc);
+        Record* r = to_address(allocator_traits<record_allocator>::allocate(a, 1));
+        ::new (static_cast<void*>(r)) Record();
+        r->in_use.store(true, memory_order_relaxed);
+        Record* head = head_.load(memory_order_relaxed);
+        do
+            r->next = head;
+        while(!head_.compare_exchange_weak(head, r, memory_order_release, memory_order_relaxed));
+        count_.fetch_add(1, memory_order_relaxed);
+        return r;
+    }
+
+    void release(Record* r) noexcept
+    {
+        r->in_use.store(false, memory_order_release);
+    }
+
+    void free_all(Alloc& alloc) noexcept
+    {
+        record_allocator a(alloc);
+        Record* r = head_.exchange(nullptr, memory_order_acquire);
+        while(r != nullptr)
+        {
+            Record* next = r->next;
+            assert(!r->in_use.load(memory_order_relaxed) && "a thread still participates in the domain");
+            r->~Record();
+            allocator_traits<record_allocator>::deallocate(a, r, 1);
+            r = next;
+        }
+    }
+};
+
+struct alignas(hardware_destructive_interference_size) hazard_record
+{
+    atomic<const void*> pointer;
+    atomic<bool>        in_use;
+    hazard_record*      next;
+
+    hazard_record() noexcept : pointer(nullptr), in_use(false), next(nullptr) {}
+};
+
+} // namespace detail
+
+
+/**
+ *  Deferred reclamation with hazard pointers.
+ *
+ *  A reader publishes the node it is about to dereference in a hazard_pointer.
+ *  A writer that has unlinked a node retires it through its participant, which
+ *  frees the node once no hazard pointer holds it. Retired nodes are checked in
+ *  batches: when a participant holds about twice as many as there are hazard
+ *  pointers, it sorts a snapshot of the hazards and frees everything not in it.
+ *  That costs O(log H) per node and caps each thread's backlog at O(H) nodes.
+ *
+ *  Retired objects must come from Alloc (rebound to their type); they are
+ *  destroyed and deallocated through it. Each thread that retires needs its own
+ *  participant. Every participant and hazard_pointer must be gone before the domain.
+*/
+template<typename Alloc = allocator<char>>
+class hazard_domain
+{
+    friend class hazard_pointer;
+
+    typedef detail::hazard_record record;
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<const void*> hazard_allocator;
+
+    Alloc                                       alloc_;
+    detail::record_registry<record, Alloc>      records_;
+    detail::orphan_stack<Alloc>                 orphans_;
+
+public:
+    typedef Alloc allocator_type;
+
+    static constexpr size_t min_batch = 64;
+
+    explicit hazard_domain(const Alloc& alloc = Alloc()) : alloc_(alloc) {}
+    hazard_domain(const hazard_domain&) = delete;
+    hazard_domain& operator=(const hazard_domain&) = delete;
+
+    ~hazard_domain()
+    {
+        detail::retired_list<Alloc> left;
+        left.attach(orphans_.take_all());
+        left.reclaim_all(alloc_);
+        records_.free_all(alloc_);
+    }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    // One thread's list of retired nodes.
+    class participant
+    {
+        hazard_domain*                  domain_;
+        detail::retired_list<Alloc>     retired_;
+
+    public:
+        explicit participant(hazard_domain& domain) noexcept : domain_(&domain) {}
+        participant(const participant&) = delete;
+        participant& operator=(const participant&) = delete;
+
+        // Whatever is still protected is left to the domain.
+        ~participant()
+        {
+            reclaim();
+            domain_->orphans_.push(retired_.detach());
+        }
+
+        // Schedules p, already unreachable for new readers, to be freed.
+        template<typename T>
+        void retire(T* p)
+        {
+            retired_.push(domain_->alloc_, const_cast<remove_cv_t<T>*>(p), &detail::reclaim_object<remove_cv_t<T>, Alloc>);
+            if(retired_.size() >= threshold())
+                reclaim();
+        }
+
+        // Frees every retired node no hazard pointer protects.
+        void reclaim()
+        {
+            if(!domain_->orphans_.empty())
+                retired_.attach(domain_->orphans_.take_all());
+            if(retired_.empty())
+                return;
+
+            // pairs with the fence in hazard_pointer::try_protect: a reader either sees
+            // the node unlinked, or we see its hazard
+            atomic_thread_fence(memory_order_seq_cst);
+
+            // Records only ever join at the front, so the list from one head is stable.
+            // Readers that register later cannot validate a node we already unlinked.
+            record* head = domain_->records_.head();
+            size_t capacity = 0;
+            for(record* r = head; r != nullptr; r = r->next)
+                ++capacity;
+            hazard_allocator a(domain_->alloc_);
+            const void** hazards = to_address(allocator_traits<hazard_allocator>::allocate(a, capacity));
+            size_t count = 0;
+            for(record* r = head; r != nullptr; r = r->next)
+                if(const void* p = r->pointer.load(memory_order_acquire))
+                    hazards[count++] = p;
+            std::sort(hazards, hazards + count);
+
+            retired_.reclaim_unless(domain_->alloc_, [hazards, count](void* p)
+            {
+                return std::binary_search(hazards, hazards + count, static_cast<const void*>(p));
+            });
+            allocator_traits<hazard_allocator>::deallocate(a, hazards, capacity);
+        }
+
+        size_t pending() const noexcept { return retired_.size(); }
+
+    private:
+        size_t threshold() const noexcept
+        {
+            size_t h = 2 * domain_->records_.count();
+            return h > min_batch ? h : min_batch;
+        }
+    };
+};
+
+template<typename Alloc>
+constexpr size_t hazard_domain<Alloc>::min_batch;
+
+
+/**
+ *  One hazard slot. While it protects a node, no participant of its domain frees
+ *  that node. Slots are recycled through the domain, so creating one is cheap
+ *  after the first time; keep them around for a whole operation or longer.
+*/
+class hazard_pointer
+{
+    detail::hazard_record* record_;
+
+public:
+    hazard_pointer() noexcept : record_(nullptr) {}
+
+    template<typename Alloc>
+    explicit hazard_pointer(hazard_domain<Alloc>& domain) : record_(domain.records_.acquire(domain.alloc_)) {}
+
+    hazard_pointer(hazard_pointer&& other) noexcept : record_(other.record_) { other.record_ = nullptr; }
+    hazard_pointer& operator=(hazard_pointer&& other) noexcept
+    {
+        std::swap(record_, other.record_);
+        return *this;
+    }
+
+    ~hazard_pointer()
+    {
+        if(record_ != nullptr)
+        {
+            record_->pointer.store(nullptr, memory_order_release);
+            record_->in_use.store(false, memory_order_release);
+        }
+    }
+
+    bool empty() const noexcept { return record_ == nullptr; }
+
+    // Protects the node src points to and returns it; retries until src holds still.
+    template<typename T>
+    T* protect(const atomic<T*>& src) noexcept
+    {
+        T* p = src.load(memory_order_relaxed);
+        while(!try_protect(p, src))
+            ;
+        return p;
+    }
+
+    // Protects ptr if src still points to it; otherwise stores src's new value in ptr and returns false.
+    template<typename T>
+    bool try_protect(T*& ptr, const atomic<T*>& src) noexcept
+    {
+        T* expected = ptr;
+        record_->pointer.store(expected, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        ptr = src.load(memory_order_acquire);
+        if(ptr == expected)
+            return true;
+        record_->pointer.store(nullptr, memory_order_release);
+        return false;
+    }
+
+    // Protects p without validating it; the caller knows p is still reachable.
+    template<typename T>
+    void reset_protection(const T* p) noexcept
+    {
+        record_->pointer.store(p, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+
+    void reset_protection(nullptr_t = nullptr) noexcept
+    {
+        record_->pointer.store(nullptr, memory_order_release);
+    }
+
+    void swap(hazard_pointer& other) noexcept { std::swap(record_, other.record_); }
+};
+
+
+namespace detail {
+
+struct alignas(hardware_destructive_interference_size) epoch_record
+{
+    // (epoch << 1) | 1 while pinned, 0 otherwise
+    atomic<uint64_t>    state;
+    atomic<bool>        in_use;
+    epoch_record*       next;
+
+    epoch_record() noexcept : state(0), in_use(false), next(nullptr) {}
+};
+
+} // namespace detail
+
+
+/**
+ *  Deferred reclamation by epochs (EBR).
+ *
+ *  A reader pins its participant for the length of an operation instead of
+ *  protecting each node. Nodes retired while the global epoch is E are freed once
+ *  the epoch reaches E + 2: by then every thread that was pinned when they were
+ *  unlinked has unpinned. The epoch only advances when every pinned participant
+ *  has seen the current one, which each participant checks after retiring
+ *  min_batch nodes. A reader pays two uncontended stores per operation, but a
+ *  thread that stays pinned holds up reclamation for everybody.
+ *
+ *  Retired objects must come from Alloc (rebound to their type). Each thread needs
+ *  its own participant, and every participant must be gone before the domain.
+*/
+template<typename Alloc = allocator<char>>
+class epoch_domain
+{
+    typedef detail::epoch_record record;
+
+    alignas(hardware_destructive_interference_size)
+    atomic<uint64_t>                            epoch_;
+    Alloc                                       alloc_;
+    detail::record_registry<record, Alloc>      records_;
+    detail::orphan_stack<Alloc>                 orphans_;
+
+    // Moves the epoch on if every pinned participant is in the current one; returns the epoch.
+    uint64_t try_advance() noexcept
+    {
+        uint64_t epoch = epoch_.load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        for(record* r = records_.head(); r != nullptr; r = r->next)
+        {
+            uint64_t state = r->state.load(memory_order_relaxed);
+            if((state & 1) != 0 && (state >> 1) != epoch)
+                return epoch;
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if(epoch_.compare_exchange_strong(epoch, epoch + 1, memory_order_release, memory_order_relaxed))
+            return epoch + 1;
+        return epoch;
+    }
+
+public:
+    typedef Alloc allocator_type;
+
+    static constexpr size_t min_batch = 64;
+
+    explicit epoch_domain(const Alloc& alloc = Alloc()) : epoch_(0), alloc_(alloc) {}
+    epoch_domain(const epoch_domain&) = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+
+    ~epoch_domain()
+    {
+        detail::retired_list<Alloc> left;
+        left.attach(orphans_.take_all());
+        left.reclaim_all(alloc_);
+        records_.free_all(alloc_);
+    }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    uint64_t epoch() const noexcept { return epoch_.load(memory_order_relaxed); }
+
+    class participant;
+
+    // Keeps its participant pinned while it lives.
+    class guard
+    {
+        participant* owner_;
+
+    public:
+        explicit guard(participant& owner) noexcept : owner_(&owner) { owner_->pin(); }
+        guard(guard&& other) noexcept : owner_(other.owner_) { other.owner_ = nullptr; }
+        guard& operator=(guard&&) = delete;
+        ~guard() { if(owner_ != nullptr) owner_->unpin(); }
+    };
+
+    // One thread's registration: its pin state and three bags of retired nodes, one per epoch.
+    class participant
+    {
+        epoch_domain*                   domain_;
+        record*                         record_;
+        unsigned                        pins_;
+        uint64_t                        bag_epoch_[3];
+        detail::retired_list<Alloc>     bags_[3];
+        size_t                          since_advance_;
+
+        void reclaim_before(uint64_t epoch) noexcept
+        {
+            for(int i = 0; i < 3; ++i)
+                if(!bags_[i].empty() && bag_epoch_[i] + 2 <= epoch)
+                    bags_[i].reclaim_all(domain_->alloc_);
+        }
+
+    public:
+        explicit participant(epoch_domain& domain)
+            : domain_(&domain), record_(domain.records_.acquire(domain.alloc_)), pins_(0)
+            , bag_epoch_{0, 0, 0}, since_advance_(0) {}
+        participant(const participant&) = delete;
+        participant& operator=(const participant&) = delete;
+
+        // Bags that are not yet safe to free are left to the domain.
+        ~participant()
+        {
+            assert(pins_ == 0 && "participant destroyed while pinned");
+            reclaim_before(domain_->try_advance());
+            for(int i = 0; i < 3; ++i)
+                domain_->orphans_.push(bags_[i].detach());
+            record_->state.store(0, memory_order_relaxed);
+            domain_->records_.release(record_);
+        }
+
+        // Enters a read-side critical section; nodes reachable now stay valid until unpin().
+        void pin() noexcept
+        {
+            if(pins_++ != 0)
+                return;
+            uint64_t epoch = domain_->epoch_.load(memory_order_relaxed);
+            record_->state.store((epoch << 1) | 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+        }
+
+        void unpin() noexcept
+        {
+            if(--pins_ == 0)
+                record_->state.store(0, memory_order_release);
+        }
+
+        guard enter() noexcept { return guard(*this); }
+
+        bool pinned() const noexcept { return pins_ != 0; }
+
+        // Schedules p, already unreachable for new readers, to be freed two epochs from now.
+        template<typename T>
+        void retire(T* p)
+        {
+            uint64_t epoch = domain_->epoch_.load(memory_order_acquire);
+            int bag = (int)(epoch % 3);
+            if(bag_epoch_[bag] != epoch)
+            {
+                // whatever is in this bag is three or more epochs old
+                bags_[bag].reclaim_all(domain_->alloc_);
+                bag_epoch_[bag] = epoch;
+            }
+            bags_[bag].push(domain_->alloc_, const_cast<remove_cv_t<T>*>(p), &detail::reclaim_object<remove_cv_t<T>, Alloc>);
+            if(++since_advance_ >= min_batch)
+                reclaim();
+        }
+
+        // Tries to move the epoch on and frees the bags that became safe.
+        void reclaim()
+        {
+            since_advance_ = 0;
+            if(!domain_->orphans_.empty())
+            {
+                // orphans are at least as old as the current epoch, so they can wait in its bag
+                uint64_t epoch = domain_->epoch_.load(memory_order_acquire);
+                int bag = (int)(epoch % 3);
+                if(bag_epoch_[bag] != epoch)
+                {
+                    bags_[bag].reclaim_all(domain_->alloc_);
+                    bag_epoch_[bag] = epoch;
+                }
+                bags_[bag].attach(domain_->orphans_.take_all());
+            }
+            reclaim_before(domain_->try_advance());
+        }
+
+        size_t pending() const noexcept { return bags_[0].size() + bags_[1].size() + bags_[2].size(); }
+    };
+};
+
+template<typename Alloc>
+constexpr size_t epoch_domain<Alloc>::min_batch;
+
+MYSTD_NS_END
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include <tuple> // tuple_size, get
+#include <utility> // forward, move, index_sequence
+
+
+MYSTD_NS_BEGIN
+
+template<typename OuterAlloc, typename... InnerAllocs>
+class scoped_allocator_adaptor;
+
+
+namespace detail {
+
+// The allocator at the bottom of a chain of outer_allocator() calls.
+template<typename Alloc, typename = void>
+struct outermost_allocator
+{
+    typedef Alloc type;
+    static type& get(Alloc& a) noexcept { return a; }
+};
+template<typename Alloc>
+struct outermost_allocator<Alloc, void_t<decltype(declval<Alloc&>().outer_allocator())>>
+{
+    typedef remove_reference_t<decltype(declval<Alloc&>().outer_allocator())> outer_type;
+    typedef typename outermost_allocator<outer_type>::type type;
+    static type& get(Alloc& a) noexcept { return outermost_allocator<outer_type>::get(a.outer_allocator()); }
+};
+
+// Holds the inner allocators of a scoped_allocator_adaptor. With none, the adaptor is its own inner allocator.
+template<typename... InnerAllocs>
+class scoped_inner
+{
+public:
+    typedef scoped_allocator_adaptor<InnerAllocs...> type;
+    template<typename Self>
+    using type_for = type;
+
+    scoped_inner() = default;
+    template<typename... Args>
+    scoped_inner(Args&&... args) noexcept : inner_(forward<Args>(args)...) {}
+
+    template<typename Self>
+    type& get(Self&) noexcept { return inner_; }
+    template<typename Self>
+    const type& get(const Self&) const noexcept { return inner_; }
+
+private:
+    type inner_;
+};
+
+template<>
+class scoped_inner<>
+{
+public:
+    template<typename Self>
+    using type_for = Self;
+
+    scoped_inner() = default;
+    template<typename Adaptor>
+    scoped_inner(const Adaptor&) noexcept {}
+
+    template<typename Self>
+    Self& get(Self& self) noexcept { return self; }
+    template<typename Self>
+    const Self& get(const Self& self) const noexcept { return self; }
+};
+
+} // namespace detail
+
+
+/**
+ *  An allocator adaptor that hands an allocator down to the elements it builds.
+ *
+ *  Memory for the container comes from OuterAlloc. Elements are built with
+ *  uses-allocator construction, receiving the inner allocator: the first of
+ *  InnerAllocs..., or OuterAlloc itself when there are none. So a vector of vectors
+ *  (or of strings) using scoped_allocator_adaptor<arena_allocator<...>> keeps every
+ *  inner buffer in the same arena as the outer one, and all of it is freed together.
+ *
+ *  The propagation traits are set if any of the adapted allocators sets them, and
+ *  is_always_equal only if all of them do.
+*/
+template<typename OuterAlloc, typename... InnerAllocs>
+class scoped_allocator_adaptor : public OuterAlloc
+{
+    template<typename OtherOuter, typename... OtherInner> friend class scoped_allocator_adaptor;
+
+    typedef allocator_traits<OuterAlloc> outer_traits;
+
+    detail::scoped_inner<InnerAllocs...> inner_;
+
+public:
+    typedef OuterAlloc outer_allocator_type;
+    typedef typename detail::scoped_inner<InnerAllocs...>::template type_for<scoped_allocator_adaptor>
+        inner_allocator_type;
+
+    typedef typename outer_traits::value_type           value_type;
+    typedef typename outer_traits::size_type            size_type;
+    typedef typename outer_traits::difference_type      difference_type;
+    typedef typename outer_traits::pointer              pointer;
+    typedef typename outer_traits::const_pointer        const_pointer;
+    typedef typename outer_traits::void_pointer         void_pointer;
+    typedef typename outer_traits::const_void_pointer   const_void_pointer;
+
+    typedef integral_constant<bool, detail::disjunction<
+        typename allocator_traits<OuterAlloc>::propagate_on_container_copy_assignment,
+        typename allocator_traits<InnerAllocs>::propagate_on_container_copy_assignment...>::value>
+        propagate_on_container_copy_assignment;
+    typedef integral_constant<bool, detail::disjunction<
+        typename allocator_traits<OuterAlloc>::propagate_on_container_move_assignment,
+        typename allocator_traits<InnerAllocs>::propagate_on_container_move_assignment...>::value>
+        propagate_on_container_move_assignment;
+    typedef integral_constant<bool, detail::disjunction<
+        typename allocator_traits<OuterAlloc>::propagate_on_container_swap,
+        typename allocator_traits<InnerAllocs>::propagate_on_container_swap...>::value>
+        propagate_on_container_swap;
+    typedef integral_constant<bool, detail::conjunction<
+        typename allocator_traits<OuterAlloc>::is_always_equal,
+        typename allocator_traits<InnerAllocs>::is_always_equal...>::value>
+        is_always_equal;
+
+    template<typename Other>
+    struct rebind
+    {
+        typedef scoped_allocator_adaptor<
+            typename outer_traits::template rebind_alloc<Other>, InnerAllocs...> other;
+    };
+
+    scoped_allocator_adaptor() = default;
+
+    template<typename OuterA2,
+        typename = enable_if_t<is_constructible<OuterAlloc, OuterA2>::value>>
+    scoped_allocator_adaptor(OuterA2&& outer, const InnerAllocs&... inner) noexcept
+        : OuterAlloc(forward<OuterA2>(outer)), inner_(inner...) {}
+
+    scoped_allocator_adaptor(const scoped_allocator_adaptor& other) = default;
+    scoped_allocator_adaptor(scoped_allocator_adaptor&& other) = default;
+
+    template<typename OuterA2,
+        typename = enable_if_t<is_constructible<OuterAlloc, const OuterA2&>::value>>
+    scoped_allocator_adaptor(const scoped_allocator_adaptor<OuterA2, InnerAllocs...>& other) noexcept
+        : OuterAlloc(other.outer_allocator()), inner_(other.inner_allocator()) {}
+
+    template<typename OuterA2,
+        typename = enable_if_t<is_constructible<OuterAlloc, OuterA2>::value>>
+    scoped_allocator_adaptor(scoped_allocator_adaptor<OuterA2, InnerAllocs...>&& other) noexcept
+        : OuterAlloc(std::move(other.outer_allocator())), inner_(std::move(other.inner_allocator())) {}
+
+    scoped_allocator_adaptor& operator=(const scoped_allocator_adaptor&) = default;
+    scoped_allocator_adaptor& operator=(scoped_allocator_adaptor&&) = default;
+
+    inner_allocator_type& inner_allocator() noexcept { return inner_.get(*this); }
+    const inner_allocator_type& inner_allocator() const noexcept { return inner_.get(*this); }
+
+    outer_allocator_type& outer_allocator() noexcept { return *this; }
+    const outer_allocator_type& outer_allocator() const noexcept { return *this; }
+
+    pointer allocate(size_type count)
+    {
+        return outer_traits::allocate(outer_allocator(), count);
+    }
+
+    void deallocate(pointer p, size_type count)
+    {
+        outer_traits::deallocate(outer_allocator(), p, count);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return outer_traits::max_size(outer_allocator());
+    }
+
+    /**
+     *  Builds a T at p from args..., passing inner_allocator() to it (or to both
+     *  members of a std::pair) if T uses it. The object itself is constructed through
+     *  the outermost allocator, so a customized construct there still runs.
+     */
+    template<typename T, typename... Args>
+    void construct(T* p, Args&&... args)
+    {
+        auto t = uses_allocator_construction_args<T>(inner_allocator(), forward<Args>(args)...);
+        construct_from_tuple(p, std::move(t), std::make_index_sequence<std::tuple_size<decltype(t)>::value>());
+    }
+
+    template<typename T>
+    void destroy(T* p)
+    {
+        typedef detail::outermost_allocator<OuterAlloc> outermost;
+        allocator_traits<typename outermost::type>::destroy(outermost::get(outer_allocator()), p);
+    }
+
+    scoped_allocator_adaptor select_on_container_copy_construction() const
+    {
+        return select(std::index_sequence_for<InnerAllocs...>());
+    }
+
+private:
+    template<typename T, typename Tuple, size_t... I>
+    void construct_from_tuple(T* p, Tuple&& args, std::index_sequence<I...>)
+    {
+        typedef detail::outermost_allocator<OuterAlloc> outermost;
+        allocator_traits<typename outermost::type>::construct(outermost::get(outer_allocator()), p,
+            std::get<I>(forward<Tuple>(args))...);
+    }
+
+    scoped_allocator_adaptor select(std::index_sequence<>) const
+    {
+        return scoped_allocator_adaptor(outer_traits::select_on_container_copy_construction(outer_allocator()));
+    }
+
+    template<size_t... I>
+    scoped_allocator_adaptor select(std::index_sequence<I...>) const
+    {
+        typedef allocator_traits<inner_allocator_type> inner_traits;
+        return scoped_allocator_adaptor(outer_traits::select_on_container_copy_construction(outer_allocator()),
+            inner_traits::select_on_container_copy_construction(inner_allocator()));
+    }
+
+    scoped_allocator_adaptor(OuterAlloc&& outer, const inner_allocator_type& inner) noexcept
+        : OuterAlloc(std::move(outer)), inner_(inner) {}
+};
+
+template<typename OuterA1, typename OuterA2, typename... InnerAllocs>
+inline bool operator==(const scoped_allocator_adaptor<OuterA1, InnerAllocs...>& a,
+    const scoped_allocator_adaptor<OuterA2, InnerAllocs...>& b) noexcept
+{
+    return a.outer_allocator() == b.outer_allocator()
+        && (sizeof...(InnerAllocs) == 0 || a.inner_allocator() == b.inner_allocator());
+}
+template<typename OuterA1, typename OuterA2, typename... InnerAllocs>
+inline bool operator!=(const scoped_allocator_adaptor<OuterA1, InnerAllocs...>& a,
+    const scoped_allocator_adaptor<OuterA2, InnerAllocs...>& b) noexcept
+{
+    return !(a == b);
+}
+
+MYSTD_NS_END
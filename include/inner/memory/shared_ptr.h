@@ -0,0 +1,706 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "../compressed_pair.h"
+#include "allocators.h"
+#include "unique_ptr.h"
+#include <atomic> // atomic
+#include <cstddef> // nullptr_t
+#include <functional> // reference_wrapper
+#include <memory> // bad_weak_ptr
+#include <typeinfo> // type_info
+#include <utility> // move, forward, swap
+
+
+MYSTD_NS_BEGIN
+
+using std::bad_weak_ptr;
+
+template<typename T> class shared_ptr;
+template<typename T> class weak_ptr;
+template<typename T> class enable_shared_from_this;
+
+
+namespace detail {
+
+// Reference counts updated atomically, for owners spread over several threads.
+struct shared_count_atomic
+{
+    typedef atomic<long> type;
+
+    static void increment(type& count) noexcept { count.fetch_add(1, memory_order_relaxed); }
+    static long decrement(type& count) noexcept { return count.fetch_sub(1, memory_order_acq_rel) - 1; }
+    static long load(const type& count) noexcept { return count.load(memory_order_acquire); }
+
+    static bool increment_nonzero(type& count) noexcept
+    {
+        long value = count.load(memory_order_relaxed);
+        while(value != 0)
+            if(count.compare_exchange_weak(value, value + 1, memory_order_acq_rel, memory_order_relaxed))
+                return true;
+        return false;
+    }
+};
+
+// Plain reference counts, for owners that all stay on one thread.
+struct shared_count_local
+{
+    typedef long type;
+
+    static void increment(type& count) noexcept { ++count; }
+    static long decrement(type& count) noexcept { return --count; }
+    static long load(const type& count) noexcept { return count; }
+
+    static bool increment_nonzero(type& count) noexcept
+    {
+        if(count == 0)
+            return false;
+        ++count;
+        return true;
+    }
+};
+
+/**
+ *  The part of a control block that does not depend on how the object is stored.
+ *  weaks_ counts the weak references plus one for all owners together, so the
+ *  block outlives the object until the last weak reference is gone. Count decides
+ *  whether the counts are atomic.
+*/
+template<typename Count>
+class basic_control_block
+{
+    typename Count::type uses_;
+    typename Count::type weaks_;
+
+public:
+    basic_control_block() noexcept : uses_(1), weaks_(1) {}
+
+    basic_control_block(const basic_control_block&) = delete;
+    basic_control_block& operator=(const basic_control_block&) = delete;
+
+    // destroys the managed object
+    virtual void dispose() noexcept = 0;
+    // frees the control block itself (and the object with it, when they share the allocation)
+    virtual void destroy() noexcept = 0;
+    virtual void* get_deleter(const std::type_info&) noexcept { return nullptr; }
+
+    void add_ref() noexcept
+    {
+        Count::increment(uses_);
+    }
+
+    // Adds a use unless the object is already gone; used by weak_ptr::lock().
+    bool add_ref_nonzero() noexcept
+    {
+        return Count::increment_nonzero(uses_);
+    }
+
+    // Always decrements: checking uses_ and weaks_ for a lone owner takes two loads,
+    // and a weak_ptr::lock() on another thread can slip in between them.
+    void release() noexcept
+    {
+        if(Count::decrement(uses_) == 0)
+        {
+            dispose();
+            weak_release();
+        }
+    }
+
+    void weak_add_ref() noexcept
+    {
+        Count::increment(weaks_);
+    }
+
+    void weak_release() noexcept
+    {
+        if(Count::decrement(weaks_) == 0)
+            destroy();
+    }
+
+    long use_count() const noexcept
+    {
+        return Count::load(uses_);
+    }
+
+protected:
+    ~basic_control_block() = default;
+};
+
+typedef basic_control_block<shared_count_atomic> shared_control_block;
+
+// Control block for an object allocated separately, released with a deleter.
+template<typename Ptr, typename Deleter, typename Alloc, typename Count = shared_count_atomic>
+class shared_pointer_block final : public basic_control_block<Count>
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<shared_pointer_block> block_allocator;
+    typedef allocator_traits<block_allocator> block_traits;
+
+    compressed_pair<Ptr, compressed_pair<Deleter, block_allocator>> state_;
+
+public:
+    shared_pointer_block(Ptr p, Deleter d, const Alloc& a)
+        : state_(p, compressed_pair<Deleter, block_allocator>(std::move(d), block_allocator(a))) {}
+
+    // Allocates the block with a. If that fails, d(p) runs before the exception escapes.
+    static shared_pointer_block* create(Ptr p, Deleter d, const Alloc& a)
+    {
+        block_allocator ba(a);
+        shared_pointer_block* block;
+        try
+        {
+            block = to_address(block_traits::allocate(ba, 1));
+        }
+        catch(...)
+        {
+            d(p);
+            throw;
+        }
+        return ::new (static_cast<void*>(block)) shared_pointer_block(p, std::move(d), a);
+    }
+
+    void dispose() noexcept override
+    {
+        state_.second().first()(state_.first());
+    }
+
+    void destroy() noexcept override
+    {
+        block_allocator ba(std::move(state_.second().second()));
+        this->~shared_pointer_block();
+        block_traits::deallocate(ba, this, 1);
+    }
+
+    void* get_deleter(const std::type_info& type) noexcept override
+    {
+        return type == typeid(Deleter) ? static_cast<void*>(&state_.second().first()) : nullptr;
+    }
+};
+
+/**
+ *  Control block with the object inside it, so make_shared and allocate_shared need
+ *  a single allocation. The object is built and destroyed through Alloc rebound to
+ *  the object's type, and the block is freed through Alloc rebound to the block.
+*/
+template<typename T, typename Alloc, typename Count = shared_count_atomic>
+class shared_inplace_block final : public basic_control_block<Count>
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<shared_inplace_block> block_allocator;
+    typedef allocator_traits<block_allocator> block_traits;
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<remove_cv_t<T>> object_allocator;
+    typedef allocator_traits<object_allocator> object_traits;
+
+    block_allocator alloc_;
+    union
+    {
+        remove_cv_t<T> object_;
+    };
+
+public:
+    explicit shared_inplace_block(const Alloc& a) : alloc_(a) {}
+    ~shared_inplace_block() {}
+
+    template<typename... Args>
+    static shared_inplace_block* create(const Alloc& a, Args&&... args)
+    {
+        block_allocator ba(a);
+        shared_inplace_block* block = to_address(block_traits::allocate(ba, 1));
+        ::new (static_cast<void*>(block)) shared_inplace_block(a);
+        try
+        {
+            object_allocator oa(a);
+            object_traits::construct(oa, block->object(), std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            block->~shared_inplace_block();
+            block_traits::deallocate(ba, block, 1);
+            throw;
+        }
+        return block;
+    }
+
+    remove_cv_t<T>* object() noexcept { return mystd::addressof(object_); }
+
+    void dispose() noexcept override
+    {
+        object_allocator oa(alloc_);
+        object_traits::destroy(oa, object());
+    }
+
+    void destroy() noexcept override
+    {
+        block_allocator ba(std::move(alloc_));
+        this->~shared_inplace_block();
+        block_traits::deallocate(ba, this, 1);
+    }
+};
+
+// Selects the private shared_ptr constructor that takes over an already counted reference.
+struct shared_adopt_t {};
+
+// Hooks enable_shared_from_this up; the fallback does nothing for other types.
+template<typename T, typename Y>
+inline void enable_shared_from_this_hook(const shared_ptr<T>& owner, const enable_shared_from_this<Y>* base) noexcept;
+template<typename T>
+inline void enable_shared_from_this_hook(const shared_ptr<T>&, ...) noexcept {}
+
+} // namespace detail
+
+
+/**
+ *  Shared ownership of an object through an atomically reference-counted control
+ *  block. Copies may be made and destroyed concurrently from any thread.
+ *
+ *  make_shared / allocate_shared put the object inside the control block: one
+ *  allocation instead of two, and the count and the object share cache lines.
+*/
+template<typename T>
+class shared_ptr
+{
+    template<typename Y> friend class shared_ptr;
+    template<typename Y> friend class weak_ptr;
+    template<typename Y, typename Alloc, typename... Args>
+    friend shared_ptr<Y> allocate_shared(const Alloc& alloc, Args&&... args);
+
+    T*                              ptr_;
+    detail::shared_control_block*   ctrl_;
+
+    template<typename Y>
+    using _Compatible = enable_if_t<is_convertible_v<Y*, T*>>;
+
+    // adopts a block that already counts this reference
+    shared_ptr(detail::shared_adopt_t, T* p, detail::shared_control_block* ctrl) noexcept : ptr_(p), ctrl_(ctrl) {}
+
+    template<typename Y, typename Deleter, typename Alloc>
+    void adopt(Y* p, Deleter d, const Alloc& a)
+    {
+        ctrl_ = detail::shared_pointer_block<Y*, Deleter, Alloc>::create(p, std::move(d), a);
+        ptr_ = p;
+        detail::enable_shared_from_this_hook(*this, p);
+    }
+
+public:
+    typedef T           element_type;
+    typedef weak_ptr<T> weak_type;
+
+    constexpr shared_ptr() noexcept : ptr_(nullptr), ctrl_(nullptr) {}
+    constexpr shared_ptr(nullptr_t) noexcept : ptr_(nullptr), ctrl_(nullptr) {}
+
+    template<typename Y, typename = _Compatible<Y>>
+    explicit shared_ptr(Y* p) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        adopt(p, default_delete<Y>(), allocator<Y>());
+    }
+
+    template<typename Y, typename Deleter, typename = _Compatible<Y>>
+    shared_ptr(Y* p, Deleter d) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        adopt(p, std::move(d), allocator<Y>());
+    }
+
+    template<typename Y, typename Deleter, typename Alloc, typename = _Compatible<Y>>
+    shared_ptr(Y* p, Deleter d, Alloc a) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        adopt(p, std::move(d), a);
+    }
+
+    template<typename Deleter>
+    shared_ptr(nullptr_t, Deleter d) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        adopt(static_cast<T*>(nullptr), std::move(d), allocator<T>());
+    }
+
+    template<typename Deleter, typename Alloc>
+    shared_ptr(nullptr_t, Deleter d, Alloc a) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        adopt(static_cast<T*>(nullptr), std::move(d), a);
+    }
+
+    // Aliasing constructor: shares r's ownership but points at p (e.g. a member of *r).
+    template<typename Y>
+    shared_ptr(const shared_ptr<Y>& r, element_type* p) noexcept : ptr_(p), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->add_ref();
+    }
+
+    template<typename Y>
+    shared_ptr(shared_ptr<Y>&& r, element_type* p) noexcept : ptr_(p), ctrl_(r.ctrl_)
+    {
+        r.ptr_ = nullptr;
+        r.ctrl_ = nullptr;
+    }
+
+    shared_ptr(const shared_ptr& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->add_ref();
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    shared_ptr(const shared_ptr<Y>& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->add_ref();
+    }
+
+    shared_ptr(shared_ptr&& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        r.ptr_ = nullptr;
+        r.ctrl_ = nullptr;
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    shared_ptr(shared_ptr<Y>&& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        r.ptr_ = nullptr;
+        r.ctrl_ = nullptr;
+    }
+
+    // Throws bad_weak_ptr if r has expired.
+    template<typename Y, typename = _Compatible<Y>>
+    explicit shared_ptr(const weak_ptr<Y>& r) : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ == nullptr || !ctrl_->add_ref_nonzero())
+            throw bad_weak_ptr();
+    }
+
+    template<typename Y, typename Deleter, typename = _Compatible<typename unique_ptr<Y, Deleter>::element_type>>
+    shared_ptr(unique_ptr<Y, Deleter>&& r) : ptr_(nullptr), ctrl_(nullptr)
+    {
+        typedef conditional_t<is_reference_v<Deleter>,
+            std::reference_wrapper<remove_reference_t<Deleter>>, Deleter> stored_deleter;
+        if(r.get() == nullptr)
+            return;
+        Y* p = r.get();
+        ctrl_ = detail::shared_pointer_block<Y*, stored_deleter, allocator<Y>>::create(
+            p, stored_deleter(r.get_deleter()), allocator<Y>());
+        ptr_ = p;
+        r.release();
+        detail::enable_shared_from_this_hook(*this, p);
+    }
+
+    ~shared_ptr()
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->release();
+    }
+
+    shared_ptr& operator=(const shared_ptr& r) noexcept
+    {
+        shared_ptr(r).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    shared_ptr& operator=(const shared_ptr<Y>& r) noexcept
+    {
+        shared_ptr(r).swap(*this);
+        return *this;
+    }
+
+    shared_ptr& operator=(shared_ptr&& r) noexcept
+    {
+        shared_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    shared_ptr& operator=(shared_ptr<Y>&& r) noexcept
+    {
+        shared_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    template<typename Y, typename Deleter>
+    shared_ptr& operator=(unique_ptr<Y, Deleter>&& r)
+    {
+        shared_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { shared_ptr().swap(*this); }
+
+    template<typename Y>
+    void reset(Y* p) { shared_ptr(p).swap(*this); }
+
+    template<typename Y, typename Deleter>
+    void reset(Y* p, Deleter d) { shared_ptr(p, std::move(d)).swap(*this); }
+
+    template<typename Y, typename Deleter, typename Alloc>
+    void reset(Y* p, Deleter d, Alloc a) { shared_ptr(p, std::move(d), a).swap(*this); }
+
+    void swap(shared_ptr& r) noexcept
+    {
+        std::swap(ptr_, r.ptr_);
+        std::swap(ctrl_, r.ctrl_);
+    }
+
+    element_type* get() const noexcept { return ptr_; }
+
+    template<typename U = T>
+    enable_if_t<!is_void<U>::value, U&> operator*() const noexcept { return *ptr_; }
+
+    element_type* operator->() const noexcept { return ptr_; }
+
+    long use_count() const noexcept { return ctrl_ == nullptr ? 0 : ctrl_->use_count(); }
+
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    // Orders by owner (control block) rather than by stored pointer.
+    template<typename Y>
+    bool owner_before(const shared_ptr<Y>& other) const noexcept { return ctrl_ < other.ctrl_; }
+    template<typename Y>
+    bool owner_before(const weak_ptr<Y>& other) const noexcept { return ctrl_ < other.ctrl_; }
+
+    template<typename Deleter, typename Y>
+    friend Deleter* get_deleter(const shared_ptr<Y>& p) noexcept;
+};
+
+
+/**
+ *  A non-owning reference to an object managed by shared_ptr. It keeps the control
+ *  block, not the object, alive; lock() gives a shared_ptr while the object exists.
+*/
+template<typename T>
+class weak_ptr
+{
+    template<typename Y> friend class weak_ptr;
+    template<typename Y> friend class shared_ptr;
+
+    T*                              ptr_;
+    detail::shared_control_block*   ctrl_;
+
+    template<typename Y>
+    using _Compatible = enable_if_t<is_convertible_v<Y*, T*>>;
+
+public:
+    typedef T element_type;
+
+    constexpr weak_ptr() noexcept : ptr_(nullptr), ctrl_(nullptr) {}
+
+    weak_ptr(const weak_ptr& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->weak_add_ref();
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    weak_ptr(const weak_ptr<Y>& r) noexcept : ptr_(nullptr), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+        {
+            ctrl_->weak_add_ref();
+            // converting may need to read the object (virtual base), which is only safe while it is alive
+            ptr_ = r.lock().get();
+        }
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    weak_ptr(const shared_ptr<Y>& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->weak_add_ref();
+    }
+
+    weak_ptr(weak_ptr&& r) noexcept : ptr_(r.ptr_), ctrl_(r.ctrl_)
+    {
+        r.ptr_ = nullptr;
+        r.ctrl_ = nullptr;
+    }
+
+    template<typename Y, typename = _Compatible<Y>>
+    weak_ptr(weak_ptr<Y>&& r) noexcept : weak_ptr(r)
+    {
+        r.reset();
+    }
+
+    ~weak_ptr()
+    {
+        if(ctrl_ != nullptr)
+            ctrl_->weak_release();
+    }
+
+    weak_ptr& operator=(const weak_ptr& r) noexcept
+    {
+        weak_ptr(r).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    weak_ptr& operator=(const weak_ptr<Y>& r) noexcept
+    {
+        weak_ptr(r).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    weak_ptr& operator=(const shared_ptr<Y>& r) noexcept
+    {
+        weak_ptr(r).swap(*this);
+        return *this;
+    }
+
+    weak_ptr& operator=(weak_ptr&& r) noexcept
+    {
+        weak_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    template<typename Y>
+    weak_ptr& operator=(weak_ptr<Y>&& r) noexcept
+    {
+        weak_ptr(std::move(r)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { weak_ptr().swap(*this); }
+
+    void swap(weak_ptr& r) noexcept
+    {
+        std::swap(ptr_, r.ptr_);
+        std::swap(ctrl_, r.ctrl_);
+    }
+
+    long use_count() const noexcept { return ctrl_ == nullptr ? 0 : ctrl_->use_count(); }
+
+    bool expired() const noexcept { return use_count() == 0; }
+
+    // An owning shared_ptr if the object still exists, an empty one otherwise.
+    shared_ptr<T> lock() const noexcept
+    {
+        if(ctrl_ == nullptr || !ctrl_->add_ref_nonzero())
+            return shared_ptr<T>();
+        return shared_ptr<T>(detail::shared_adopt_t(), ptr_, ctrl_);
+    }
+
+    template<typename Y>
+    bool owner_before(const shared_ptr<Y>& other) const noexcept { return ctrl_ < other.ctrl_; }
+    template<typename Y>
+    bool owner_before(const weak_ptr<Y>& other) const noexcept { return ctrl_ < other.ctrl_; }
+};
+
+
+/**
+ *  Base for classes that need a shared_ptr to themselves from inside a member
+ *  function. The weak reference is set when a shared_ptr first takes ownership.
+*/
+template<typename T>
+class enable_shared_from_this
+{
+    template<typename U, typename Y>
+    friend void detail::enable_shared_from_this_hook(const shared_ptr<U>&, const enable_shared_from_this<Y>*) noexcept;
+
+    mutable weak_ptr<T> weak_this_;
+
+protected:
+    constexpr enable_shared_from_this() noexcept {}
+    enable_shared_from_this(const enable_shared_from_this&) noexcept {}
+    enable_shared_from_this& operator=(const enable_shared_from_this&) noexcept { return *this; }
+    ~enable_shared_from_this() = default;
+
+public:
+    shared_ptr<T> shared_from_this() { return shared_ptr<T>(weak_this_); }
+    shared_ptr<const T> shared_from_this() const { return shared_ptr<const T>(weak_this_); }
+
+    weak_ptr<T> weak_from_this() noexcept { return weak_this_; }
+    weak_ptr<const T> weak_from_this() const noexcept { return weak_this_; }
+};
+
+namespace detail {
+
+template<typename T, typename Y>
+inline void enable_shared_from_this_hook(const shared_ptr<T>& owner, const enable_shared_from_this<Y>* base) noexcept
+{
+    if(base != nullptr && base->weak_this_.expired())
+        base->weak_this_ = shared_ptr<Y>(owner, const_cast<Y*>(static_cast<const Y*>(base)));
+}
+
+} // namespace detail
+
+
+/**
+ *  Builds a T from args inside a single allocation made with alloc (rebound to the
+ *  control block type), so pool and arena allocators serve shared objects too.
+*/
+template<typename T, typename Alloc, typename... Args>
+inline shared_ptr<T> allocate_shared(const Alloc& alloc, Args&&... args)
+{
+    typedef detail::shared_inplace_block<T, Alloc> block_type;
+    block_type* block = block_type::create(alloc, std::forward<Args>(args)...);
+    shared_ptr<T> result(detail::shared_adopt_t(), block->object(), block);
+    detail::enable_shared_from_this_hook(result, block->object());
+    return result;
+}
+
+template<typename T, typename... Args>
+inline shared_ptr<T> make_shared(Args&&... args)
+{
+    return mystd::allocate_shared<T>(allocator<T>(), std::forward<Args>(args)...);
+}
+
+
+template<typename T, typename U>
+inline shared_ptr<T> static_pointer_cast(const shared_ptr<U>& r) noexcept
+{
+    return shared_ptr<T>(r, static_cast<T*>(r.get()));
+}
+
+template<typename T, typename U>
+inline shared_ptr<T> const_pointer_cast(const shared_ptr<U>& r) noexcept
+{
+    return shared_ptr<T>(r, const_cast<T*>(r.get()));
+}
+
+template<typename T, typename U>
+inline shared_ptr<T> reinterpret_pointer_cast(const shared_ptr<U>& r) noexcept
+{
+    return shared_ptr<T>(r, reinterpret_cast<T*>(r.get()));
+}
+
+template<typename T, typename U>
+inline shared_ptr<T> dynamic_pointer_cast(const shared_ptr<U>& r) noexcept
+{
+    if(T* p = dynamic_cast<T*>(r.get()))
+        return shared_ptr<T>(r, p);
+    return shared_ptr<T>();
+}
+
+// The deleter p was created with, if it is a Deleter; nullptr otherwise.
+template<typename Deleter, typename T>
+inline Deleter* get_deleter(const shared_ptr<T>& p) noexcept
+{
+    if(p.ctrl_ == nullptr)
+        return nullptr;
+    return static_cast<Deleter*>(p.ctrl_->get_deleter(typeid(Deleter)));
+}
+
+
+template<typename T>
+inline void swap(shared_ptr<T>& a, shared_ptr<T>& b) noexcept { a.swap(b); }
+template<typename T>
+inline void swap(weak_ptr<T>& a, weak_ptr<T>& b) noexcept { a.swap(b); }
+
+// The control block points to the object, never to the pointers that share it.
+template<typename T>
+struct is_trivially_relocatable<shared_ptr<T>> : true_type {};
+template<typename T>
+struct is_trivially_relocatable<weak_ptr<T>> : true_type {};
+
+template<typename T, typename U>
+inline bool operator==(const shared_ptr<T>& a, const shared_ptr<U>& b) noexcept { return a.get() == b.get(); }
+template<typename T, typename U>
+inline bool operator!=(const shared_ptr<T>& a, const shared_ptr<U>& b) noexcept { return a.get() != b.get(); }
+template<typename T, typename U>
+inline bool operator<(const shared_ptr<T>& a, const shared_ptr<U>& b) noexcept { return a.get() < b.get(); }
+template<typename T>
+inline bool operator==(const shared_ptr<T>& a, nullptr_t) noexcept { return !a; }
+template<typename T>
+inline bool operator==(nullptr_t, const shared_ptr<T>& a) noexcept { return !a; }
+template<typename T>
+inline bool operator!=(const shared_ptr<T>& a, nullptr_t) noexcept { return bool(a); }
+template<typename T>
+inline bool operator!=(nullptr_t, const shared_ptr<T>& a) noexcept { return bool(a); }
+
+MYSTD_NS_END
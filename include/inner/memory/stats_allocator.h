@@ -0,0 +1,353 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include "uninitialized.h"
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <cstdio> // snprintf
+#include <atomic> // atomic
+#include <string> // string
+
+
+MYSTD_NS_BEGIN
+
+using std::size_t;
+using std::uint64_t;
+using std::int64_t;
+
+
+// A copy of the counters of one tag, taken by allocation_stats<Tag>::snapshot().
+struct allocation_stats_snapshot
+{
+    static constexpr size_t histogram_buckets = 32; // bucket i: sizes in [2^i, 2^(i+1)), last one is open
+
+    const char* tag;
+    uint64_t    allocations;
+    uint64_t    deallocations;
+    uint64_t    bytes_allocated;
+    uint64_t    bytes_deallocated;
+    uint64_t    live_bytes;
+    uint64_t    peak_live_bytes;
+    uint64_t    histogram[histogram_buckets];
+
+    std::string to_text() const
+    {
+        std::string out;
+        char line[128];
+        std::snprintf(line, sizeof(line), "[%s]\n", tag);
+        out += line;
+        std::snprintf(line, sizeof(line), "  allocations      %llu\n", (unsigned long long)allocations);
+        out += line;
+        std::snprintf(line, sizeof(line), "  deallocations    %llu\n", (unsigned long long)deallocations);
+        out += line;
+        std::snprintf(line, sizeof(line), "  bytes allocated  %llu\n", (unsigned long long)bytes_allocated);
+        out += line;
+        std::snprintf(line, sizeof(line), "  live bytes       %llu\n", (unsigned long long)live_bytes);
+        out += line;
+        std::snprintf(line, sizeof(line), "  peak live bytes  %llu\n", (unsigned long long)peak_live_bytes);
+        out += line;
+        for(size_t i = 0; i < histogram_buckets; ++i)
+        {
+            if(histogram[i] == 0)
+                continue;
+            std::snprintf(line, sizeof(line), "  size >= %-10llu %llu\n",
+                (unsigned long long)1 << i, (unsigned long long)histogram[i]);
+            out += line;
+        }
+        return out;
+    }
+
+    // Histogram keys are the lower bound of each bucket in bytes; empty buckets are skipped.
+    std::string to_json() const
+    {
+        std::string out;
+        char field[128];
+        out += "{\"tag\":\"";
+        for(const char* c = tag; *c != '\0'; ++c)
+        {
+            if(*c == '"' || *c == '\\')
+                out += '\\';
+            out += *c;
+        }
+        std::snprintf(field, sizeof(field),
+            "\",\"allocations\":%llu,\"deallocations\":%llu,\"bytes_allocated\":%llu,",
+            (unsigned long long)allocations, (unsigned long long)deallocations,
+            (unsigned long long)bytes_allocated);
+        out += field;
+        std::snprintf(field, sizeof(field),
+            "\"bytes_deallocated\":%llu,\"live_bytes\":%llu,\"peak_live_bytes\":%llu,\"histogram\":{",
+            (unsigned long long)bytes_deallocated, (unsigned long long)live_bytes,
+            (unsigned long long)peak_live_bytes);
+        out += field;
+        bool first = true;
+        for(size_t i = 0; i < histogram_buckets; ++i)
+        {
+            if(histogram[i] == 0)
+                continue;
+            std::snprintf(field, sizeof(field), "%s\"%llu\":%llu", first ? "" : ",",
+                (unsigned long long)1 << i, (unsigned long long)histogram[i]);
+            out += field;
+            first = false;
+        }
+        out += "}}";
+        return out;
+    }
+};
+
+
+namespace detail {
+
+// Picks a shard for the calling thread once, round-robin over threads.
+inline size_t stats_shard_index(size_t shard_count) noexcept
+{
+    static std::atomic<size_t> next_thread(0);
+    static thread_local size_t index = next_thread.fetch_add(1, std::memory_order_relaxed);
+    return index % shard_count;
+}
+
+inline size_t stats_histogram_bucket(size_t bytes) noexcept
+{
+    size_t bucket = 0;
+    while(bytes > 1 && bucket + 1 < allocation_stats_snapshot::histogram_buckets)
+    {
+        bytes >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+// Pulls Tag::name() when the tag provides one.
+template<typename Tag>
+auto stats_tag_name(int) -> decltype(Tag::name())
+{
+    return Tag::name();
+}
+template<typename Tag>
+const char* stats_tag_name(_Wrap_int)
+{
+    return "untagged";
+}
+
+} // namespace detail
+
+
+/**
+ *  Process-wide allocation counters for one Tag.
+ *
+ *  Counters are split over shard_count cache-line sized shards and updated with
+ *  relaxed atomics, so threads rarely touch the same line. The peak is sampled:
+ *  the shards are summed only when a shard's own live bytes reach a new high
+ *  (and on snapshot()), which is exact for a single thread and cheap in steady state.
+*/
+template<typename Tag>
+class allocation_stats
+{
+public:
+    static constexpr size_t shard_count = 16;
+
+    static void record_allocate(size_t bytes) noexcept
+    {
+        shard& s = shards_[detail::stats_shard_index(shard_count)];
+        s.allocations.fetch_add(1, std::memory_order_relaxed);
+        s.histogram[detail::stats_histogram_bucket(bytes)].fetch_add(1, std::memory_order_relaxed);
+        int64_t live = s.live_bytes.fetch_add((int64_t)bytes, std::memory_order_relaxed) + (int64_t)bytes;
+        if(live > s.shard_peak.load(std::memory_order_relaxed))
+        {
+            s.shard_peak.store(live, std::memory_order_relaxed);
+            update_peak();
+        }
+    }
+
+    static void record_deallocate(size_t bytes) noexcept
+    {
+        shard& s = shards_[detail::stats_shard_index(shard_count)];
+        s.deallocations.fetch_add(1, std::memory_order_relaxed);
+        s.bytes_deallocated.fetch_add(bytes, std::memory_order_relaxed);
+        s.live_bytes.fetch_sub((int64_t)bytes, std::memory_order_relaxed);
+    }
+
+    static allocation_stats_snapshot snapshot() noexcept
+    {
+        update_peak();
+        allocation_stats_snapshot out = {};
+        out.tag = name();
+        int64_t live = 0;
+        for(size_t i = 0; i < shard_count; ++i)
+        {
+            const shard& s = shards_[i];
+            out.allocations += s.allocations.load(std::memory_order_relaxed);
+            out.deallocations += s.deallocations.load(std::memory_order_relaxed);
+            out.bytes_deallocated += s.bytes_deallocated.load(std::memory_order_relaxed);
+            live += s.live_bytes.load(std::memory_order_relaxed);
+            for(size_t b = 0; b < allocation_stats_snapshot::histogram_buckets; ++b)
+                out.histogram[b] += s.histogram[b].load(std::memory_order_relaxed);
+        }
+        out.live_bytes = live > 0 ? (uint64_t)live : 0;
+        out.bytes_allocated = out.bytes_deallocated + out.live_bytes;
+        out.peak_live_bytes = peak_.load(std::memory_order_relaxed);
+        if(out.peak_live_bytes < out.live_bytes)
+            out.peak_live_bytes = out.live_bytes;
+        return out;
+    }
+
+    // Zeroes every counter. Not meant to race with allocations of the same tag.
+    static void reset() noexcept
+    {
+        for(size_t i = 0; i < shard_count; ++i)
+        {
+            shard& s = shards_[i];
+            s.allocations.store(0, std::memory_order_relaxed);
+            s.deallocations.store(0, std::memory_order_relaxed);
+            s.bytes_deallocated.store(0, std::memory_order_relaxed);
+            s.live_bytes.store(0, std::memory_order_relaxed);
+            s.shard_peak.store(0, std::memory_order_relaxed);
+            for(size_t b = 0; b < allocation_stats_snapshot::histogram_buckets; ++b)
+                s.histogram[b].store(0, std::memory_order_relaxed);
+        }
+        peak_.store(0, std::memory_order_relaxed);
+    }
+
+    static const char* name() noexcept
+    {
+        return detail::stats_tag_name<Tag>(0);
+    }
+
+private:
+    struct alignas(hardware_destructive_interference_size) shard
+    {
+        std::atomic<uint64_t> allocations;
+        std::atomic<uint64_t> deallocations;
+        std::atomic<uint64_t> bytes_deallocated;
+        std::atomic<int64_t>  live_bytes;   // may go negative when other threads free this shard's blocks
+        std::atomic<int64_t>  shard_peak;
+        std::atomic<uint64_t> histogram[allocation_stats_snapshot::histogram_buckets];
+    };
+
+    static void update_peak() noexcept
+    {
+        int64_t sum = 0;
+        for(size_t i = 0; i < shard_count; ++i)
+            sum += shards_[i].live_bytes.load(std::memory_order_relaxed);
+        uint64_t live = sum > 0 ? (uint64_t)sum : 0;
+        uint64_t peak = peak_.load(std::memory_order_relaxed);
+        while(live > peak && !peak_.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+            ;
+    }
+
+    static shard                    shards_[shard_count];
+    static std::atomic<uint64_t>    peak_;
+};
+
+template<typename Tag>
+typename allocation_stats<Tag>::shard allocation_stats<Tag>::shards_[allocation_stats<Tag>::shard_count];
+template<typename Tag>
+std::atomic<uint64_t> allocation_stats<Tag>::peak_(0);
+
+
+/**
+ *  Wraps any allocator and records every allocate/deallocate in allocation_stats<Tag>.
+ *  Give Tag a `static const char* name()` to label it in dumps.
+ *  Everything else (construct, propagation, equality) is forwarded to Alloc.
+ *  construct and destroy exist only where Alloc customizes them, so wrapping
+ *  allocator<T> keeps the memcpy and bitwise relocation paths of the containers.
+*/
+template<typename Alloc, typename Tag = void>
+class stats_allocator
+{
+    template<typename, typename> friend class stats_allocator;
+
+    typedef allocator_traits<Alloc> inner_traits;
+
+    Alloc inner_;
+
+public:
+    typedef Alloc                                               inner_allocator_type;
+    typedef typename inner_traits::value_type                   value_type;
+    typedef typename inner_traits::pointer                      pointer;
+    typedef typename inner_traits::const_pointer                const_pointer;
+    typedef typename inner_traits::void_pointer                 void_pointer;
+    typedef typename inner_traits::const_void_pointer           const_void_pointer;
+    typedef typename inner_traits::size_type                    size_type;
+    typedef typename inner_traits::difference_type              difference_type;
+    typedef typename inner_traits::propagate_on_container_copy_assignment propagate_on_container_copy_assignment;
+    typedef typename inner_traits::propagate_on_container_move_assignment propagate_on_container_move_assignment;
+    typedef typename inner_traits::propagate_on_container_swap  propagate_on_container_swap;
+    typedef typename inner_traits::is_always_equal              is_always_equal;
+
+    template<typename Other>
+    struct rebind
+    {
+        typedef stats_allocator<typename inner_traits::template rebind_alloc<Other>, Tag> other;
+    };
+
+    stats_allocator() = default;
+    stats_allocator(const Alloc& inner) noexcept : inner_(inner) {}
+    template<typename OtherAlloc>
+    stats_allocator(const stats_allocator<OtherAlloc, Tag>& other) noexcept : inner_(other.inner_) {}
+
+    pointer allocate(size_type count)
+    {
+        pointer p = inner_traits::allocate(inner_, count);
+        allocation_stats<Tag>::record_allocate(count * sizeof(value_type));
+        return p;
+    }
+
+    allocation_result<pointer, size_type> allocate_at_least(size_type count)
+    {
+        allocation_result<pointer, size_type> r = inner_traits::allocate_at_least(inner_, count);
+        allocation_stats<Tag>::record_allocate(r.count * sizeof(value_type));
+        return r;
+    }
+
+    void deallocate(pointer p, size_type count)
+    {
+        allocation_stats<Tag>::record_deallocate(count * sizeof(value_type));
+        inner_traits::deallocate(inner_, p, count);
+    }
+
+    template<typename T, typename... Args,
+        typename = enable_if_t<detail::alloc_customizes_construct<Alloc, T, Args...>::value>>
+    void construct(T* p, Args&&... args)
+    {
+        inner_traits::construct(inner_, p, forward<Args>(args)...);
+    }
+
+    template<typename T,
+        typename = enable_if_t<detail::alloc_customizes_destroy<Alloc, T>::value>>
+    void destroy(T* p)
+    {
+        inner_traits::destroy(inner_, p);
+    }
+
+    size_type max_size() const noexcept
+    {
+        return inner_traits::max_size(inner_);
+    }
+
+    stats_allocator select_on_container_copy_construction() const
+    {
+        return stats_allocator(inner_traits::select_on_container_copy_construction(inner_));
+    }
+
+    const Alloc& inner_allocator() const noexcept { return inner_; }
+
+    static allocation_stats_snapshot stats() noexcept { return allocation_stats<Tag>::snapshot(); }
+};
+
+template<typename A1, typename A2, typename Tag>
+inline bool operator==(const stats_allocator<A1, Tag>& a, const stats_allocator<A2, Tag>& b) noexcept
+{
+    return a.inner_allocator() == b.inner_allocator();
+}
+template<typename A1, typename A2, typename Tag>
+inline bool operator!=(const stats_allocator<A1, Tag>& a, const stats_allocator<A2, Tag>& b) noexcept
+{
+    return !(a == b);
+}
+
+template<typename Alloc, typename Tag>
+struct is_trivially_relocatable<stats_allocator<Alloc, Tag>> : is_trivially_relocatable<Alloc> {};
+
+MYSTD_NS_END
@@ -0,0 +1,522 @@
+#pragma once
+
+#include "../mystd.h"
+#include "../type_traits.h"
+#include "allocators.h"
+#include <cstddef> // size_t
+#include <cstring> // memcpy, memmove, memset
+#include <iterator> // iterator_traits
+#include <utility> // move
+
+
+MYSTD_NS_BEGIN
+
+using std::size_t;
+
+
+//
+// Bulk construction and destruction over uninitialized memory.
+//
+// Every algorithm picks the cheapest correct loop at compile time: memcpy for
+// trivially copyable elements between raw pointers, memset for fills whose value is
+// all zero bytes, nothing at all for trivial default construction and trivial
+// destruction. If an element constructor throws, the elements built so far are
+// destroyed and the exception is rethrown.
+//
+// The overloads taking an allocator go through allocator_traits::construct/destroy
+// only when the allocator really customizes them; otherwise they use the fast paths.
+//
+
+namespace detail {
+
+template<typename It>
+using iter_value_t = typename std::iterator_traits<It>::value_type;
+
+// Turns any trait (ours or one imported from std) into our true_type/false_type for tag dispatch.
+template<typename Trait>
+using trait_tag = integral_constant<bool, Trait::value>;
+
+// True when copying [In, In + n) to Out may be done with memcpy.
+template<typename In, typename Out>
+struct is_memcpy_copyable : false_type {};
+template<typename T, typename U>
+struct is_memcpy_copyable<T*, U*> : integral_constant<bool,
+    is_same<remove_cv_t<T>, U>::value && is_trivially_copyable_v<U>> {};
+
+template<typename ForwardIt>
+inline void destroy_range(ForwardIt, ForwardIt, true_type) noexcept {}
+
+template<typename ForwardIt>
+inline void destroy_range(ForwardIt first, ForwardIt last, false_type) noexcept
+{
+    typedef iter_value_t<ForwardIt> T;
+    for(; first != last; ++first)
+        mystd::addressof(*first)->~T();
+}
+
+template<typename InputIt, typename ForwardIt>
+inline ForwardIt uninitialized_copy(InputIt first, InputIt last, ForwardIt d_first, false_type)
+{
+    typedef iter_value_t<ForwardIt> T;
+    ForwardIt cur = d_first;
+    try
+    {
+        for(; first != last; ++first, (void)++cur)
+            ::new (static_cast<void*>(mystd::addressof(*cur))) T(*first);
+        return cur;
+    }
+    catch(...)
+    {
+        destroy_range(d_first, cur, detail::trait_tag<is_trivially_destructible<T>>());
+        throw;
+    }
+}
+
+template<typename T, typename U>
+inline U* uninitialized_copy(T* first, T* last, U* d_first, true_type) noexcept
+{
+    size_t n = last - first;
+    if(n != 0)
+        std::memcpy(static_cast<void*>(d_first), static_cast<const void*>(first), n * sizeof(U));
+    return d_first + n;
+}
+
+template<typename T>
+inline bool is_all_zero_bytes(const T& value) noexcept
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(mystd::addressof(value));
+    for(size_t i = 0; i < sizeof(T); ++i)
+        if(bytes[i] != 0)
+            return false;
+    return true;
+}
+
+template<typename ForwardIt, typename T>
+inline void uninitialized_fill(ForwardIt first, ForwardIt last, const T& value, false_type)
+{
+    typedef iter_value_t<ForwardIt> V;
+    ForwardIt cur = first;
+    try
+    {
+        for(; cur != last; ++cur)
+            ::new (static_cast<void*>(mystd::addressof(*cur))) V(value);
+    }
+    catch(...)
+    {
+        destroy_range(first, cur, detail::trait_tag<is_trivially_destructible<V>>());
+        throw;
+    }
+}
+
+template<typename V, typename T>
+inline void uninitialized_fill(V* first, V* last, const T& value, true_type) noexcept
+{
+    V v(value);
+    if(sizeof(V) == 1 || is_all_zero_bytes(v))
+    {
+        if(first != last)
+            std::memset(static_cast<void*>(first), *reinterpret_cast<const unsigned char*>(&v),
+                (last - first) * sizeof(V));
+        return;
+    }
+    for(; first != last; ++first)
+        ::new (static_cast<void*>(first)) V(v);
+}
+
+template<typename ForwardIt, typename T>
+struct is_memset_fillable : false_type {};
+template<typename V, typename T>
+struct is_memset_fillable<V*, T> : integral_constant<bool,
+    is_trivially_copyable_v<V> && is_trivially_constructible<V, const T&>::value && !is_volatile<V>::value> {};
+
+template<typename ForwardIt>
+inline void uninitialized_default_construct(ForwardIt, ForwardIt, true_type) noexcept {}
+
+template<typename ForwardIt>
+inline void uninitialized_default_construct(ForwardIt first, ForwardIt last, false_type)
+{
+    typedef iter_value_t<ForwardIt> T;
+    ForwardIt cur = first;
+    try
+    {
+        for(; cur != last; ++cur)
+            ::new (static_cast<void*>(mystd::addressof(*cur))) T;
+    }
+    catch(...)
+    {
+        destroy_range(first, cur, detail::trait_tag<is_trivially_destructible<T>>());
+        throw;
+    }
+}
+
+template<typename InputIt, typename ForwardIt>
+inline ForwardIt uninitialized_move(InputIt first, InputIt last, ForwardIt d_first, false_type)
+{
+    return detail::uninitialized_copy(std::make_move_iterator(first), std::make_move_iterator(last),
+        d_first, false_type());
+}
+
+template<typename T, typename U>
+inline U* uninitialized_move(T* first, T* last, U* d_first, true_type) noexcept
+{
+    return detail::uninitialized_copy(first, last, d_first, true_type());
+}
+
+template<typename T>
+inline void relocate_at(T* source, T* dest, true_type) noexcept
+{
+    std::memcpy(static_cast<void*>(dest), static_cast<const void*>(source), sizeof(T));
+}
+
+template<typename T>
+inline void relocate_at(T* source, T* dest, false_type) noexcept(is_nothrow_move_constructible<T>::value)
+{
+    ::new (static_cast<void*>(dest)) T(std::move(*source));
+    source->~T();
+}
+
+template<typename T>
+inline T* uninitialized_relocate(T* first, T* last, T* d_first, true_type) noexcept
+{
+    // memmove: containers relocate within their own buffer when they insert and erase
+    if(first != last)
+        std::memmove(static_cast<void*>(d_first), static_cast<const void*>(first), (last - first) * sizeof(T));
+    return d_first + (last - first);
+}
+
+template<typename T>
+inline T* uninitialized_relocate(T* first, T* last, T* d_first, false_type)
+{
+    T* cur = d_first;
+    try
+    {
+        for(; first != last; ++first, (void)++cur)
+            detail::relocate_at(first, cur, false_type());
+        return cur;
+    }
+    catch(...)
+    {
+        destroy_range(first, last, trait_tag<is_trivially_destructible<T>>());
+        destroy_range(d_first, cur, trait_tag<is_trivially_destructible<T>>());
+        throw;
+    }
+}
+
+template<typename ForwardIt>
+inline void uninitialized_value_construct(ForwardIt first, ForwardIt last, false_type)
+{
+    typedef iter_value_t<ForwardIt> T;
+    ForwardIt cur = first;
+    try
+    {
+        for(; cur != last; ++cur)
+            ::new (static_cast<void*>(mystd::addressof(*cur))) T();
+    }
+    catch(...)
+    {
+        destroy_range(first, cur, detail::trait_tag<is_trivially_destructible<T>>());
+        throw;
+    }
+}
+
+// value-initializing a trivial type is filling it with T(), which usually is all zero bytes
+template<typename T>
+inline void uninitialized_value_construct(T* first, T* last, true_type) noexcept
+{
+    detail::uninitialized_fill(first, last, T(), true_type());
+}
+
+template<typename ForwardIt>
+struct is_trivially_value_constructible : false_type {};
+template<typename T>
+struct is_trivially_value_constructible<T*> : integral_constant<bool,
+    is_trivial<T>::value && !is_volatile<T>::value> {};
+
+
+/**
+ *  Whether allocator_traits<Alloc>::construct(a, T*, Args...) would do anything other
+ *  than placement new. allocator<U> counts as not customizing: its construct is
+ *  exactly placement new.
+*/
+template<typename Alloc, typename Void, typename T, typename... Args>
+struct alloc_has_construct : false_type {};
+template<typename Alloc, typename T, typename... Args>
+struct alloc_has_construct<Alloc,
+    void_t<decltype(declval<Alloc&>().construct(declval<T*>(), declval<Args>()...))>, T, Args...>
+    : true_type {};
+
+template<typename Alloc, typename T, typename... Args>
+struct alloc_customizes_construct : alloc_has_construct<Alloc, void, T, Args...> {};
+template<typename U, typename T, typename... Args>
+struct alloc_customizes_construct<allocator<U>, T, Args...> : false_type {};
+
+template<typename Alloc, typename Void, typename T>
+struct alloc_has_destroy : false_type {};
+template<typename Alloc, typename T>
+struct alloc_has_destroy<Alloc, void_t<decltype(declval<Alloc&>().destroy(declval<T*>()))>, T>
+    : true_type {};
+
+template<typename Alloc, typename T>
+struct alloc_customizes_destroy : alloc_has_destroy<Alloc, void, T> {};
+template<typename U, typename T>
+struct alloc_customizes_destroy<allocator<U>, T> : false_type {};
+
+} // namespace detail
+
+
+template<typename T>
+inline void destroy_at(T* p) noexcept
+{
+    p->~T();
+}
+
+template<typename ForwardIt>
+inline void destroy(ForwardIt first, ForwardIt last) noexcept
+{
+    detail::destroy_range(first, last,
+        detail::trait_tag<is_trivially_destructible<detail::iter_value_t<ForwardIt>>>());
+}
+
+template<typename ForwardIt, typename Size>
+inline ForwardIt destroy_n(ForwardIt first, Size n) noexcept
+{
+    ForwardIt last = first;
+    std::advance(last, n);
+    destroy(first, last);
+    return last;
+}
+
+template<typename InputIt, typename ForwardIt>
+inline ForwardIt uninitialized_copy(InputIt first, InputIt last, ForwardIt d_first)
+{
+    return detail::uninitialized_copy(first, last, d_first,
+        typename detail::is_memcpy_copyable<InputIt, ForwardIt>::type());
+}
+
+template<typename InputIt, typename Size, typename ForwardIt>
+inline ForwardIt uninitialized_copy_n(InputIt first, Size n, ForwardIt d_first)
+{
+    InputIt last = first;
+    std::advance(last, n);
+    return uninitialized_copy(first, last, d_first);
+}
+
+template<typename InputIt, typename ForwardIt>
+inline ForwardIt uninitialized_move(InputIt first, InputIt last, ForwardIt d_first)
+{
+    return detail::uninitialized_move(first, last, d_first,
+        typename detail::is_memcpy_copyable<InputIt, ForwardIt>::type());
+}
+
+/**
+ *  Moves *source into the uninitialized storage at dest and ends the lifetime of
+ *  *source: one memcpy if T is trivially relocatable, a move construction and a
+ *  destruction otherwise. If the move throws, *source is left alive.
+*/
+template<typename T>
+inline T* relocate_at(T* source, T* dest) noexcept(is_trivially_relocatable_v<T> || is_nothrow_move_constructible<T>::value)
+{
+    detail::relocate_at(source, dest, detail::trait_tag<is_trivially_relocatable<T>>());
+    return dest;
+}
+
+/**
+ *  Relocates [first, last) into the uninitialized storage at d_first, see relocate_at.
+ *  Trivially relocatable elements go in one memmove, so the ranges may overlap;
+ *  otherwise d_first must not lie inside [first, last). If a move throws, all the
+ *  elements of both ranges are destroyed.
+*/
+template<typename T>
+inline T* uninitialized_relocate(T* first, T* last, T* d_first)
+{
+    return detail::uninitialized_relocate(first, last, d_first, detail::trait_tag<is_trivially_relocatable<T>>());
+}
+
+template<typename ForwardIt, typename T>
+inline void uninitialized_fill(ForwardIt first, ForwardIt last, const T& value)
+{
+    detail::uninitialized_fill(first, last, value,
+        typename detail::is_memset_fillable<ForwardIt, T>::type());
+}
+
+template<typename ForwardIt, typename Size, typename T>
+inline ForwardIt uninitialized_fill_n(ForwardIt first, Size n, const T& value)
+{
+    ForwardIt last = first;
+    std::advance(last, n);
+    uninitialized_fill(first, last, value);
+    return last;
+}
+
+template<typename ForwardIt>
+inline void uninitialized_default_construct(ForwardIt first, ForwardIt last)
+{
+    detail::uninitialized_default_construct(first, last,
+        integral_constant<bool, is_trivially_default_constructible_v<detail::iter_value_t<ForwardIt>>>());
+}
+
+template<typename ForwardIt, typename Size>
+inline ForwardIt uninitialized_default_construct_n(ForwardIt first, Size n)
+{
+    ForwardIt last = first;
+    std::advance(last, n);
+    uninitialized_default_construct(first, last);
+    return last;
+}
+
+template<typename ForwardIt>
+inline void uninitialized_value_construct(ForwardIt first, ForwardIt last)
+{
+    detail::uninitialized_value_construct(first, last,
+        typename detail::is_trivially_value_constructible<ForwardIt>::type());
+}
+
+template<typename ForwardIt, typename Size>
+inline ForwardIt uninitialized_value_construct_n(ForwardIt first, Size n)
+{
+    ForwardIt last = first;
+    std::advance(last, n);
+    uninitialized_value_construct(first, last);
+    return last;
+}
+
+
+//
+// allocator-aware versions, used by containers
+//
+
+namespace detail {
+
+template<typename Alloc, typename T>
+inline void destroy_a(T* first, T* last, Alloc&, false_type) noexcept
+{
+    mystd::destroy(first, last);
+}
+
+template<typename Alloc, typename T>
+inline void destroy_a(T* first, T* last, Alloc& alloc, true_type) noexcept
+{
+    for(; first != last; ++first)
+        allocator_traits<Alloc>::destroy(alloc, first);
+}
+
+template<typename Alloc, typename T, typename Construct>
+inline T* construct_a(T* first, T* last, Alloc& alloc, Construct construct)
+{
+    T* cur = first;
+    try
+    {
+        for(; cur != last; ++cur)
+            construct(cur);
+        return cur;
+    }
+    catch(...)
+    {
+        destroy_a(first, cur, alloc, typename alloc_customizes_destroy<Alloc, T>::type());
+        throw;
+    }
+}
+
+template<typename InputIt, typename T, typename Alloc>
+inline T* uninitialized_copy_a(InputIt first, InputIt last, T* d_first, Alloc&, false_type)
+{
+    return mystd::uninitialized_copy(first, last, d_first);
+}
+
+template<typename InputIt, typename T, typename Alloc>
+inline T* uninitialized_copy_a(InputIt first, InputIt last, T* d_first, Alloc& alloc, true_type)
+{
+    T* cur = d_first;
+    try
+    {
+        for(; first != last; ++first, (void)++cur)
+            allocator_traits<Alloc>::construct(alloc, cur, *first);
+        return cur;
+    }
+    catch(...)
+    {
+        destroy_a(d_first, cur, alloc, typename alloc_customizes_destroy<Alloc, T>::type());
+        throw;
+    }
+}
+
+} // namespace detail
+
+template<typename T, typename Alloc>
+inline void destroy(T* first, T* last, Alloc& alloc) noexcept
+{
+    detail::destroy_a(first, last, alloc, typename detail::alloc_customizes_destroy<Alloc, T>::type());
+}
+
+template<typename InputIt, typename T, typename Alloc>
+inline T* uninitialized_copy(InputIt first, InputIt last, T* d_first, Alloc& alloc)
+{
+    typedef decltype(*first) Ref;
+    return detail::uninitialized_copy_a(first, last, d_first, alloc,
+        typename detail::alloc_customizes_construct<Alloc, T, Ref>::type());
+}
+
+template<typename InputIt, typename T, typename Alloc>
+inline T* uninitialized_move(InputIt first, InputIt last, T* d_first, Alloc& alloc)
+{
+    typedef decltype(std::move(*first)) Ref;
+    typedef typename detail::alloc_customizes_construct<Alloc, T, Ref>::type custom;
+    if(!custom::value)
+        return mystd::uninitialized_move(first, last, d_first);
+    return detail::uninitialized_copy_a(std::make_move_iterator(first), std::make_move_iterator(last),
+        d_first, alloc, true_type());
+}
+
+// Bitwise only if the allocator customizes neither construct nor destroy, see uninitialized_relocate above.
+template<typename T, typename Alloc>
+inline T* uninitialized_relocate(T* first, T* last, T* d_first, Alloc& alloc)
+{
+    if(!detail::alloc_customizes_construct<Alloc, T, T&&>::value && !detail::alloc_customizes_destroy<Alloc, T>::value)
+        return mystd::uninitialized_relocate(first, last, d_first);
+    T* cur = d_first;
+    try
+    {
+        for(; first != last; ++first, (void)++cur)
+        {
+            allocator_traits<Alloc>::construct(alloc, cur, std::move(*first));
+            allocator_traits<Alloc>::destroy(alloc, first);
+        }
+        return cur;
+    }
+    catch(...)
+    {
+        mystd::destroy(first, last, alloc);
+        mystd::destroy(d_first, cur, alloc);
+        throw;
+    }
+}
+
+template<typename T, typename U, typename Alloc>
+inline void uninitialized_fill(T* first, T* last, const U& value, Alloc& alloc)
+{
+    if(!detail::alloc_customizes_construct<Alloc, T, const U&>::value)
+        return mystd::uninitialized_fill(first, last, value);
+    detail::construct_a(first, last, alloc,
+        [&](T* p) { allocator_traits<Alloc>::construct(alloc, p, value); });
+}
+
+template<typename T, typename Alloc>
+inline void uninitialized_default_construct(T* first, T* last, Alloc& alloc)
+{
+    // allocator_traits::construct(a, p) value-initializes, so only the plain path can default-initialize
+    if(!detail::alloc_customizes_construct<Alloc, T>::value)
+        return mystd::uninitialized_default_construct(first, last);
+    detail::construct_a(first, last, alloc,
+        [&](T* p) { allocator_traits<Alloc>::construct(alloc, p); });
+}
+
+template<typename T, typename Alloc>
+inline void uninitialized_value_construct(T* first, T* last, Alloc& alloc)
+{
+    if(!detail::alloc_customizes_construct<Alloc, T>::value)
+        return mystd::uninitialized_value_construct(first, last);
+    detail::construct_a(first, last, alloc,
+        [&](T* p) { allocator_traits<Alloc>::construct(alloc, p); });
+}
+
+MYSTD_NS_END
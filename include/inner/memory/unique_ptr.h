@@ -2,6 +2,9 @@
 
 #include "../mystd.h"
 #include "../type_traits.h"
+#include "../compressed_pair.h"
+#include <cstddef> // size_t, nullptr_t
+#include <utility> // move, forward, swap
 
 
 MYSTD_NS_BEGIN
@@ -57,8 +60,8 @@ class unique_ptr {
         typedef decltype(__test<remove_reference_t<Deleter>>(0)) type;
     };
 
-    typename _Pointer::type     p_;
-    Deleter                     d_;
+    // the deleter is usually empty: stored this way it adds nothing to the size of the pointer
+    compressed_pair<typename _Pointer::type, Deleter> pd_;
 public:
     typedef typename _Pointer::type     pointer; // std::remove_reference<Deleter>::type::pointer if that type exists, otherwise T*. Must satisfy NullablePointer
     typedef T                           element_type;
@@ -66,21 +69,21 @@ public:
 
     // Default constructor, creates a unique_ptr that owns nothing.
     constexpr unique_ptr() noexcept 
-        : p_(pointer()), d_(deleter_type()) 
+        : pd_(pointer(), deleter_type()) 
     { static_assert(!is_pointer_v<deleter_type>, "constructed with null function pointer deleter"); }
 
     explicit unique_ptr(pointer p) noexcept
-        : p_(p), d_(deleter_type())
+        : pd_(p, deleter_type())
     { static_assert(!is_pointer_v<deleter_type>, "constructed with null function pointer deleter"); }
 
     unique_ptr(pointer p,
         conditional_t<is_reference_v<deleter_type>,
             deleter_type, const deleter_type&> d) noexcept
-        : p_(p), d_(d) {}
+        : pd_(p, d) {}
     
     unique_ptr(pointer p,
         add_rvalue_reference_t<deleter_type> d) noexcept
-        : p_(std::move(p)), d_(std::move(d)) // todo
+        : pd_(std::move(p), std::move(d))
     { static_assert(!is_reference_v<deleter_type>, "rvalue deleter bound to reference"); }
 
     constexpr unique_ptr(nullptr_t) noexcept : unique_ptr() {}
@@ -88,7 +91,7 @@ public:
     // Move constructors
 
     unique_ptr(unique_ptr&& u) noexcept
-        : p_(u.release()), d_(std::forward<deleter_type>(u.get_deleter())) {}
+        : pd_(u.release(), std::forward<deleter_type>(u.get_deleter())) {}
 
     // Converting constructor form another type
     template<typename T2, typename D2,
@@ -97,14 +100,14 @@ public:
             && (is_reference_v<Deleter> ? is_same_v<D2, Deleter> : is_convertible_v<D2, Deleter>),
             void>>
     unique_ptr(unique_ptr<T2, D2>&& u) noexcept
-    : p_(u.release()), d_(std::forward<D2>(u.get_deleter())) {}
+    : pd_(u.release(), std::forward<D2>(u.get_deleter())) {}
 
     // Destructor
     ~unique_ptr() noexcept
     {
-        if(p_ != pointer())
-            get_deleter()(p_);
-        p_ = pointer(); // clean it
+        if(pd_.first() != pointer())
+            get_deleter()(pd_.first());
+        pd_.first() = pointer(); // clean it
     }
 
     // Assignment
@@ -129,7 +132,7 @@ public:
     operator=(unique_ptr<T2, D2>&& rhs) noexcept
     {
         reset(rhs.release());
-        d_ = std::forward<D2>(rhs.get_deleter());
+        pd_.second() = std::forward<D2>(rhs.get_deleter());
         return *this;
     }
 
@@ -139,7 +142,7 @@ public:
         return *this;
     }
 
-    add_lvalue_reference<element_type> operator*() const
+    add_lvalue_reference_t<element_type> operator*() const
     {
         return *get();
     }
@@ -149,11 +152,11 @@ public:
         return get();
     }
 
-    pointer get() const noexcept { return p_; }
+    pointer get() const noexcept { return pd_.first(); }
 
-    deleter_type& get_deleter() noexcept { return d_; }
+    deleter_type& get_deleter() noexcept { return pd_.second(); }
 
-    const deleter_type& get_deleter() const noexcept { return d_; }
+    const deleter_type& get_deleter() const noexcept { return pd_.second(); }
 
     explicit operator bool() const noexcept
     {
@@ -162,23 +165,22 @@ public:
 
     pointer release() noexcept
     {
-        pointer ret = p_;
-        p_ = pointer(); // clean it
+        pointer ret = pd_.first();
+        pd_.first() = pointer(); // clean it
         return ret;
     }
 
     void reset(pointer p = pointer()) noexcept
     {
-        pointer old = p_;
-        p_ = p;
+        pointer old = pd_.first();
+        pd_.first() = p;
         if(old != pointer())
             get_deleter()(old);
     }
 
     void swap(unique_ptr& u) noexcept
     {
-        std::swap(u.p_, p_);
-        std::swap(u.d_, d_);
+        pd_.swap(u.pd_);
     }
 
     // Disable copy from lvalue
@@ -187,12 +189,233 @@ public:
 };
 
 
+namespace detail {
+
+// V* may be adopted by a unique_ptr<T[]> when a V array converts to a T array (only adds cv).
+template<typename U, typename T>
+struct is_array_pointer_convertible : false_type {};
+template<typename V, typename T>
+struct is_array_pointer_convertible<V*, T> : integral_constant<bool, is_convertible_v<V(*)[], T(*)[]>> {};
+
+} // namespace detail
+
 template<typename T, typename Deleter>
 class unique_ptr<T[], Deleter>
 {
-    // unique_ptr for array objects is not achieved!
-    explicit unique_ptr() = delete; // todo: show a error info while compiling.
+    // same lookup of Deleter::pointer as the primary template
+    class _Pointer
+    {
+        template<typename _Up>
+        static typename _Up::pointer __test(typename _Up::pointer*);
+
+        template<typename _Up>
+        static T* __test(...);
+    public:
+        typedef decltype(__test<remove_reference_t<Deleter>>(0)) type;
+    };
+
+    // the deleter is usually empty: stored this way it adds nothing to the size of the pointer
+    compressed_pair<typename _Pointer::type, Deleter> pd_;
+
+    // U can be adopted: our pointer type, or a U* whose array converts to ours (i.e. only added cv)
+    template<typename U>
+    using _Acceptable_pointer = integral_constant<bool,
+        is_same_v<U, typename _Pointer::type>
+        || (is_same_v<typename _Pointer::type, T*> && detail::is_array_pointer_convertible<U, T>::value)>;
+
+public:
+    typedef typename _Pointer::type     pointer;
+    typedef T                           element_type;
+    typedef Deleter                     deleter_type;
+
+    constexpr unique_ptr() noexcept
+        : pd_(pointer(), deleter_type())
+    { static_assert(!is_pointer_v<deleter_type>, "constructed with null function pointer deleter"); }
+
+    template<typename U,
+        typename = enable_if_t<_Acceptable_pointer<U>::value>>
+    explicit unique_ptr(U p) noexcept
+        : pd_(p, deleter_type())
+    { static_assert(!is_pointer_v<deleter_type>, "constructed with null function pointer deleter"); }
+
+    template<typename U,
+        typename = enable_if_t<_Acceptable_pointer<U>::value>>
+    unique_ptr(U p,
+        conditional_t<is_reference_v<deleter_type>,
+            deleter_type, const deleter_type&> d) noexcept
+        : pd_(p, d) {}
+
+    template<typename U,
+        typename = enable_if_t<_Acceptable_pointer<U>::value>>
+    unique_ptr(U p,
+        add_rvalue_reference_t<deleter_type> d) noexcept
+        : pd_(p, std::move(d))
+    { static_assert(!is_reference_v<deleter_type>, "rvalue deleter bound to reference"); }
+
+    constexpr unique_ptr(nullptr_t) noexcept : unique_ptr() {}
+
+    unique_ptr(unique_ptr&& u) noexcept
+        : pd_(u.release(), std::forward<deleter_type>(u.get_deleter())) {}
+
+    // Converting constructor from an array of a less cv-qualified type
+    template<typename T2, typename D2,
+        typename = enable_if_t<is_array_v<T2>
+            && is_same_v<pointer, element_type*>
+            && is_same_v<typename unique_ptr<T2, D2>::pointer, typename unique_ptr<T2, D2>::element_type*>
+            && is_convertible_v<typename unique_ptr<T2, D2>::element_type(*)[], element_type(*)[]>
+            && (is_reference_v<Deleter> ? is_same_v<D2, Deleter> : is_convertible_v<D2, Deleter>),
+            void>>
+    unique_ptr(unique_ptr<T2, D2>&& u) noexcept
+        : pd_(u.release(), std::forward<D2>(u.get_deleter())) {}
+
+    ~unique_ptr() noexcept
+    {
+        if(pd_.first() != pointer())
+            get_deleter()(pd_.first());
+        pd_.first() = pointer();
+    }
+
+    unique_ptr& operator=(unique_ptr&& u) noexcept
+    {
+        reset(u.release());
+        get_deleter() = std::forward<deleter_type>(u.get_deleter());
+        return *this;
+    }
+
+    template<typename T2, typename D2>
+    enable_if_t<is_array_v<T2>
+        && is_same_v<pointer, element_type*>
+        && is_same_v<typename unique_ptr<T2, D2>::pointer, typename unique_ptr<T2, D2>::element_type*>
+        && is_convertible_v<typename unique_ptr<T2, D2>::element_type(*)[], element_type(*)[]>
+        && is_assignable_v<Deleter&, D2&&>,
+        unique_ptr&>
+    operator=(unique_ptr<T2, D2>&& rhs) noexcept
+    {
+        reset(rhs.release());
+        pd_.second() = std::forward<D2>(rhs.get_deleter());
+        return *this;
+    }
+
+    unique_ptr& operator=(nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    element_type& operator[](size_t i) const
+    {
+        return get()[i];
+    }
+
+    pointer get() const noexcept { return pd_.first(); }
+
+    deleter_type& get_deleter() noexcept { return pd_.second(); }
+
+    const deleter_type& get_deleter() const noexcept { return pd_.second(); }
+
+    explicit operator bool() const noexcept
+    {
+        return get() == pointer() ? false : true;
+    }
+
+    pointer release() noexcept
+    {
+        pointer ret = pd_.first();
+        pd_.first() = pointer();
+        return ret;
+    }
+
+    template<typename U,
+        typename = enable_if_t<_Acceptable_pointer<U>::value>>
+    void reset(U p) noexcept
+    {
+        pointer old = pd_.first();
+        pd_.first() = p;
+        if(old != pointer())
+            get_deleter()(old);
+    }
+
+    void reset(nullptr_t = nullptr) noexcept
+    {
+        reset(pointer());
+    }
+
+    void swap(unique_ptr& u) noexcept
+    {
+        pd_.swap(u.pd_);
+    }
+
+    unique_ptr(const unique_ptr&) = delete;
+    unique_ptr& operator=(const unique_ptr&) = delete;
 };
 
 
+template<typename T, typename D>
+inline void swap(unique_ptr<T, D>& a, unique_ptr<T, D>& b) noexcept
+{
+    a.swap(b);
+}
+
+// A unique_ptr is its pointer and its deleter; neither refers back to the unique_ptr.
+template<typename T, typename D>
+struct is_trivially_relocatable<unique_ptr<T, D>> : integral_constant<bool,
+    is_trivially_relocatable<typename unique_ptr<T, D>::pointer>::value && is_trivially_relocatable<D>::value> {};
+
+template<typename T1, typename D1, typename T2, typename D2>
+inline bool operator==(const unique_ptr<T1, D1>& a, const unique_ptr<T2, D2>& b)
+{
+    return a.get() == b.get();
+}
+template<typename T1, typename D1, typename T2, typename D2>
+inline bool operator!=(const unique_ptr<T1, D1>& a, const unique_ptr<T2, D2>& b)
+{
+    return a.get() != b.get();
+}
+template<typename T, typename D>
+inline bool operator==(const unique_ptr<T, D>& a, nullptr_t) noexcept { return !a; }
+template<typename T, typename D>
+inline bool operator==(nullptr_t, const unique_ptr<T, D>& a) noexcept { return !a; }
+template<typename T, typename D>
+inline bool operator!=(const unique_ptr<T, D>& a, nullptr_t) noexcept { return bool(a); }
+template<typename T, typename D>
+inline bool operator!=(nullptr_t, const unique_ptr<T, D>& a) noexcept { return bool(a); }
+
+
+// make_unique<T>(args...): a new T built from args.
+template<typename T, typename... Args>
+inline enable_if_t<!is_array_v<T>, unique_ptr<T>> make_unique(Args&&... args)
+{
+    return unique_ptr<T>(new T(std::forward<Args>(args)...));
+}
+
+// make_unique<T[]>(n): n value-initialized elements (zeroed for trivial types).
+template<typename T>
+inline enable_if_t<is_array_v<T> && extent<T>::value == 0, unique_ptr<T>> make_unique(size_t n)
+{
+    return unique_ptr<T>(new remove_extent_t<T>[n]());
+}
+
+template<typename T, typename... Args>
+enable_if_t<extent<T>::value != 0> make_unique(Args&&...) = delete;
+
+/**
+ *  Like make_unique, but the object or elements are default-initialized: trivial
+ *  types are left uninitialized instead of zeroed. Meant for buffers that are about
+ *  to be overwritten anyway, where zeroing would only cost memory bandwidth.
+*/
+template<typename T>
+inline enable_if_t<!is_array_v<T>, unique_ptr<T>> make_unique_for_overwrite()
+{
+    return unique_ptr<T>(new T);
+}
+
+template<typename T>
+inline enable_if_t<is_array_v<T> && extent<T>::value == 0, unique_ptr<T>> make_unique_for_overwrite(size_t n)
+{
+    return unique_ptr<T>(new remove_extent_t<T>[n]);
+}
+
+template<typename T, typename... Args>
+enable_if_t<extent<T>::value != 0> make_unique_for_overwrite(Args&&...) = delete;
+
 MYSTD_NS_END
@@ -60,8 +60,10 @@ template<typename T> using add_rvalue_reference_t = typename add_rvalue_referenc
 // helper class:
 //
 
+// Derives from the std one so that our traits (e.g. an allocator's propagate_on_*
+// typedefs) also select the right overload when standard library code dispatches on them.
 template <typename T, T v>
-struct integral_constant
+struct integral_constant : std::integral_constant<T, v>
 {
     static constexpr T value = v;
     typedef T value_type;
@@ -321,6 +323,16 @@ template<typename T> struct is_unsigned : integral_constant<bool,
         ! is_signed_v<T>> {};
 template<typename T> constexpr bool is_unsigned_v = is_unsigned<T>::value;
 
+/**
+ *  Whether moving a T to new storage and destroying the original can be done by
+ *  copying its bytes and forgetting the original (see relocate_at). True for
+ *  trivially copyable types. A class that owns resources but holds no pointer
+ *  into itself, such as unique_ptr, opts in by specializing this trait.
+*/
+template<typename T> struct is_trivially_relocatable : integral_constant<bool, is_trivially_copyable_v<T>> {};
+template<typename T> struct is_trivially_relocatable<const T> : is_trivially_relocatable<T> {};
+template<typename T> constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
 
 
 //
@@ -442,6 +454,16 @@ template<typename T> struct add_rvalue_reference      { typedef T&& type; };
 template<typename T> struct add_rvalue_reference<T&>  { typedef T&& type; };
 template<typename T> struct add_rvalue_reference<T&&> { typedef T&& type; };
 
+// there are no references to void: void stays as it is
+template<> struct add_lvalue_reference<void>                { typedef void type; };
+template<> struct add_lvalue_reference<const void>          { typedef const void type; };
+template<> struct add_lvalue_reference<volatile void>       { typedef volatile void type; };
+template<> struct add_lvalue_reference<const volatile void> { typedef const volatile void type; };
+template<> struct add_rvalue_reference<void>                { typedef void type; };
+template<> struct add_rvalue_reference<const void>          { typedef const void type; };
+template<> struct add_rvalue_reference<volatile void>       { typedef volatile void type; };
+template<> struct add_rvalue_reference<const volatile void> { typedef const volatile void type; };
+
 // pointers
 
 template<typename T> struct remove_pointer                      { typedef T type; };
@@ -0,0 +1,66 @@
+#include "test.h"
+
+#include <inner/memory/allocators.h>
+
+#include <cstdint>
+
+
+struct alignas(64) PaddedCounter
+{
+    long value;
+};
+
+struct alignas(32) Vec8f
+{
+    float lanes[8];
+};
+
+bool aligned(const void* p, size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+template<typename Alloc>
+void check(Alloc alloc, size_t alignment)
+{
+    typedef allocator_traits<Alloc> traits;
+    typename traits::pointer ptrs[16];
+    for(size_t i = 0; i < 16; ++i)
+    {
+        ptrs[i] = traits::allocate(alloc, i + 1);
+        test(aligned(ptrs[i], alignment));
+    }
+    for(size_t i = 0; i < 16; ++i)
+        traits::deallocate(alloc, ptrs[i], i + 1);
+}
+
+
+int main()
+{
+    // allocator<T> honours alignof(T)
+    check(allocator<PaddedCounter>(), 64);
+    check(allocator<Vec8f>(), 32);
+    check(allocator<double>(), alignof(double));
+
+    // pool_allocator sends over-aligned types to the aligned path
+    check(pool_allocator<PaddedCounter>(), 64);
+
+    // aligned_allocator forces the alignment on any element type
+    typedef aligned_allocator<float, 32> FloatAlloc;
+    static_assert(FloatAlloc::alignment == 32, "alignment");
+    static_assert(aligned_allocator<PaddedCounter, 16>::alignment == 64, "never weaker than alignof(T)");
+    check(FloatAlloc(), 32);
+    check(aligned_allocator<char, hardware_destructive_interference_size>(), 64);
+    check(aligned_allocator<PaddedCounter, 16>(), 64);
+
+    typedef allocator_traits<FloatAlloc>::rebind_alloc<double> DoubleAlloc;
+    static_assert(is_same<DoubleAlloc, aligned_allocator<double, 32>>::value, "rebind keeps Align");
+    test(DoubleAlloc() == FloatAlloc());
+
+    float* buf = FloatAlloc().allocate(1024);
+    for(int i = 0; i < 1024; ++i)
+        buf[i] = float(i);
+    test(buf[1023] == 1023.0f);
+    FloatAlloc().deallocate(buf, 1024);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "test.h"
+
+#include <inner/memory/allocators.h>
+#include <inner/memory/stats_allocator.h>
+
+#include <cstdlib>
+#include <new>
+
+
+// count sized deletes and remember the last size passed
+static int sized_deletes = 0;
+static std::size_t last_deleted_size = 0;
+
+void* operator new(std::size_t size)
+{
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if(p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, std::size_t size) noexcept
+{
+    ++sized_deletes;
+    last_deleted_size = size;
+    std::free(p);
+}
+
+struct no_feedback_allocator
+{
+    typedef int value_type;
+    int* allocate(std::size_t n) { return static_cast<int*>(std::malloc(n * sizeof(int))); }
+    void deallocate(int* p, std::size_t) { std::free(p); }
+};
+
+struct Node
+{
+    Node* next;
+    long value;
+};
+
+
+int main()
+{
+#if defined(__cpp_sized_deallocation) && !defined(MYSTD_USABLE_SIZE)
+    // without usable size feedback, allocator<T>::deallocate uses the sized operator delete
+    allocator<double> da;
+    double* d = da.allocate(7);
+    da.deallocate(d, 7);
+    test(sized_deletes == 1);
+    test(last_deleted_size == 7 * sizeof(double));
+#endif
+
+    // allocate_at_least reports at least what was asked for, and the whole count can be given back
+    typedef allocator_traits<allocator<char>> CharTraits;
+    allocator<char> ca;
+    allocation_result<char*> r = CharTraits::allocate_at_least(ca, 100);
+    test(r.ptr != nullptr && r.count >= 100);
+    r.ptr[r.count - 1] = 'x';
+    int sized_before = sized_deletes;
+    CharTraits::deallocate(ca, r.ptr, r.count);
+    // a count that includes slack never reaches the sized operator delete
+    test(sized_deletes == sized_before || last_deleted_size == 100);
+
+    // allocators without allocate_at_least get exactly what they asked for
+    no_feedback_allocator na;
+    allocation_result<int*> nr = allocator_traits<no_feedback_allocator>::allocate_at_least(na, 10);
+    test(nr.count == 10);
+    na.deallocate(nr.ptr, nr.count);
+
+    // pool_allocator hands out the rest of the size class
+    pool_allocator<char> pa;
+    allocation_result<char*> pr = allocator_traits<pool_allocator<char>>::allocate_at_least(pa, 20);
+    test(pr.count == 32);
+    pa.deallocate(pr.ptr, pr.count);
+    test(pa.allocate(17) == pr.ptr);
+
+    // stats_allocator records the real size
+    struct tag {};
+    stats_allocator<allocator<Node>, tag> sa;
+    allocation_result<Node*> sr = sa.allocate_at_least(3);
+    test(allocation_stats<tag>::snapshot().bytes_allocated == sr.count * sizeof(Node));
+    sa.deallocate(sr.ptr, sr.count);
+    test(allocation_stats<tag>::snapshot().live_bytes == 0);
+    return 0;
+}
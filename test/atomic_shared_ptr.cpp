@@ -0,0 +1,112 @@
+#include "test.h"
+
+#include <inner/memory/atomic_shared_ptr.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+static std::atomic<int> alive(0);
+
+// Both fields always hold the same number; a torn or freed snapshot would show otherwise.
+struct Config
+{
+    long version;
+    long check;
+    explicit Config(long v) : version(v), check(v) { ++alive; }
+    ~Config() { check = -1; --alive; }
+};
+
+
+int main()
+{
+    test(atomic_shared_ptr<Config>().is_lock_free());
+
+    // load, store, exchange
+    {
+        atomic_shared_ptr<Config> current;
+        test(!current.load());
+
+        shared_ptr<Config> first = make_shared<Config>(1);
+        current.store(first);
+        test(current.load() == first);
+        test(first.use_count() == 2);
+
+        shared_ptr<Config> old = current.exchange(make_shared<Config>(2));
+        test(old == first && current.load()->version == 2);
+        old.reset();
+        first.reset();
+        test(alive == 1);
+
+        current = nullptr;
+        test(alive == 0 && !current.load());
+    }
+
+    // compare_exchange matches on pointer and owner
+    {
+        shared_ptr<Config> a = make_shared<Config>(1);
+        shared_ptr<Config> b = make_shared<Config>(2);
+        atomic_shared_ptr<Config> current(a);
+
+        shared_ptr<Config> expected = b;
+        test(!current.compare_exchange_strong(expected, make_shared<Config>(3)));
+        test(expected == a && alive == 2);
+
+        test(current.compare_exchange_strong(expected, b));
+        test(current.load() == b);
+        test(a.use_count() == 2);
+
+        // an alias of the stored value points elsewhere, so it does not match
+        shared_ptr<Config> alias(b, a.get());
+        test(!current.compare_exchange_weak(alias, nullptr) && alias == b);
+
+        shared_ptr<Config> empty;
+        test(!current.compare_exchange_strong(empty, a));
+        test(current.compare_exchange_strong(empty, nullptr) && !current.load());
+    }
+    test(alive == 0);
+
+    // readers never see a torn or freed config while writers replace it
+    {
+        atomic_shared_ptr<Config> current(make_shared<Config>(0));
+        std::atomic<bool> stop(false);
+        std::atomic<long> bad(0);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 3; ++t)
+            threads.emplace_back([&]
+            {
+                long last = 0;
+                while(!stop.load(std::memory_order_relaxed))
+                {
+                    shared_ptr<Config> c = current.load();
+                    if(c->check != c->version || c->version < last)
+                        ++bad;
+                    last = c->version;
+                }
+            });
+        for(int t = 0; t < 2; ++t)
+            threads.emplace_back([&]
+            {
+                for(int i = 0; i < 5000; ++i)
+                {
+                    shared_ptr<Config> seen = current.load();
+                    shared_ptr<Config> next = make_shared<Config>(seen->version + 1);
+                    while(!current.compare_exchange_weak(seen, next))
+                        next = make_shared<Config>(seen->version + 1);
+                }
+            });
+        threads[3].join();
+        threads[4].join();
+        stop = true;
+        for(int t = 0; t < 3; ++t)
+            threads[t].join();
+
+        test(bad == 0);
+        shared_ptr<Config> last = current.load();
+        test(last->version == 10000 && last.use_count() == 2);
+    }
+    test(alive == 0);
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "test.h"
+
+#include <inner/compressed_pair.h>
+#include <inner/memory/unique_ptr.h>
+#include <inner/memory/inline_allocator.h>
+
+#include <string>
+#include <tuple>
+#include <utility>
+
+
+struct Empty {};
+struct OtherEmpty {};
+struct FinalEmpty final {};
+
+struct Counter
+{
+    int* count;
+    explicit Counter(int* c) : count(c) {}
+    void operator()(int* p) const { ++*count; delete p; }
+};
+
+
+int main()
+{
+    // empty members take no room unless they are final
+    static_assert(sizeof(compressed_pair<int*, Empty>) == sizeof(int*), "empty second");
+    static_assert(sizeof(compressed_pair<Empty, int*>) == sizeof(int*), "empty first");
+    static_assert(sizeof(compressed_pair<Empty, OtherEmpty>) == 1, "two empties");
+    static_assert(sizeof(compressed_pair<int*, FinalEmpty>) > sizeof(int*), "final cannot be a base");
+
+    // so a unique_ptr with a stateless deleter is as small as a raw pointer
+    static_assert(sizeof(unique_ptr<int>) == sizeof(int*), "unique_ptr<T>");
+    static_assert(sizeof(unique_ptr<int[]>) == sizeof(int*), "unique_ptr<T[]>");
+    static_assert(sizeof(unique_ptr<std::string>) == sizeof(std::string*), "unique_ptr<class>");
+    static_assert(sizeof(unique_ptr<int, Counter>) == 2 * sizeof(int*), "stateful deleters are kept");
+
+    // and an inline_allocator over a stateless upstream is just the arena pointer
+    static_assert(sizeof(inline_allocator<int, 64>) == sizeof(void*), "inline_allocator");
+
+    // members keep their values
+    {
+        compressed_pair<int, std::string> p(1, "one");
+        test(p.first() == 1 && p.second() == "one");
+        p.second() += "!";
+        compressed_pair<int, std::string> q(2, "two");
+        swap(p, q);
+        test(p.first() == 2 && q.second() == "one!");
+
+        compressed_pair<std::string, Empty> e("text", Empty());
+        test(e.first() == "text");
+
+        compressed_pair<std::string, int> piecewise(std::piecewise_construct,
+            std::forward_as_tuple(3, 'x'), std::forward_as_tuple(4));
+        test(piecewise.first() == "xxx" && piecewise.second() == 4);
+
+        compressed_pair<int, int> same;
+        test(same.first() == 0 && same.second() == 0);
+    }
+
+    // reference members refer to the original
+    {
+        int count = 0;
+        Counter c(&count);
+        compressed_pair<int*, Counter&> r(nullptr, c);
+        test(&r.second() == &c);
+
+        unique_ptr<int, Counter&> up(new int(5), c);
+        test(&up.get_deleter() == &c);
+        up.reset();
+        test(count == 1);
+    }
+    return 0;
+}
@@ -0,0 +1,316 @@
+#include "test.h"
+
+#include <inner/containers/deque.h>
+#include <inner/memory/stats_allocator.h>
+
+#include <deque>
+#include <numeric>
+#include <string>
+#include <vector>
+
+
+static int live = 0;
+static int throw_after = -1; // copies left before a copy throws, -1 for never
+
+struct Tracked
+{
+    int value;
+    Tracked(int v = 0) : value(v) { ++live; }
+    Tracked(const Tracked& other) : value(other.value)
+    {
+        if(throw_after == 0)
+            throw 1;
+        if(throw_after > 0)
+            --throw_after;
+        ++live;
+    }
+    Tracked& operator=(const Tracked&) = default;
+    ~Tracked() { --live; }
+};
+
+struct empty_tag {};
+struct fifo_tag {};
+struct throw_tag {};
+
+template<typename Deque>
+bool equals(const Deque& d, std::initializer_list<typename Deque::value_type> expected)
+{
+    return d.size() == expected.size() && std::equal(d.begin(), d.end(), expected.begin());
+}
+
+template<typename Deque, typename Oracle>
+bool same(const Deque& d, const Oracle& o)
+{
+    return d.size() == o.size() && std::equal(d.begin(), d.end(), o.begin())
+        && std::equal(d.rbegin(), d.rend(), o.rbegin());
+}
+
+
+int main()
+{
+    // both ends, across blocks
+    {
+        deque<int, allocator<int>, 4> d;
+        test(d.empty() && d.begin() == d.end() && d.size() == 0);
+        for(int i = 0; i < 10; ++i)
+            d.push_back(i);
+        for(int i = 1; i <= 10; ++i)
+            d.push_front(-i);
+        test(d.size() == 20 && d.front() == -10 && d.back() == 9 && d[10] == 0 && d.at(19) == 9);
+        test(d.end() - d.begin() == 20 && *(d.begin() + 13) == 3 && *(d.end() - 7) == 3);
+        test(d.cbegin() < d.cend() && d.begin() + 20 == d.end() && d.end() - 20 == d.cbegin());
+
+        bool thrown = false;
+        try
+        {
+            d.at(20);
+        }
+        catch(const std::out_of_range&)
+        {
+            thrown = true;
+        }
+        test(thrown);
+
+        // references survive pushes at either end
+        int& ref = d[10];
+        for(int i = 0; i < 100; ++i)
+        {
+            d.push_back(i);
+            d.push_front(i);
+        }
+        test(&ref == &d[110] && ref == 0);
+
+        while(d.size() > 1)
+        {
+            d.pop_front();
+            d.pop_back();
+        }
+        test(d.size() == 0 && d.empty());
+        d.emplace_back(5);
+        d.emplace_front(4);
+        test(equals(d, {4, 5}));
+    }
+
+    // an empty deque allocates nothing, an emptied one gives its memory back
+    {
+        typedef stats_allocator<allocator<std::string>, empty_tag> Alloc;
+        {
+            deque<std::string, Alloc, 8> d;
+            deque<std::string, Alloc, 8> moved(std::move(d));
+            test(allocation_stats<empty_tag>::snapshot().allocations == 0);
+
+            for(int i = 0; i < 100; ++i)
+                moved.push_back(std::to_string(i));
+            moved.clear();
+            moved.shrink_to_fit();
+            test(allocation_stats<empty_tag>::snapshot().live_bytes == 0);
+
+            moved.resize(20, "x");
+            moved.resize(3);
+            test(equals(moved, {"x", "x", "x"}));
+        }
+        allocation_stats_snapshot s = allocation_stats<empty_tag>::snapshot();
+        test(s.allocations == s.deallocations && s.live_bytes == 0);
+    }
+
+    // a FIFO holds only the blocks its elements are in, and the map stays put
+    {
+        typedef stats_allocator<allocator<int>, fifo_tag> Alloc;
+        {
+            deque<int, Alloc, 64> q;
+            for(int i = 0; i < 1000; ++i)
+                q.push_back(i);
+            uint64_t allocated = allocation_stats<fifo_tag>::snapshot().live_bytes;
+            int expected = 0;
+            bool in_order = true;
+            for(int i = 1000; i < 100000; ++i)
+            {
+                q.push_back(i);
+                in_order &= q.front() == expected++;
+                q.pop_front();
+            }
+            allocation_stats_snapshot s = allocation_stats<fifo_tag>::snapshot();
+            test(in_order && q.size() == 1000 && q.front() == 99000 && s.live_bytes <= allocated + 64 * sizeof(int));
+        }
+        allocation_stats_snapshot s = allocation_stats<fifo_tag>::snapshot();
+        test(s.allocations == s.deallocations && s.live_bytes == 0);
+    }
+
+    // insert and erase anywhere, against std::deque
+    {
+        deque<int, allocator<int>, 3> d;
+        std::deque<int> o;
+        unsigned seed = 1;
+        auto rand = [&seed](unsigned n) { seed = seed * 1103515245 + 12345; return (seed >> 16) % n; };
+        bool ok = true;
+        for(int i = 0; i < 2000 && ok; ++i)
+        {
+            unsigned pos = rand(unsigned(o.size()) + 1);
+            int v = int(rand(1000));
+            switch(rand(6))
+            {
+            case 0:
+                d.insert(d.begin() + pos, v);
+                o.insert(o.begin() + pos, v);
+                break;
+            case 1:
+                d.insert(d.begin() + pos, size_t(v % 7), v);
+                o.insert(o.begin() + pos, size_t(v % 7), v);
+                break;
+            case 2:
+            {
+                int src[] = {v, v + 1, v + 2, v + 3, v + 4};
+                d.insert(d.begin() + pos, src, src + v % 6);
+                o.insert(o.begin() + pos, src, src + v % 6);
+                break;
+            }
+            case 3:
+                if(pos < o.size())
+                {
+                    auto next = d.erase(d.begin() + pos);
+                    ok &= next == d.begin() + pos;
+                    o.erase(o.begin() + pos);
+                }
+                break;
+            case 4:
+            {
+                unsigned count = rand(unsigned(o.size() - pos) + 1);
+                d.erase(d.begin() + pos, d.begin() + pos + count);
+                o.erase(o.begin() + pos, o.begin() + pos + count);
+                break;
+            }
+            default:
+                d.emplace(d.cbegin() + pos, v);
+                o.emplace(o.begin() + pos, v);
+                break;
+            }
+            ok &= same(d, o);
+        }
+        test(ok);
+
+        // an element inserted from the deque itself
+        deque<int, allocator<int>, 3> s = {1, 2, 3, 4, 5, 6, 7};
+        s.insert(s.begin() + 5, s[1]);
+        s.insert(s.begin() + 1, 2, s[6]);
+        test(equals(s, {1, 6, 6, 2, 3, 4, 5, 2, 6, 7}));
+    }
+
+    // copies, moves, assignment, comparison
+    {
+        deque<std::string, allocator<std::string>, 2> a = {"a", "b", "c", "d", "e"};
+        deque<std::string, allocator<std::string>, 2> b(a);
+        test(a == b && !(a < b));
+        b.assign(3, "z");
+        test(equals(b, {"z", "z", "z"}) && a < b && a != b);
+        b.assign(a.begin() + 1, a.end());
+        test(equals(b, {"b", "c", "d", "e"}));
+        b = {"q"};
+        test(equals(b, {"q"}));
+        b = a;
+        test(b == a);
+
+        deque<std::string, allocator<std::string>, 2> m(std::move(b));
+        test(m == a && b.empty());
+        b = std::move(m);
+        test(b == a && m.empty());
+        m.push_back("only");
+        swap(m, b);
+        test(equals(m, {"a", "b", "c", "d", "e"}) && equals(b, {"only"}));
+
+        std::string words[] = {"x", "y"};
+        deque<std::string> from_range(words, words + 2);
+        test(equals(from_range, {"x", "y"}) && deque<int>(3, 7) == deque<int>({7, 7, 7}));
+    }
+
+    // segmented algorithms run one loop per block
+    {
+        deque<int, allocator<int>, 16> d(100);
+        int calls = 0;
+        for_each_segment(d.begin() + 10, d.end() - 10, [&calls](int* first, int* last)
+        {
+            ++calls;
+            test(first != last && last - first <= 16);
+        });
+        test(calls == 6); // [10, 90) touches blocks 0..5
+
+        int n = 0;
+        mystd::for_each(d.begin(), d.end(), [&n](int& x) { x = n++; });
+        test(d[0] == 0 && d[99] == 99);
+
+        std::vector<int> out(100);
+        test(mystd::copy(d.begin(), d.end(), out.begin()) == out.end() && out[57] == 57);
+
+        deque<int, allocator<int>, 7> other(100);
+        test(mystd::copy(d.begin() + 5, d.end(), other.begin()) == other.begin() + 95);
+        test(other[0] == 5 && other[94] == 99 && other[95] == 0);
+        test(mystd::copy(out.begin(), out.begin() + 32, d.begin() + 16) == d.begin() + 48);
+        test(d[16] == 0 && d[47] == 31 && d[48] == 48);
+
+        mystd::fill(d.begin() + 3, d.begin() + 70, -1);
+        test(d[2] == 2 && d[3] == -1 && d[69] == -1 && d[70] == 70);
+
+        mystd::move_backward(other.begin(), other.begin() + 50, other.begin() + 60);
+        test(other[10] == 5 && other[59] == 54 && other[9] == 14);
+        mystd::copy_backward(out.begin(), out.begin() + 3, d.end());
+        test(d[97] == 0 && d[99] == 2);
+
+        const deque<int, allocator<int>, 16>& c = d;
+        long sum = 0;
+        mystd::for_each(c.begin(), c.end(), [&sum](int x) { sum += x; });
+        test(sum == std::accumulate(c.begin(), c.end(), 0L));
+    }
+
+    // a throwing copy leaves the deque as it was
+    {
+        typedef stats_allocator<allocator<Tracked>, throw_tag> Alloc;
+        {
+            deque<Tracked, Alloc, 4> d(6, Tracked(1));
+            Tracked src[20];
+            throw_after = 13;
+            bool thrown = false;
+            try
+            {
+                d.insert(d.end(), src, src + 20);
+            }
+            catch(int)
+            {
+                thrown = true;
+            }
+            throw_after = -1;
+            test(thrown && d.size() == 6 && live == 26);
+
+            throw_after = 9;
+            thrown = false;
+            try
+            {
+                d.insert(d.begin() + 1, src, src + 20);
+            }
+            catch(int)
+            {
+                thrown = true;
+            }
+            throw_after = -1;
+            test(thrown && d.size() == 6 && live == 26);
+
+            throw_after = 0;
+            thrown = false;
+            try
+            {
+                d.push_front(src[0]);
+            }
+            catch(int)
+            {
+                thrown = true;
+            }
+            throw_after = -1;
+            test(thrown && d.size() == 6 && live == 26);
+        }
+        test(live == 0);
+        allocation_stats_snapshot s = allocation_stats<throw_tag>::snapshot();
+        test(s.allocations == s.deallocations && s.live_bytes == 0);
+    }
+
+    static_assert(is_trivially_relocatable_v<deque<int>>, "");
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "test.h"
+
+#include <inner/memory/inline_allocator.h>
+
+#include <cstdint>
+
+
+int main()
+{
+    typedef inline_allocator<int, 64> IntAlloc;
+    typedef allocator_traits<IntAlloc> IntTraits;
+    typedef IntTraits::rebind_alloc<double> DoubleAlloc;
+
+    static_assert(is_same<DoubleAlloc, inline_allocator<double, 64, alignof(max_align_t), allocator<double>>>::value,
+        "rebind_alloc");
+    static_assert(!IntTraits::propagate_on_container_copy_assignment::value, "pocca");
+    static_assert(!IntTraits::propagate_on_container_move_assignment::value, "pocma");
+    static_assert(!IntTraits::propagate_on_container_swap::value, "pocs");
+    static_assert(!IntTraits::is_always_equal::value, "stateful");
+
+    // small requests come from the buffer, the rest spills upstream
+    {
+        IntAlloc::arena_type arena;
+        IntAlloc a(arena);
+        int* p = IntTraits::allocate(a, 8);
+        test(arena.owns(p) && arena.used() == 8 * sizeof(int));
+        int* q = IntTraits::allocate(a, 16);
+        test(!arena.owns(q));
+        IntTraits::deallocate(a, q, 16);
+
+        // freeing the last block hands it back
+        IntTraits::deallocate(a, p, 8);
+        test(arena.used() == 0);
+
+        DoubleAlloc d(a);
+        test(d == a && d.arena() == &arena);
+        double* x = allocator_traits<DoubleAlloc>::allocate(d, 2);
+        test(arena.owns(x) && reinterpret_cast<std::uintptr_t>(x) % alignof(double) == 0);
+        allocator_traits<DoubleAlloc>::deallocate(d, x, 2);
+    }
+
+    // growing like a container: the old block is freed right after the bigger one is taken
+    {
+        IntAlloc::arena_type arena;
+        IntAlloc a(arena);
+        size_t cap = 2;
+        int* data = IntTraits::allocate(a, cap);
+        for(int round = 0; round < 4; ++round)
+        {
+            int* bigger = IntTraits::allocate(a, cap * 2);
+            IntTraits::deallocate(a, data, cap);
+            data = bigger;
+            cap *= 2;
+        }
+        test(cap == 32 && !arena.owns(data));
+        data[31] = 31;
+        IntTraits::deallocate(a, data, cap);
+    }
+
+    // a copy never aliases the source's buffer
+    {
+        IntAlloc::arena_type arena;
+        IntAlloc a(arena);
+        IntAlloc copy = IntTraits::select_on_container_copy_construction(a);
+        test(copy.arena() == nullptr && copy != a);
+        test(IntTraits::select_on_container_copy_construction(copy) == copy);
+
+        int* p = IntTraits::allocate(copy, 1);
+        test(!arena.owns(p) && arena.used() == 0);
+        IntTraits::deallocate(copy, p, 1);
+
+        // copies made by the allocator itself do share the arena, they must compare equal
+        IntAlloc same(a);
+        test(same == a && same.arena() == &arena);
+        IntAlloc::arena_type other;
+        test(IntAlloc(other) != a);
+    }
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "test.h"
+
+#include <inner/memory/intrusive_ptr.h>
+
+#include <thread>
+#include <vector>
+
+
+static int alive = 0;
+
+struct Shared : intrusive_ref_counter<Shared>
+{
+    int value;
+    Shared(int v) : value(v) { ++alive; }
+    Shared(const Shared& other) : intrusive_ref_counter(other), value(other.value) { ++alive; }
+    ~Shared() { --alive; }
+};
+
+struct Local : intrusive_ref_counter<Local, thread_unsafe_counter>
+{
+    Local() { ++alive; }
+    ~Local() { --alive; }
+};
+
+struct Derived : Shared
+{
+    Derived() : Shared(2) {}
+};
+
+// A type with its own count and hooks, found by argument-dependent lookup.
+namespace legacy {
+
+struct Handle
+{
+    int refs = 0;
+    bool freed = false;
+};
+
+void intrusive_ptr_add_ref(Handle* h) { ++h->refs; }
+void intrusive_ptr_release(Handle* h) { if(--h->refs == 0) h->freed = true; }
+
+} // namespace legacy
+
+
+int main()
+{
+    static_assert(sizeof(intrusive_ptr<Shared>) == sizeof(Shared*), "one pointer");
+    static_assert(sizeof(Local) == sizeof(unsigned long), "the count is the only overhead");
+
+    // atomic counter
+    {
+        intrusive_ptr<Shared> a(new Shared(1));
+        test(alive == 1 && a->use_count() == 1);
+        intrusive_ptr<Shared> b = a;
+        test(a->use_count() == 2 && a == b);
+        intrusive_ptr<Shared> c = std::move(b);
+        test(!b && a->use_count() == 2);
+
+        // a raw pointer can be handed around and picked up again
+        intrusive_ptr<Shared> d(c.get());
+        test(a->use_count() == 3);
+        a.reset();
+        c.reset();
+        d = nullptr;
+        test(alive == 0);
+    }
+
+    // a copied object starts with its own count
+    {
+        intrusive_ptr<Shared> a(new Shared(3));
+        intrusive_ptr<Shared> b(new Shared(*a));
+        test(a->use_count() == 1 && b->use_count() == 1 && b->value == 3 && alive == 2);
+    }
+    test(alive == 0);
+
+    // non-atomic counter, detach and adopt
+    {
+        intrusive_ptr<Local> a(new Local);
+        Local* raw = a.detach();
+        test(!a && raw->use_count() == 1);
+        intrusive_ptr<Local> b(raw, false);
+        test(raw->use_count() == 1);
+    }
+    test(alive == 0);
+
+    // conversions and casts
+    {
+        intrusive_ptr<Derived> d(new Derived);
+        intrusive_ptr<Shared> s = d;
+        test(s->use_count() == 2 && s->value == 2);
+        intrusive_ptr<Derived> back = static_pointer_cast<Derived>(s);
+        test(back == d && d->use_count() == 3);
+    }
+    test(alive == 0);
+
+    // hooks of a type that does not use the base class
+    {
+        legacy::Handle h;
+        {
+            intrusive_ptr<legacy::Handle> a(&h);
+            intrusive_ptr<legacy::Handle> b = a;
+            test(h.refs == 2);
+        }
+        test(h.refs == 0 && h.freed);
+    }
+
+    // copies and drops from several threads leave the count exact
+    {
+        intrusive_ptr<Shared> p(new Shared(0));
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t)
+            threads.emplace_back([&p]
+            {
+                for(int i = 0; i < 10000; ++i)
+                    intrusive_ptr<Shared> copy = p;
+            });
+        for(std::thread& t : threads)
+            t.join();
+        test(p->use_count() == 1);
+    }
+    test(alive == 0);
+
+    return 0;
+}
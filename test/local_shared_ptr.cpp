@@ -0,0 +1,76 @@
+#include "test.h"
+
+#include <inner/memory/local_shared_ptr.h>
+#include <inner/memory/stats_allocator.h>
+
+
+static int alive = 0;
+
+struct Base
+{
+    int id;
+    Base(int i) : id(i) { ++alive; }
+    virtual ~Base() { --alive; }
+};
+
+struct Derived : Base
+{
+    long extra;
+    Derived(int i, long e) : Base(i), extra(e) {}
+};
+
+struct local_tag {};
+
+
+int main()
+{
+    // no accidental trips between the thread-safe and the local family
+    static_assert(!is_constructible<shared_ptr<int>, local_shared_ptr<int>>::value, "local to shared");
+    static_assert(!is_constructible<local_shared_ptr<int>, shared_ptr<int>>::value, "shared to local");
+    static_assert(!is_convertible<local_shared_ptr<int>, shared_ptr<int>>::value, "local to shared");
+    static_assert(!is_convertible<shared_ptr<int>, local_shared_ptr<int>>::value, "shared to local");
+    static_assert(is_convertible<local_shared_ptr<Derived>, local_shared_ptr<Base>>::value, "upcast");
+
+    // ownership and counts
+    {
+        local_shared_ptr<Base> a(new Derived(1, 2));
+        test(alive == 1 && a.use_count() == 1);
+        local_shared_ptr<Base> b = a;
+        test(a.use_count() == 2 && a == b);
+        local_shared_ptr<Base> c = std::move(b);
+        test(!b && c.use_count() == 2);
+        a.reset();
+        c = nullptr;
+        test(alive == 0 && c == nullptr);
+    }
+
+    // make_local_shared: one allocation, released when the last owner goes
+    {
+        typedef stats_allocator<allocator<Derived>, local_tag> Alloc;
+        local_shared_ptr<Derived> p = allocate_local_shared<Derived>(Alloc(), 3, 4L);
+        local_shared_ptr<Base> q = p;
+        test(q->id == 3 && p->extra == 4 && p.use_count() == 2);
+        test(allocation_stats<local_tag>::snapshot().allocations == 1);
+        p.reset();
+        q.reset();
+        test(alive == 0 && allocation_stats<local_tag>::snapshot().deallocations == 1);
+
+        local_shared_ptr<long> pooled = allocate_local_shared<long>(pool_allocator<long>(), 5L);
+        test(*pooled == 5);
+    }
+
+    // unique_ptr, aliasing and casts
+    {
+        local_shared_ptr<Base> owner(unique_ptr<Derived>(new Derived(5, 6)));
+        local_shared_ptr<Derived> down = dynamic_pointer_cast<Derived>(owner);
+        test(down && down.use_count() == 2);
+        local_shared_ptr<long> member(down, &down->extra);
+        owner.reset();
+        down.reset();
+        test(alive == 1 && *member == 6);
+        member.reset();
+        test(alive == 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "test.h"
+
+#include <inner/memory/mapped_file_allocator.h>
+
+#include <cstdio>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+struct Node
+{
+    long value;
+    offset_ptr<Node> next;
+};
+
+// the root object kept in the file
+struct List
+{
+    mapped_file_allocator<Node> alloc;
+    offset_ptr<Node> head;
+    long size;
+
+    explicit List(const mapped_file_allocator<Node>& a) : alloc(a), head(), size(0) {}
+
+    void push_front(long value)
+    {
+        typedef allocator_traits<mapped_file_allocator<Node>> traits;
+        traits::pointer n = traits::allocate(alloc, 1);
+        traits::construct(alloc, to_address(n), Node{ value, head });
+        head = n;
+        ++size;
+    }
+};
+
+
+int main()
+{
+    typedef allocator_traits<mapped_file_allocator<int>> IntTraits;
+    static_assert(is_same<IntTraits::pointer, offset_ptr<int>>::value, "pointer");
+    static_assert(is_same<IntTraits::const_pointer, offset_ptr<const int>>::value, "const_pointer");
+    static_assert(is_same<IntTraits::rebind_alloc<Node>, mapped_file_allocator<Node>>::value, "rebind_alloc");
+    static_assert(is_same<IntTraits::size_type, size_t>::value, "size_type");
+
+    std::string path = "/tmp/mystd_mapped_file_test_" + std::to_string((long)::getpid());
+    std::remove(path.c_str());
+
+    {
+        mapped_file file(path.c_str(), 1 << 20);
+        test(file.created());
+        List* list = file.find_or_construct_root<List>(file.get_allocator<Node>());
+        for(long i = 0; i < 1000; ++i)
+            list->push_front(i);
+
+        // freed blocks are reused
+        mapped_file_allocator<char> ca = file.get_allocator<char>();
+        offset_ptr<char> block = ca.allocate(100);
+        size_t used = file.segment().bytes_used();
+        ca.deallocate(block, 100);
+        test(ca.allocate(90) == block);
+        test(file.segment().bytes_used() == used);
+        file.flush();
+    }
+
+    // map something first so the file is likely to land at another address
+    void* hole = ::mmap(nullptr, 1 << 20, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    {
+        mapped_file file(path.c_str(), 0);
+        test(!file.created());
+        List* list = file.find_or_construct_root<List>(file.get_allocator<Node>());
+        test(list->size == 1000);
+        long expected = 999;
+        for(offset_ptr<Node> n = list->head; n; n = n->next)
+            test(n->value == expected--);
+        test(expected == -1);
+
+        // keep growing it through the allocator stored in the file
+        list->push_front(1000);
+        test(list->head->value == 1000);
+        test(list->alloc == file.get_allocator<Node>());
+    }
+    ::munmap(hole, 1 << 20);
+
+    // not one of ours
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    std::fputs("garbage", f);
+    std::fclose(f);
+    bool thrown = false;
+    try { mapped_file bad(path.c_str(), 4096); }
+    catch(std::runtime_error&) { thrown = true; }
+    test(thrown);
+
+    // too small to hold the segment header and a block
+    std::remove(path.c_str());
+    thrown = false;
+    try { mapped_file tiny(path.c_str(), sizeof(mapped_segment)); }
+    catch(std::invalid_argument&) { thrown = true; }
+    test(thrown);
+    {
+        mapped_file smallest(path.c_str(), mapped_segment::min_capacity());
+        test(smallest.created());
+        test(smallest.get_allocator<char>().allocate(mapped_segment::min_block_size) != nullptr);
+    }
+
+    std::remove(path.c_str());
+    return 0;
+}
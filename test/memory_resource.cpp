@@ -0,0 +1,159 @@
+#include "test.h"
+
+#include <inner/memory/memory_resource.h>
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+
+// counts what reaches it, forwards to new_delete_resource
+class counting_resource : public pmr::memory_resource
+{
+public:
+    int allocations = 0;
+    int deallocations = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        ++allocations;
+        return pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        ++deallocations;
+        pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+struct Node
+{
+    Node* next;
+    int value;
+};
+
+bool aligned(void* p, size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+
+int main()
+{
+    using pmr::polymorphic_allocator;
+
+    // polymorphic_allocator through allocator_traits
+    typedef allocator_traits<polymorphic_allocator<int>> IntTraits;
+    typedef IntTraits::rebind_alloc<Node> NodeAlloc;
+    static_assert(is_same<NodeAlloc, polymorphic_allocator<Node>>::value, "rebind_alloc");
+    static_assert(!IntTraits::propagate_on_container_copy_assignment::value, "pocca");
+    static_assert(!IntTraits::propagate_on_container_swap::value, "pocs");
+
+    test(pmr::get_default_resource() == pmr::new_delete_resource());
+    counting_resource counter;
+    test(pmr::set_default_resource(&counter) == pmr::new_delete_resource());
+    {
+        polymorphic_allocator<int> ia;
+        test(ia.resource() == &counter);
+        NodeAlloc na(ia);
+        test(na == ia);
+        Node* n = allocator_traits<NodeAlloc>::allocate(na, 1);
+        allocator_traits<NodeAlloc>::deallocate(na, n, 1);
+        test(counter.allocations == 1 && counter.deallocations == 1);
+
+        polymorphic_allocator<int> other(pmr::new_delete_resource());
+        test(other != ia);
+        test(IntTraits::select_on_container_copy_construction(other).resource() == &counter);
+    }
+    pmr::set_default_resource(nullptr);
+    test(pmr::get_default_resource() == pmr::new_delete_resource());
+
+    // null_memory_resource
+    bool thrown = false;
+    try { pmr::null_memory_resource()->allocate(1); }
+    catch(std::bad_alloc&) { thrown = true; }
+    test(thrown);
+
+    // monotonic_buffer_resource serves from a stack buffer, then spills upstream
+    {
+        char buffer[256];
+        counting_resource upstream;
+        pmr::monotonic_buffer_resource mono(buffer, sizeof(buffer), &upstream);
+        polymorphic_allocator<Node> na(&mono);
+        Node* first = na.allocate(1);
+        test((char*)first >= buffer && (char*)first < buffer + sizeof(buffer));
+        test(upstream.allocations == 0);
+        for(int i = 0; i < 100; ++i)
+        {
+            Node* n = na.allocate(1);
+            test(aligned(n, alignof(Node)));
+            na.deallocate(n, 1);
+        }
+        test(upstream.allocations > 0);
+        test(aligned(mono.allocate(8, 64), 64));
+        mono.release();
+        test(upstream.allocations == upstream.deallocations);
+        test(na.allocate(1) == first);
+
+        // sizes that cannot be met throw instead of wrapping around
+        const size_t huge[] = { (size_t)(-1), (size_t)(-1) - 8, (size_t)(-1) - 64 };
+        for(size_t bytes : huge)
+        {
+            bool thrown = false;
+            try { mono.allocate(bytes, 8); }
+            catch(std::bad_alloc&) { thrown = true; }
+            test(thrown);
+        }
+        test(mono.allocate(16) != nullptr);
+    }
+
+    // unsynchronized_pool_resource recycles blocks and releases everything
+    {
+        counting_resource upstream;
+        pmr::pool_options opts;
+        opts.largest_required_pool_block = 1000;
+        pmr::unsynchronized_pool_resource pool(opts, &upstream);
+        test(pool.options().largest_required_pool_block == 1024);
+
+        void* a = pool.allocate(24);
+        pool.deallocate(a, 24);
+        test(pool.allocate(24) == a);
+
+        std::vector<void*> blocks;
+        for(size_t size = 1; size <= 2048; size *= 2)
+            for(int i = 0; i < 50; ++i)
+            {
+                blocks.push_back(pool.allocate(size, size < 16 ? size : 16));
+                test(aligned(blocks.back(), size < 16 ? size : 16));
+            }
+        void* wide = pool.allocate(100, 64); // over-aligned: straight to upstream
+        test(aligned(wide, 64));
+        void* big = pool.allocate(100000);   // oversized: straight to upstream
+        pool.deallocate(big, 100000);
+        pool.release();
+        test(upstream.allocations == upstream.deallocations);
+
+        // block sizes past the last pool are capped to it
+        opts.largest_required_pool_block = 1024 * 1024;
+        pmr::unsynchronized_pool_resource capped(opts, &upstream);
+        test(capped.options().largest_required_pool_block == 256 * 1024);
+        opts.largest_required_pool_block = 256 * 1024;
+        test(pmr::unsynchronized_pool_resource(opts, &upstream).options().largest_required_pool_block == 256 * 1024);
+    }
+
+    // synchronized_pool_resource
+    {
+        pmr::synchronized_pool_resource pool;
+        polymorphic_allocator<Node> na(&pool);
+        Node* n = na.allocate(3);
+        na.deallocate(n, 3);
+        test(na.allocate(3) == n);
+        test(pool == pool && pool != *pmr::new_delete_resource());
+    }
+    return 0;
+}
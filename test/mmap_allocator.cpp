@@ -0,0 +1,68 @@
+#include "test.h"
+
+#include <inner/memory/mmap_allocator.h>
+
+#include <cstdint>
+
+
+bool aligned(const void* p, size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+
+int main()
+{
+    typedef mmap_allocator<long> LongAlloc;
+    typedef allocator_traits<LongAlloc> LongTraits;
+    static_assert(is_same<LongTraits::rebind_alloc<char>, mmap_allocator<char>>::value, "rebind_alloc");
+    static_assert(LongTraits::is_always_equal::value, "stateless");
+
+    LongAlloc a;
+
+    // small requests come from the heap
+    test(!LongAlloc::is_mapped(100 * sizeof(long)));
+    long* small = LongTraits::allocate(a, 100);
+    small[99] = 99;
+    LongTraits::deallocate(a, small, 100);
+
+    // large requests are page aligned mappings, rounded up to whole pages
+    const size_t count = 3 * 1024 * 1024 / sizeof(long) + 1;
+    test(LongAlloc::is_mapped(count * sizeof(long)));
+    allocation_result<long*> r = LongTraits::allocate_at_least(a, count);
+    test(aligned(r.ptr, detail::page_mapper::page_size()));
+    test(r.count >= count);
+    test(r.count * sizeof(long) % detail::page_mapper::page_size() == 0);
+    if(detail::page_mapper::transparent_huge_pages())
+    {
+        test(aligned(r.ptr, detail::page_mapper::huge_page_size));
+        test(r.count * sizeof(long) == 4 * 1024 * 1024);
+    }
+    for(size_t i = 0; i < r.count; i += 512)
+        r.ptr[i] = (long)i;
+    test(r.ptr[512 * 100] == 512 * 100);
+
+    // discarded pages read back as zero
+    a.discard(r.ptr, r.count);
+    test(r.ptr[512 * 100] == 0);
+    r.ptr[0] = 1;
+    LongTraits::deallocate(a, r.ptr, r.count);
+
+    // a mapping just above the threshold, freed with the requested count
+    size_t n = LongAlloc::mmap_threshold / sizeof(long) + 3;
+    long* p = a.allocate(n);
+    p[n - 1] = 7;
+    a.deallocate(p, n);
+
+    // heap slack never reaches the threshold, or the block would be freed with munmap
+    typedef mmap_allocator<char> CharAlloc;
+    CharAlloc c;
+    for(size_t bytes = CharAlloc::mmap_threshold - 8; bytes > CharAlloc::mmap_threshold - 4096; bytes -= 8)
+    {
+        allocation_result<char*> h = allocator_traits<CharAlloc>::allocate_at_least(c, bytes);
+        test(h.count >= bytes && !CharAlloc::is_mapped(h.count));
+        h.ptr[h.count - 1] = 1;
+        c.deallocate(h.ptr, h.count);
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "test.h"
+
+#include <inner/memory/monotonic_arena.h>
+
+#include <cstdint>
+
+
+struct Node
+{
+    Node* next;
+    int value;
+    Node(int v) : next(nullptr), value(v) {}
+};
+
+struct alignas(32) Wide
+{
+    char bytes[32];
+};
+
+
+int main()
+{
+    monotonic_arena arena(64);
+
+    typedef arena_allocator<int> IntAlloc;
+    typedef allocator_traits<IntAlloc> IntTraits;
+    typedef IntTraits::rebind_alloc<Node> NodeAlloc;
+    typedef allocator_traits<NodeAlloc> NodeTraits;
+
+    static_assert(is_same<NodeAlloc, arena_allocator<Node>>::value, "rebind_alloc");
+    static_assert(is_same<IntTraits::pointer, int*>::value, "pointer");
+    static_assert(IntTraits::propagate_on_container_copy_assignment::value, "pocca");
+    static_assert(!IntTraits::is_always_equal::value, "arena allocators are stateful");
+
+    IntAlloc ia(arena);
+    NodeAlloc na(ia);
+    test(ia == na);
+    test(NodeTraits::max_size(na) == (size_t)(-1) / sizeof(Node));
+
+    // build a list, the arena grows past its first block
+    Node* head = nullptr;
+    for(int i = 0; i < 100; ++i)
+    {
+        Node* n = NodeTraits::allocate(na, 1);
+        test(reinterpret_cast<std::uintptr_t>(n) % alignof(Node) == 0);
+        NodeTraits::construct(na, n, i);
+        n->next = head;
+        head = n;
+    }
+    int sum = 0;
+    for(Node* n = head; n != nullptr; n = n->next)
+        sum += n->value;
+    test(sum == 99 * 100 / 2);
+    test(arena.bytes_allocated() == 100 * sizeof(Node));
+
+    // deallocate is a no-op
+    for(Node* n = head; n != nullptr; )
+    {
+        Node* next = n->next;
+        NodeTraits::destroy(na, n);
+        NodeTraits::deallocate(na, n, 1);
+        n = next;
+    }
+    test(arena.bytes_allocated() == 100 * sizeof(Node));
+
+    // over-aligned types
+    arena_allocator<Wide> wa(arena);
+    for(int i = 0; i < 10; ++i)
+    {
+        Wide* w = wa.allocate(3);
+        test(reinterpret_cast<std::uintptr_t>(w) % 32 == 0);
+    }
+
+    // a request bigger than any block
+    char* big = arena_allocator<char>(arena).allocate(100000);
+    big[0] = big[99999] = 1;
+
+    // sizes that cannot be met throw instead of wrapping around
+    const size_t huge[] = { (size_t)(-1), (size_t)(-1) - 64, (size_t)(-1) / 2 + 1 };
+    for(size_t bytes : huge)
+    {
+        bool thrown = false;
+        try { arena.allocate(bytes); }
+        catch(std::bad_alloc&) { thrown = true; }
+        test(thrown);
+    }
+    test(arena.allocate(16) != nullptr);
+
+    arena.release();
+    test(arena.bytes_allocated() == 0);
+    test(ia.allocate(1) != nullptr);
+
+    monotonic_arena other;
+    test(arena_allocator<int>(other) != ia);
+    return 0;
+}
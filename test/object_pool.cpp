@@ -0,0 +1,111 @@
+#include "test.h"
+
+#include <inner/memory/object_pool.h>
+#include <inner/memory/stats_allocator.h>
+
+#include <string>
+
+
+static int constructed = 0;
+static int destroyed = 0;
+
+struct Request
+{
+    int id;
+    std::string body;
+    explicit Request(int i = 0) : id(i) { ++constructed; }
+    ~Request() { ++destroyed; }
+};
+
+struct clear_request
+{
+    void operator()(Request& r) const { r.id = -1; r.body.clear(); }
+};
+
+struct pool_tag {};
+
+
+int main()
+{
+    static_assert(sizeof(object_pool<Request>::pointer) == 2 * sizeof(void*), "pointer and pool only");
+
+    // released storage is reused
+    {
+        object_pool<Request> pool(2);
+        object_pool<Request>::pointer a = pool.acquire(1);
+        Request* first = a.get();
+        test(a->id == 1 && pool.outstanding() == 1);
+        a.reset();
+        test(destroyed == 1 && pool.outstanding() == 0);
+
+        object_pool<Request>::pointer b = pool.acquire(2);
+        test(b.get() == first && b->id == 2);
+
+        // the pool grows past its first block
+        object_pool<Request>::pointer c = pool.acquire(3);
+        object_pool<Request>::pointer d = pool.acquire(4);
+        test(c->id == 3 && d->id == 4 && pool.outstanding() == 3);
+    }
+    test(constructed == 4 && destroyed == 4);
+
+    // with a Reset policy the object survives release and keeps its buffers
+    constructed = destroyed = 0;
+    {
+        object_pool<Request, clear_request> pool;
+        object_pool<Request, clear_request>::pointer a = pool.acquire(7);
+        a->body.assign(200, 'x');
+        const char* buffer = a->body.data();
+        Request* first = a.get();
+        a.reset();
+        test(destroyed == 0);
+
+        object_pool<Request, clear_request>::pointer b = pool.acquire(8);
+        test(b.get() == first && b->id == -1 && b->body.empty() && b->body.data() == buffer);
+        test(constructed == 1);
+
+        object_pool<Request, clear_request>::pointer c = pool.acquire(9);
+        test(c->id == 9 && constructed == 2);
+    }
+    test(destroyed == 2);
+
+    // blocks come from the allocator and go back to it with the pool
+    {
+        typedef stats_allocator<allocator<Request>, pool_tag> Alloc;
+        {
+            object_pool<Request, void, Alloc> pool(4);
+            for(int round = 0; round < 3; ++round)
+            {
+                object_pool<Request, void, Alloc>::pointer held[6];
+                for(int i = 0; i < 6; ++i)
+                    held[i] = pool.acquire(i);
+            }
+            // 4 + 8 slots, each with its block record
+            test(allocation_stats<pool_tag>::snapshot().allocations == 4);
+        }
+        allocation_stats_snapshot s = allocation_stats<pool_tag>::snapshot();
+        test(s.deallocations == 4 && s.live_bytes == 0);
+    }
+
+    // a failed construction gives the slot back
+    {
+        struct Throws
+        {
+            explicit Throws(bool fail) { if(fail) throw 1; }
+        };
+        object_pool<Throws> pool(1);
+        bool thrown = false;
+        try
+        {
+            pool.acquire(true);
+        }
+        catch(int)
+        {
+            thrown = true;
+        }
+        test(thrown && pool.outstanding() == 0);
+        object_pool<Throws>::pointer ok = pool.acquire(false);
+        test(ok != nullptr);
+    }
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "test.h"
+
+#include <inner/memory/offset_ptr.h>
+#include <inner/memory/allocators.h>
+
+#include <cstring>
+
+
+struct Node
+{
+    int value;
+    offset_ptr<Node> next;
+};
+
+struct Base { int b; };
+struct Derived : Base { int d; };
+
+
+int main()
+{
+    // pointer_traits / allocator machinery sees offset_ptr as a fancy pointer
+    typedef pointer_traits<offset_ptr<int>> Traits;
+    static_assert(is_same<Traits::element_type, int>::value, "element_type");
+    static_assert(is_same<Traits::difference_type, ptrdiff_t>::value, "difference_type");
+    static_assert(is_same<Traits::rebind<const void>, offset_ptr<const void>>::value, "rebind");
+
+    int values[4] = { 1, 2, 3, 4 };
+    offset_ptr<int> p = Traits::pointer_to(values[1]);
+    test(*p == 2 && p.get() == &values[1]);
+    test(to_address(p) == &values[1]);
+    test(p[1] == 3 && *(p + 2) == 4 && *(p - 1) == 1);
+    offset_ptr<int> q = p;
+    ++q;
+    test(q - p == 1 && p < q && *q == 3);
+    q -= 2;
+    test(*q == 1);
+
+    offset_ptr<int> null;
+    test(!null && null == nullptr && null.get() == nullptr);
+    offset_ptr<const void> v = p;
+    test(v.get() == &values[1]);
+    test(static_pointer_cast<const int>(v) == offset_ptr<const int>(&values[1]));
+
+    Derived derived;
+    offset_ptr<Base> base = offset_ptr<Derived>(&derived);
+    test(base.get() == &derived);
+
+    // a linked structure survives being moved to another address as a block of bytes
+    struct Pair { Node a; Node b; };
+    alignas(Pair) char first[sizeof(Pair)];
+    alignas(Pair) char second[sizeof(Pair)];
+    Pair* one = ::new (first) Pair();
+    one->a.value = 10;
+    one->b.value = 20;
+    one->a.next = &one->b;
+    std::memcpy(second, first, sizeof(Pair));
+    Pair* two = reinterpret_cast<Pair*>(second);
+    test(two->a.next.get() == &two->b);
+    test(two->a.next->value == 20);
+    test(!two->b.next);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "test.h"
+
+#include <inner/memory/allocators.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+
+struct Node
+{
+    Node* next;
+    long value;
+};
+
+struct Big
+{
+    char bytes[4096];
+};
+
+
+int main()
+{
+    typedef pool_allocator<int> IntAlloc;
+    typedef allocator_traits<IntAlloc>::rebind_alloc<Node> NodeAlloc;
+    typedef allocator_traits<NodeAlloc> NodeTraits;
+
+    static_assert(is_same<NodeAlloc, pool_allocator<Node>>::value, "rebind_alloc");
+    static_assert(allocator_traits<IntAlloc>::is_always_equal::value, "pool allocators are stateless");
+
+    NodeAlloc na = IntAlloc();
+    test(na == IntAlloc());
+
+    // a freed block is reused by the next allocation of the same size class
+    Node* a = NodeTraits::allocate(na, 1);
+    test(reinterpret_cast<std::uintptr_t>(a) % alignof(max_align_t) == 0);
+    NodeTraits::deallocate(na, a, 1);
+    Node* b = NodeTraits::allocate(na, 1);
+    test(a == b);
+    NodeTraits::deallocate(na, b, 1);
+
+    // many nodes span several slabs and do not overlap
+    std::vector<Node*> nodes;
+    for(long i = 0; i < 20000; ++i)
+    {
+        Node* n = NodeTraits::allocate(na, 1);
+        NodeTraits::construct(na, n);
+        n->value = i;
+        nodes.push_back(n);
+    }
+    for(long i = 0; i < 20000; ++i)
+        test(nodes[i]->value == i);
+    for(Node* n : nodes)
+    {
+        NodeTraits::destroy(na, n);
+        NodeTraits::deallocate(na, n, 1);
+    }
+
+    // requests too large for any size class go to operator new
+    pool_allocator<Big> ba;
+    Big* big = ba.allocate(2);
+    big[1].bytes[4095] = 1;
+    ba.deallocate(big, 2);
+
+    // a block freed by another thread returns to the cache of the thread that allocated it
+    Node* c = na.allocate(1);
+    std::thread([&] { NodeAlloc().deallocate(c, 1); }).join();
+    bool found = false;
+    std::vector<Node*> again;
+    for(int i = 0; i < 20000 && !found; ++i)
+    {
+        again.push_back(na.allocate(1));
+        found = again.back() == c;
+    }
+    test(found);
+    for(Node* n : again)
+        na.deallocate(n, 1);
+
+    // blocks allocated on worker threads stay valid after those threads exit
+    std::vector<Node*> from_workers(4);
+    std::vector<std::thread> workers;
+    for(int i = 0; i < 4; ++i)
+        workers.emplace_back([&, i] { from_workers[i] = NodeAlloc().allocate(1); from_workers[i]->value = i; });
+    for(std::thread& t : workers)
+        t.join();
+    for(int i = 0; i < 4; ++i)
+    {
+        test(from_workers[i]->value == i);
+        na.deallocate(from_workers[i], 1);
+    }
+    return 0;
+}
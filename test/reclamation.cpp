@@ -0,0 +1,179 @@
+#include "test.h"
+
+#include <inner/memory/reclamation.h>
+#include <inner/memory/stats_allocator.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+static const long live_mark = 0x600d;
+static const long dead_mark = 0xdead;
+
+struct Node
+{
+    std::atomic<Node*> next;
+    long value;
+    long mark;
+    Node(long v) : next(nullptr), value(v), mark(live_mark) {}
+    ~Node() { mark = dead_mark; }
+};
+
+struct hazard_tag {};
+struct epoch_tag {};
+
+// A Treiber stack whose nodes come from the domain's allocator.
+template<typename Alloc>
+class stack
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<Node> node_allocator;
+    typedef allocator_traits<node_allocator> node_traits;
+
+    node_allocator alloc_;
+
+public:
+    std::atomic<Node*> head;
+    std::atomic<long> freed_while_used;
+
+    explicit stack(const Alloc& alloc) : alloc_(alloc), head(nullptr), freed_while_used(0) {}
+
+    void push(long v)
+    {
+        Node* n = node_traits::allocate(alloc_, 1);
+        node_traits::construct(alloc_, n, v);
+        Node* top = head.load(std::memory_order_relaxed);
+        do
+            n->next.store(top, std::memory_order_relaxed);
+        while(!head.compare_exchange_weak(top, n, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Reads through a node another thread may be popping at the same time.
+    Node* unlink_top(Node* top)
+    {
+        if(top->mark != live_mark)
+            ++freed_while_used;
+        Node* next = top->next.load(std::memory_order_relaxed);
+        return head.compare_exchange_strong(top, next, std::memory_order_acquire, std::memory_order_relaxed)
+            ? top : nullptr;
+    }
+};
+
+
+int main()
+{
+    const int threads = 4;
+    const int rounds = 20000;
+
+    // hazard pointers
+    {
+        typedef stats_allocator<allocator<char>, hazard_tag> Alloc;
+        {
+            hazard_domain<Alloc> domain;
+            stack<Alloc> s(domain.get_allocator());
+            std::atomic<long> popped(0);
+
+            std::vector<std::thread> workers;
+            for(int t = 0; t < threads; ++t)
+                workers.emplace_back([&]
+                {
+                    hazard_domain<Alloc>::participant self(domain);
+                    hazard_pointer hp(domain);
+                    for(int i = 0; i < rounds; ++i)
+                    {
+                        s.push(i);
+                        for(;;)
+                        {
+                            Node* top = hp.protect(s.head);
+                            if(top == nullptr)
+                                break;
+                            if(s.unlink_top(top) == top)
+                            {
+                                hp.reset_protection();
+                                self.retire(top);
+                                ++popped;
+                                break;
+                            }
+                        }
+                    }
+                    test(self.pending() <= 2 * threads + hazard_domain<Alloc>::min_batch);
+                });
+            for(std::thread& w : workers)
+                w.join();
+
+            test(s.freed_while_used == 0);
+            test(popped == (long)threads * rounds && s.head.load() == nullptr);
+        }
+        // the domain frees whatever the participants left behind
+        allocation_stats_snapshot stats = allocation_stats<hazard_tag>::snapshot();
+        test(stats.allocations == stats.deallocations && stats.live_bytes == 0);
+    }
+
+    // epochs
+    {
+        typedef stats_allocator<allocator<char>, epoch_tag> Alloc;
+        {
+            epoch_domain<Alloc> domain;
+            stack<Alloc> s(domain.get_allocator());
+            std::atomic<long> popped(0);
+
+            std::vector<std::thread> workers;
+            for(int t = 0; t < threads; ++t)
+                workers.emplace_back([&]
+                {
+                    epoch_domain<Alloc>::participant self(domain);
+                    for(int i = 0; i < rounds; ++i)
+                    {
+                        s.push(i);
+                        epoch_domain<Alloc>::guard pinned = self.enter();
+                        for(;;)
+                        {
+                            Node* top = s.head.load(std::memory_order_acquire);
+                            if(top == nullptr)
+                                break;
+                            if(s.unlink_top(top) == top)
+                            {
+                                self.retire(top);
+                                ++popped;
+                                break;
+                            }
+                        }
+                    }
+                    test(!self.pinned());
+                });
+            for(std::thread& w : workers)
+                w.join();
+
+            test(s.freed_while_used == 0);
+            test(popped == (long)threads * rounds && domain.epoch() > 0);
+        }
+        allocation_stats_snapshot stats = allocation_stats<epoch_tag>::snapshot();
+        test(stats.allocations == stats.deallocations && stats.live_bytes == 0);
+    }
+
+    // a pinned participant holds reclamation back, nested pins count once
+    {
+        epoch_domain<> domain;
+        epoch_domain<>::participant reader(domain);
+        epoch_domain<>::participant writer(domain);
+        allocator<Node> alloc;
+
+        reader.pin();
+        reader.pin();
+        for(int i = 0; i < 3 * (int)epoch_domain<>::min_batch; ++i)
+        {
+            Node* n = alloc.allocate(1);
+            ::new (n) Node(i);
+            writer.retire(n);
+        }
+        test(domain.epoch() <= 1 && writer.pending() == 3 * epoch_domain<>::min_batch);
+
+        reader.unpin();
+        reader.unpin();
+        for(int i = 0; i < 3; ++i)
+            writer.reclaim();
+        test(writer.pending() == 0);
+    }
+
+    return 0;
+}
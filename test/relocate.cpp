@@ -0,0 +1,175 @@
+#include "test.h"
+
+#include <inner/containers/small_vector.h>
+#include <inner/containers/vector.h>
+#include <inner/memory/intrusive_ptr.h>
+#include <inner/memory/local_shared_ptr.h>
+#include <inner/memory/shared_ptr.h>
+#include <inner/memory/stats_allocator.h>
+#include <inner/memory/uninitialized.h>
+#include <inner/memory/unique_ptr.h>
+
+#include <string>
+
+
+static int live = 0;
+static int moves = 0;
+
+struct Counted
+{
+    int value;
+    explicit Counted(int v) : value(v) { ++live; }
+    ~Counted() { --live; }
+};
+
+// Moves by hand, so relocating it must go through the move constructor.
+struct Mover
+{
+    int value;
+    Mover* self;
+    explicit Mover(int v) : value(v), self(this) { ++live; }
+    Mover(Mover&& other) noexcept : value(other.value), self(this) { ++moves; ++live; }
+    Mover& operator=(Mover&& other) noexcept { value = other.value; ++moves; return *this; }
+    ~Mover() { --live; }
+};
+
+// Holds resources like a string, but opts in.
+struct Handle
+{
+    int* p;
+    explicit Handle(int v) : p(new int(v)) {}
+    Handle(Handle&& other) noexcept : p(other.p) { other.p = nullptr; ++moves; }
+    Handle& operator=(Handle&& other) noexcept { std::swap(p, other.p); ++moves; return *this; }
+    ~Handle() { delete p; }
+};
+
+namespace mystd {
+template<>
+struct is_trivially_relocatable<Handle> : true_type {};
+}
+
+struct Node : intrusive_ref_counter<Node> {};
+
+struct relocate_tag {};
+
+template<typename Vector>
+bool values(const Vector& v, std::initializer_list<int> expected)
+{
+    if(v.size() != expected.size())
+        return false;
+    const int* e = expected.begin();
+    for(size_t i = 0; i < v.size(); ++i)
+        if(v[i]->value != e[i])
+            return false;
+    return true;
+}
+
+
+int main()
+{
+    static_assert(is_trivially_relocatable_v<int>, "");
+    static_assert(is_trivially_relocatable_v<const double>, "");
+    static_assert(is_trivially_relocatable_v<unique_ptr<int>>, "");
+    static_assert(is_trivially_relocatable_v<unique_ptr<int[]>>, "");
+    static_assert(is_trivially_relocatable_v<shared_ptr<int>>, "");
+    static_assert(is_trivially_relocatable_v<weak_ptr<int>>, "");
+    static_assert(is_trivially_relocatable_v<local_shared_ptr<int>>, "");
+    static_assert(is_trivially_relocatable_v<intrusive_ptr<Node>>, "");
+    static_assert(is_trivially_relocatable_v<vector<std::string>>, "");
+    static_assert(is_trivially_relocatable_v<Handle>, "");
+    static_assert(!is_trivially_relocatable_v<Mover>, "");
+    static_assert(!is_trivially_relocatable_v<small_vector<int, 4>>, "");
+
+    // relocate_at ends the source: bitwise for opted-in types, move + destroy otherwise
+    {
+        typename aligned_storage<sizeof(Handle), alignof(Handle)>::type raw;
+        Handle* src = new Handle(5);
+        Handle* dest = relocate_at(src, reinterpret_cast<Handle*>(&raw));
+        ::operator delete(src); // nothing left to destroy
+        test(*dest->p == 5 && moves == 0);
+        dest->~Handle();
+
+        typename aligned_storage<sizeof(Mover), alignof(Mover)>::type raw1, raw2;
+        Mover* m = new (static_cast<void*>(&raw1)) Mover(6);
+        Mover* n = relocate_at(m, reinterpret_cast<Mover*>(&raw2));
+        test(n->value == 6 && n->self == n && moves == 1 && live == 1);
+        n->~Mover();
+        test(live == 0);
+    }
+
+    // uninitialized_relocate: overlapping ranges for trivially relocatable elements
+    {
+        typedef allocator<unique_ptr<Counted>> Alloc;
+        Alloc a;
+        unique_ptr<Counted>* buf = a.allocate(6);
+        for(int i = 0; i < 4; ++i)
+            ::new (static_cast<void*>(buf + i)) unique_ptr<Counted>(new Counted(i));
+        unique_ptr<Counted>* end = uninitialized_relocate(buf, buf + 4, buf + 2);
+        test(end == buf + 6 && buf[2]->value == 0 && buf[5]->value == 3 && live == 4);
+        uninitialized_relocate(buf + 2, buf + 6, buf);
+        test(buf[0]->value == 0 && buf[3]->value == 3);
+        destroy(buf, buf + 4);
+        a.deallocate(buf, 6);
+        test(live == 0);
+
+        moves = 0;
+        allocator<Mover> ma;
+        Mover* m = ma.allocate(6);
+        for(int i = 0; i < 3; ++i)
+            ::new (static_cast<void*>(m + i)) Mover(i);
+        Mover* m_end = uninitialized_relocate(m, m + 3, m + 3);
+        test(m_end == m + 6 && m[5].value == 2 && m[5].self == m + 5 && moves == 3 && live == 3);
+        destroy(m + 3, m + 6);
+        ma.deallocate(m, 6);
+        test(live == 0);
+    }
+
+    // vectors of trivially relocatable elements grow, insert and erase by memmove
+    {
+        typedef stats_allocator<allocator<unique_ptr<Counted>>, relocate_tag> Alloc;
+        {
+            vector<unique_ptr<Counted>, Alloc> v;
+            for(int i = 0; i < 5; ++i)
+                v.push_back(unique_ptr<Counted>(new Counted(i)));
+            v.insert(v.begin() + 1, unique_ptr<Counted>(new Counted(9)));
+            v.emplace(v.begin(), new Counted(8));
+            test(values(v, {8, 0, 9, 1, 2, 3, 4}) && live == 7);
+
+            v.erase(v.begin() + 2);
+            v.erase(v.begin(), v.begin() + 2);
+            test(values(v, {1, 2, 3, 4}) && live == 4);
+
+            v.shrink_to_fit();
+            v.emplace(v.begin() + 2, new Counted(7));
+            test(values(v, {1, 2, 7, 3, 4}) && live == 5);
+        }
+        allocation_stats_snapshot s = allocation_stats<relocate_tag>::snapshot();
+        test(s.allocations == s.deallocations && s.live_bytes == 0 && live == 0);
+
+        // an opted-in element never moves through its constructor
+        moves = 0;
+        vector<Handle> h;
+        for(int i = 0; i < 100; ++i)
+            h.emplace_back(i);
+        h.emplace(h.begin() + 50, -1);
+        h.erase(h.begin() + 10, h.begin() + 20);
+        test(moves == 0 && h.size() == 91 && *h[40].p == -1 && *h[90].p == 99);
+
+        // an element built from another of the same vector sees it before it moves
+        vector<shared_ptr<int>> s2;
+        s2.reserve(4);
+        s2.push_back(make_shared<int>(1));
+        s2.push_back(make_shared<int>(2));
+        s2.insert(s2.begin(), s2[1]);
+        test(*s2[0] == 2 && *s2[1] == 1 && *s2[2] == 2 && s2[0].use_count() == 2);
+
+        // small_vector relocates its inline elements on move
+        small_vector<unique_ptr<Counted>, 2> a;
+        a.emplace_back(new Counted(1));
+        small_vector<unique_ptr<Counted>, 2> b(std::move(a));
+        test(a.empty() && b.size() == 1 && b[0]->value == 1 && live == 1);
+    }
+    test(live == 0);
+
+    return 0;
+}
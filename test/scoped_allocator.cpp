@@ -0,0 +1,137 @@
+#include "test.h"
+
+#include <inner/memory/scoped_allocator.h>
+#include <inner/memory/monotonic_arena.h>
+#include <inner/memory/memory_resource.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// takes the allocator after allocator_arg
+struct Leading
+{
+    typedef allocator<int> allocator_type;
+    int value;
+    bool has_alloc;
+    Leading(int v) : value(v), has_alloc(false) {}
+    Leading(allocator_arg_t, const allocator_type&, int v) : value(v), has_alloc(true) {}
+    Leading(allocator_arg_t, const allocator_type&, const Leading& o) : value(o.value), has_alloc(true) {}
+};
+
+// takes the allocator last
+struct Trailing
+{
+    typedef allocator<int> allocator_type;
+    int value;
+    bool has_alloc;
+    Trailing(int v) : value(v), has_alloc(false) {}
+    Trailing(int v, const allocator_type&) : value(v), has_alloc(true) {}
+};
+
+struct Plain
+{
+    int value;
+    Plain(int v) : value(v) {}
+};
+
+typedef std::vector<int, arena_allocator<int>> IntVec;
+typedef scoped_allocator_adaptor<arena_allocator<IntVec>> OuterAlloc;
+typedef std::basic_string<char, std::char_traits<char>, arena_allocator<char>> ArenaString;
+
+
+int main()
+{
+    static_assert(uses_allocator<Leading, allocator<char>>::value, "allocator converts to allocator_type");
+    static_assert(!uses_allocator<Plain, allocator<char>>::value, "no allocator_type");
+    static_assert(!uses_allocator<IntVec, allocator<int>>::value, "allocator does not convert");
+    static_assert(uses_allocator<IntVec, OuterAlloc>::value, "adaptor converts to its outer allocator");
+
+    // uses-allocator construction picks the form the type supports
+    {
+        allocator<char> a;
+        test(make_obj_using_allocator<Leading>(a, 1).has_alloc);
+        test(make_obj_using_allocator<Trailing>(a, 2).has_alloc);
+        test(make_obj_using_allocator<Plain>(a, 3).value == 3);
+
+        typedef std::pair<Leading, Trailing> Pair;
+        Pair p = make_obj_using_allocator<Pair>(a, 4, 5);
+        test(p.first.has_alloc && p.second.has_alloc && p.second.value == 5);
+
+        typedef std::pair<Leading, int> LeadingInt;
+        LeadingInt li(Leading(6), 7);
+        alignas(LeadingInt) char buf[sizeof(LeadingInt)];
+        LeadingInt* q = uninitialized_construct_using_allocator(reinterpret_cast<LeadingInt*>(buf), a, li);
+        test(q->first.has_alloc && q->first.value == 6 && q->second == 7);
+        q->~LeadingInt();
+
+        q = uninitialized_construct_using_allocator(reinterpret_cast<LeadingInt*>(buf), a,
+            std::piecewise_construct, std::forward_as_tuple(8), std::forward_as_tuple(9));
+        test(q->first.has_alloc && q->first.value == 8 && q->second == 9);
+        q->~LeadingInt();
+    }
+
+    // propagation traits combine those of the adapted allocators
+    {
+        typedef scoped_allocator_adaptor<allocator<int>, arena_allocator<int>> Mixed;
+        static_assert(allocator_traits<Mixed>::propagate_on_container_copy_assignment::value, "any pocca");
+        static_assert(!allocator_traits<Mixed>::is_always_equal::value, "all is_always_equal");
+        static_assert(is_same<Mixed::inner_allocator_type, scoped_allocator_adaptor<arena_allocator<int>>>::value,
+            "inner_allocator_type");
+        static_assert(is_same<OuterAlloc::inner_allocator_type, OuterAlloc>::value, "no inner allocators");
+        static_assert(is_same<allocator_traits<OuterAlloc>::rebind_alloc<int>,
+            scoped_allocator_adaptor<arena_allocator<int>>>::value, "rebind_alloc");
+
+        monotonic_arena arena;
+        Mixed m{allocator<int>(), arena_allocator<int>(arena)};
+        test(&m.inner_allocator().outer_allocator().arena() == &arena);
+        Mixed copy = allocator_traits<Mixed>::select_on_container_copy_construction(m);
+        test(copy == m);
+    }
+
+    // the inner containers of a scoped container allocate from the outer container's arena
+    {
+        monotonic_arena arena;
+        std::vector<IntVec, OuterAlloc> outer{OuterAlloc(arena_allocator<IntVec>(arena))};
+        outer.reserve(8);
+        for(int i = 0; i < 8; ++i)
+        {
+            outer.emplace_back();
+            for(int j = 0; j <= i; ++j)
+                outer.back().push_back(j);
+        }
+        size_t used = arena.bytes_allocated();
+        test(used > 8 * sizeof(IntVec));
+        for(int i = 0; i < 8; ++i)
+        {
+            test(&outer[i].get_allocator().arena() == &arena);
+            test((int)outer[i].size() == i + 1 && outer[i][i] == i);
+        }
+
+        // copies of elements are built with the allocator too
+        outer.push_back(outer[7]);
+        test(&outer.back().get_allocator().arena() == &arena && outer.back().size() == 8);
+
+        std::vector<ArenaString, scoped_allocator_adaptor<arena_allocator<ArenaString>>> words{
+            scoped_allocator_adaptor<arena_allocator<ArenaString>>(arena_allocator<ArenaString>(arena))};
+        words.reserve(2);
+        words.emplace_back("a string long enough to leave the small buffer");
+        words.emplace_back(40, 'x');
+        test(&words[0].get_allocator().arena() == &arena && words[1].size() == 40);
+    }
+
+    // polymorphic_allocator hands its resource down in the same way
+    {
+        pmr::monotonic_buffer_resource resource;
+        typedef std::vector<int, pmr::polymorphic_allocator<int>> PmrVec;
+        std::vector<PmrVec, pmr::polymorphic_allocator<PmrVec>> outer{pmr::polymorphic_allocator<PmrVec>(&resource)};
+        outer.reserve(2);
+        outer.emplace_back();
+        outer.emplace_back(3, 1);
+        test(outer[0].get_allocator().resource() == &resource);
+        test(outer[1].get_allocator().resource() == &resource && outer[1][2] == 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include "test.h"
+
+#include <inner/memory/shared_ptr.h>
+#include <inner/memory/monotonic_arena.h>
+#include <inner/memory/stats_allocator.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+static int alive = 0;
+
+struct Base
+{
+    int id;
+    Base(int i) : id(i) { ++alive; }
+    virtual ~Base() { --alive; }
+};
+
+struct Derived : Base
+{
+    long extra;
+    Derived(int i, long e) : Base(i), extra(e) {}
+};
+
+struct Self : enable_shared_from_this<Self>
+{
+    int value = 7;
+};
+
+struct counting_deleter
+{
+    int* calls;
+    void operator()(int* p) const { ++*calls; delete p; }
+};
+
+struct shared_tag {};
+
+// Scribbles over itself when destroyed, so a lock() that outlives it shows.
+struct Probe
+{
+    std::atomic<int>* destroyed;
+    int magic = 42;
+    explicit Probe(std::atomic<int>* d) : destroyed(d) {}
+    ~Probe() { magic = 0; ++*destroyed; }
+};
+
+
+int main()
+{
+    // ownership and counts
+    {
+        shared_ptr<Base> a(new Derived(1, 2));
+        test(alive == 1 && a.use_count() == 1 && a->id == 1);
+        shared_ptr<Base> b = a;
+        test(a.use_count() == 2 && a == b);
+        shared_ptr<Base> c = std::move(b);
+        test(!b && b.use_count() == 0 && c.use_count() == 2);
+        a.reset();
+        test(alive == 1 && c.use_count() == 1);
+        c = nullptr;
+        test(alive == 0 && c == nullptr);
+    }
+
+    // make_shared puts the object and the counts in one allocation
+    {
+        typedef stats_allocator<allocator<Derived>, shared_tag> Alloc;
+        shared_ptr<Derived> p = allocate_shared<Derived>(Alloc(), 3, 4L);
+        test(p->id == 3 && p->extra == 4 && alive == 1);
+        test(allocation_stats<shared_tag>::snapshot().allocations == 1);
+
+        // the block outlives the object while a weak_ptr remains
+        weak_ptr<Derived> w = p;
+        p.reset();
+        test(alive == 0 && w.expired() && !w.lock());
+        test(allocation_stats<shared_tag>::snapshot().deallocations == 0);
+        w.reset();
+        test(allocation_stats<shared_tag>::snapshot().deallocations == 1);
+
+        shared_ptr<Base> q = make_shared<Derived>(5, 6L);
+        test(q->id == 5 && q.use_count() == 1);
+    }
+    test(alive == 0);
+
+    // allocate_shared takes memory from an arena through rebind
+    {
+        monotonic_arena arena(256);
+        shared_ptr<Base> p = allocate_shared<Derived>(arena_allocator<char>(arena), 8, 9L);
+        test(arena.bytes_allocated() >= sizeof(Derived) && p->id == 8);
+    }
+
+    // and from the pool
+    {
+        shared_ptr<long> p = allocate_shared<long>(pool_allocator<long>(), 42L);
+        shared_ptr<long> q = p;
+        test(*q == 42 && p.use_count() == 2);
+    }
+
+    // weak_ptr
+    {
+        shared_ptr<int> p = make_shared<int>(10);
+        weak_ptr<int> w(p);
+        test(!w.expired() && w.use_count() == 1);
+        shared_ptr<int> locked = w.lock();
+        test(*locked == 10 && p.use_count() == 2);
+        locked.reset();
+        p.reset();
+        test(w.expired());
+        bool thrown = false;
+        try
+        {
+            shared_ptr<int> again(w);
+        }
+        catch(const bad_weak_ptr&)
+        {
+            thrown = true;
+        }
+        test(thrown);
+    }
+
+    // deleters, unique_ptr, aliasing and casts
+    {
+        int calls = 0;
+        {
+            shared_ptr<int> p(new int(1), counting_deleter{&calls});
+            test(get_deleter<counting_deleter>(p) != nullptr && get_deleter<default_delete<int>>(p) == nullptr);
+        }
+        test(calls == 1);
+
+        shared_ptr<Base> from_unique(unique_ptr<Derived>(new Derived(11, 12)));
+        test(from_unique->id == 11 && from_unique.use_count() == 1);
+
+        shared_ptr<Derived> down = dynamic_pointer_cast<Derived>(from_unique);
+        test(down && down->extra == 12 && from_unique.use_count() == 2);
+        test(!dynamic_pointer_cast<Derived>(make_shared<Base>(0)));
+
+        shared_ptr<long> member(down, &down->extra);
+        down.reset();
+        from_unique.reset();
+        test(alive == 1 && *member == 12);
+        member.reset();
+        test(alive == 0);
+    }
+
+    // enable_shared_from_this
+    {
+        shared_ptr<Self> p = make_shared<Self>();
+        shared_ptr<Self> q = p->shared_from_this();
+        test(q == p && p.use_count() == 2 && !p->weak_from_this().expired());
+
+        Self unowned;
+        test(unowned.weak_from_this().expired());
+    }
+
+    // owner ordering ignores the stored pointer
+    {
+        shared_ptr<Derived> p = make_shared<Derived>(1, 1L);
+        shared_ptr<long> alias(p, &p->extra);
+        test(!p.owner_before(alias) && !alias.owner_before(p));
+    }
+
+    // copies and drops from several threads leave the count exact
+    {
+        shared_ptr<int> p = make_shared<int>(0);
+        weak_ptr<int> w = p;
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t)
+            threads.emplace_back([&p, &w]
+            {
+                for(int i = 0; i < 10000; ++i)
+                {
+                    shared_ptr<int> copy = p;
+                    shared_ptr<int> locked = w.lock();
+                }
+            });
+        for(std::thread& t : threads)
+            t.join();
+        test(p.use_count() == 1);
+    }
+
+    // the last owner goes while another thread locks and drops a weak_ptr
+    {
+        const int rounds = 20000;
+        std::atomic<int> destroyed(0);
+        std::atomic<bool> bad(false);
+        for(int round = 0; round < rounds; ++round)
+        {
+            shared_ptr<Probe> p = mystd::make_shared<Probe>(&destroyed);
+            std::atomic<bool> started(false);
+            std::thread locker([w = weak_ptr<Probe>(p), &started, &bad]() mutable
+            {
+                started = true;
+                // lock, then drop the only weak reference while still holding the lock
+                shared_ptr<Probe> locked = w.lock();
+                w.reset();
+                for(int i = 0; i < 100 && locked; ++i)
+                    if(locked->magic != 42)
+                        bad = true;
+            });
+            while(!started)
+                std::this_thread::yield();
+            p.reset();
+            locker.join();
+        }
+        test(destroyed == rounds && !bad);
+    }
+
+    return 0;
+}
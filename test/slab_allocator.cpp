@@ -0,0 +1,91 @@
+#include "test.h"
+
+#include <inner/memory/allocators.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+
+struct Message
+{
+    long sequence;
+    long payload[3];
+};
+
+
+int main()
+{
+    typedef slab_allocator<Message> MsgAlloc;
+    typedef allocator_traits<MsgAlloc> MsgTraits;
+
+    static_assert(is_same<MsgTraits::rebind_alloc<int>, slab_allocator<int>>::value, "rebind_alloc");
+    static_assert(MsgTraits::is_always_equal::value, "slab allocators are stateless");
+
+    MsgAlloc ma;
+    test(ma == slab_allocator<int>());
+
+    // a block freed locally is reused right away
+    Message* a = MsgTraits::allocate(ma, 1);
+    test(reinterpret_cast<std::uintptr_t>(a) % alignof(max_align_t) == 0);
+    MsgTraits::deallocate(ma, a, 1);
+    Message* b = MsgTraits::allocate(ma, 1);
+    test(a == b);
+    MsgTraits::deallocate(ma, b, 1);
+
+    // a block freed by another thread comes back to the owner once its local blocks run out
+    Message* c = ma.allocate(1);
+    std::thread([&] { MsgAlloc().deallocate(c, 1); }).join();
+    bool found = false;
+    std::vector<Message*> again;
+    for(int i = 0; i < 20000 && !found; ++i)
+    {
+        again.push_back(ma.allocate(1));
+        found = again.back() == c;
+    }
+    test(found);
+    for(Message* m : again)
+        ma.deallocate(m, 1);
+
+    // producer allocates, consumer frees, through a bounded hand-off queue
+    const long count = 200000;
+    const size_t capacity = 1024;
+    std::vector<std::atomic<Message*>> queue(capacity);
+    for(std::atomic<Message*>& slot : queue)
+        slot.store(nullptr);
+    long received = 0;
+    bool in_order = true;
+
+    std::thread producer([&] {
+        MsgAlloc alloc;
+        for(long i = 0; i < count; ++i)
+        {
+            Message* m = alloc.allocate(1);
+            m->sequence = i;
+            std::atomic<Message*>& slot = queue[i % capacity];
+            while(slot.load(std::memory_order_acquire) != nullptr)
+                std::this_thread::yield();
+            slot.store(m, std::memory_order_release);
+        }
+    });
+    std::thread consumer([&] {
+        MsgAlloc alloc;
+        for(long i = 0; i < count; ++i)
+        {
+            std::atomic<Message*>& slot = queue[i % capacity];
+            Message* m;
+            while((m = slot.load(std::memory_order_acquire)) == nullptr)
+                std::this_thread::yield();
+            slot.store(nullptr, std::memory_order_release);
+            in_order = in_order && m->sequence == i;
+            ++received;
+            alloc.deallocate(m, 1);
+        }
+    });
+    producer.join();
+    consumer.join();
+    test(received == count && in_order);
+
+    return 0;
+}
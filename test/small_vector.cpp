@@ -0,0 +1,108 @@
+#include "test.h"
+
+#include <inner/containers/small_vector.h>
+#include <inner/memory/stats_allocator.h>
+
+#include <string>
+
+
+struct small_tag {};
+struct swap_tag {};
+
+template<typename Vector>
+bool is_inline(const Vector& v)
+{
+    const char* p = reinterpret_cast<const char*>(v.data());
+    const char* self = reinterpret_cast<const char*>(&v);
+    return p >= self && p < self + sizeof(v);
+}
+
+template<typename Vector>
+bool equals(const Vector& v, std::initializer_list<typename Vector::value_type> expected)
+{
+    return v.size() == expected.size() && std::equal(v.begin(), v.end(), expected.begin());
+}
+
+
+int main()
+{
+    // up to N elements live inline and never touch the allocator
+    {
+        typedef stats_allocator<allocator<std::string>, small_tag> Alloc;
+        {
+            small_vector<std::string, 4, Alloc> v;
+            test(v.empty() && v.capacity() == 4 && is_inline(v));
+            v.push_back("a");
+            v.emplace_back("b");
+            v.insert(v.begin(), "c");
+            v.push_back("d");
+            test(equals(v, {"c", "a", "b", "d"}) && is_inline(v));
+            test(allocation_stats<small_tag>::snapshot().allocations == 0);
+
+            // the fifth spills to the heap
+            v.push_back("e");
+            test(!is_inline(v) && v.capacity() >= 8 && equals(v, {"c", "a", "b", "d", "e"}));
+            test(allocation_stats<small_tag>::snapshot().allocations == 1);
+
+            v.erase(v.begin(), v.begin() + 2);
+            v.shrink_to_fit();
+            test(is_inline(v) && v.capacity() == 4 && equals(v, {"b", "d", "e"}));
+            test(allocation_stats<small_tag>::snapshot().live_bytes == 0);
+
+            v.resize(10, "x");
+            v.clear();
+            v.shrink_to_fit();
+            test(is_inline(v));
+        }
+        allocation_stats_snapshot s = allocation_stats<small_tag>::snapshot();
+        test(s.allocations == s.deallocations && s.live_bytes == 0);
+    }
+
+    // copies and moves
+    {
+        small_vector<std::string, 2> inl = {"a", "b"};
+        small_vector<std::string, 2> heap = {"a", "b", "c"};
+        test(is_inline(inl) && !is_inline(heap));
+
+        small_vector<std::string, 2> c1(inl), c2(heap);
+        test(c1 == inl && c2 == heap && inl < heap);
+
+        // inline elements move one by one, heap storage changes hands
+        const std::string* heap_data = heap.data();
+        small_vector<std::string, 2> m1(std::move(inl)), m2(std::move(heap));
+        test(equals(m1, {"a", "b"}) && is_inline(m1) && inl.empty() && is_inline(inl));
+        test(m2.data() == heap_data && heap.empty() && is_inline(heap) && heap.capacity() == 2);
+
+        m1 = std::move(m2);
+        test(equals(m1, {"a", "b", "c"}) && m1.data() == heap_data && m2.empty());
+        m2 = std::move(c1);
+        test(equals(m2, {"a", "b"}) && is_inline(m2));
+        m2 = {"z"};
+        test(equals(m2, {"z"}));
+        m2.assign(5, "y");
+        test(m2.size() == 5 && !is_inline(m2));
+    }
+
+    // swaps between any mix of inline and heap
+    {
+        typedef stats_allocator<allocator<int>, swap_tag> Alloc;
+        {
+            small_vector<int, 3, Alloc> a = {1, 2};
+            small_vector<int, 3, Alloc> b = {3, 4, 5, 6};
+            small_vector<int, 3, Alloc> c = {7};
+            small_vector<int, 3, Alloc> d = {8, 9, 10, 11, 12};
+
+            swap(a, b);
+            test(equals(a, {3, 4, 5, 6}) && equals(b, {1, 2}) && is_inline(b));
+            swap(b, c);
+            test(equals(b, {7}) && equals(c, {1, 2}));
+            const int* d_data = d.data();
+            swap(a, d);
+            test(equals(a, {8, 9, 10, 11, 12}) && a.data() == d_data && equals(d, {3, 4, 5, 6}));
+        }
+        allocation_stats_snapshot s = allocation_stats<swap_tag>::snapshot();
+        test(s.allocations == s.deallocations && s.live_bytes == 0);
+    }
+
+    return 0;
+}
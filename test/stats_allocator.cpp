@@ -0,0 +1,118 @@
+#include "test.h"
+
+#include <inner/memory/stats_allocator.h>
+#include <inner/memory/monotonic_arena.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+struct lists_tag { static const char* name() { return "lists"; } };
+struct arena_tag {};
+
+struct Node
+{
+    Node* next;
+    long value;
+};
+
+// an allocator whose construct does more than placement new
+static int constructs = 0;
+
+template<typename T>
+struct counting_allocator
+{
+    typedef T value_type;
+
+    counting_allocator() noexcept {}
+    template<typename Other>
+    counting_allocator(const counting_allocator<Other>&) noexcept {}
+
+    T* allocate(std::size_t n) { return allocator<T>().allocate(n); }
+    void deallocate(T* p, std::size_t n) { allocator<T>().deallocate(p, n); }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ++constructs;
+        ::new((void*)p) U(std::forward<Args>(args)...);
+    }
+};
+
+
+int main()
+{
+    typedef stats_allocator<allocator<int>, lists_tag> IntAlloc;
+    typedef allocator_traits<IntAlloc>::rebind_alloc<Node> NodeAlloc;
+    static_assert(is_same<NodeAlloc, stats_allocator<allocator<Node>, lists_tag>>::value, "rebind_alloc");
+    static_assert(allocator_traits<IntAlloc>::is_always_equal::value, "forwarded from allocator<int>");
+
+    IntAlloc ia;
+    NodeAlloc na(ia);
+    test(na == ia);
+
+    int* ints = allocator_traits<IntAlloc>::allocate(ia, 100);
+    Node* node = allocator_traits<NodeAlloc>::allocate(na, 1);
+    allocator_traits<NodeAlloc>::construct(na, node);
+
+    allocation_stats_snapshot s = IntAlloc::stats();
+    test(std::strcmp(s.tag, "lists") == 0);
+    test(s.allocations == 2 && s.deallocations == 0);
+    test(s.live_bytes == 100 * sizeof(int) + sizeof(Node));
+    test(s.histogram[8] == 1);  // 400 bytes
+    test(s.histogram[4] == 1);  // 16 bytes
+
+    allocator_traits<IntAlloc>::deallocate(ia, ints, 100);
+    allocator_traits<NodeAlloc>::destroy(na, node);
+    allocator_traits<NodeAlloc>::deallocate(na, node, 1);
+    s = allocation_stats<lists_tag>::snapshot();
+    test(s.deallocations == 2 && s.live_bytes == 0);
+    test(s.peak_live_bytes == 100 * sizeof(int) + sizeof(Node));
+
+    // counters from several threads land in different shards and add up
+    std::vector<std::thread> workers;
+    for(int t = 0; t < 4; ++t)
+        workers.emplace_back([] {
+            NodeAlloc a;
+            for(int i = 0; i < 1000; ++i)
+                a.deallocate(a.allocate(1), 1);
+        });
+    for(std::thread& w : workers)
+        w.join();
+    s = allocation_stats<lists_tag>::snapshot();
+    test(s.allocations == 4002 && s.deallocations == 4002);
+
+    std::string json = s.to_json();
+    test(json.find("\"tag\":\"lists\"") != std::string::npos);
+    test(json.find("\"allocations\":4002") != std::string::npos);
+    test(json.find("\"16\":4001") != std::string::npos);
+    test(s.to_text().find("[lists]") != std::string::npos);
+
+    allocation_stats<lists_tag>::reset();
+    test(allocation_stats<lists_tag>::snapshot().allocations == 0);
+
+    // wrapping a stateful allocator; tags keep separate books
+    monotonic_arena arena;
+    stats_allocator<arena_allocator<char>, arena_tag> aa(arena);
+    aa.allocate(1000);
+    test(allocation_stats<arena_tag>::snapshot().bytes_allocated == 1000);
+    test(std::strcmp(allocation_stats<arena_tag>::name(), "untagged") == 0);
+    test(allocation_stats<lists_tag>::snapshot().allocations == 0);
+    test(&aa.inner_allocator().arena() == &arena);
+
+    // construct and destroy are only there when the inner allocator has them
+    static_assert(!detail::alloc_customizes_construct<IntAlloc, int, int>::value, "plain construct");
+    static_assert(!detail::alloc_customizes_destroy<IntAlloc, int>::value, "plain destroy");
+    static_assert(is_trivially_relocatable<IntAlloc>::value, "");
+    typedef stats_allocator<counting_allocator<int>, arena_tag> CountingAlloc;
+    static_assert(detail::alloc_customizes_construct<CountingAlloc, int, int>::value, "forwarded construct");
+    static_assert(!detail::alloc_customizes_destroy<CountingAlloc, int>::value, "no destroy to forward");
+    CountingAlloc ca;
+    int* i = ca.allocate(1);
+    allocator_traits<CountingAlloc>::construct(ca, i, 5);
+    test(*i == 5 && constructs == 1);
+    allocator_traits<CountingAlloc>::destroy(ca, i);
+    ca.deallocate(i, 1);
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "test.h"
+
+#include <inner/memory/uninitialized.h>
+
+#include <list>
+#include <string>
+
+
+int live = 0;
+int throw_after = -1;
+
+struct Tracked
+{
+    int v;
+    Tracked() : v(7) { check(); ++live; }
+    Tracked(int x) : v(x) { check(); ++live; }
+    Tracked(const Tracked& o) : v(o.v) { check(); ++live; }
+    Tracked(Tracked&& o) : v(o.v) { check(); o.v = -1; ++live; }
+    ~Tracked() { --live; }
+
+    static void check()
+    {
+        if(throw_after == 0)
+            throw 42;
+        if(throw_after > 0)
+            --throw_after;
+    }
+};
+
+struct Pod { int a; double b; };
+
+// allocator that counts the elements it constructs and destroys
+int constructed = 0;
+int destroyed = 0;
+
+template<typename T>
+struct counting_allocator : allocator<T>
+{
+    template<typename Other>
+    struct rebind { typedef counting_allocator<Other> other; };
+
+    counting_allocator() noexcept {}
+    template<typename Other>
+    counting_allocator(const counting_allocator<Other>&) noexcept {}
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+        ++constructed;
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+        p->~U();
+        ++destroyed;
+    }
+};
+
+
+template<typename T>
+T* raw(size_t n)
+{
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+}
+
+
+int main()
+{
+    static_assert(detail::is_memcpy_copyable<const int*, int*>::value, "memcpy path");
+    static_assert(!detail::is_memcpy_copyable<std::string*, std::string*>::value, "no memcpy for string");
+    static_assert(!detail::is_memcpy_copyable<std::list<int>::iterator, int*>::value, "no memcpy for list");
+    static_assert(!detail::alloc_customizes_construct<allocator<int>, int, int>::value, "plain allocator");
+    static_assert(detail::alloc_customizes_construct<counting_allocator<int>, int, int>::value, "custom construct");
+
+    // trivially copyable: copy, move, fill
+    {
+        const int src[5] = { 1, 2, 3, 4, 5 };
+        int* dst = raw<int>(5);
+        test(uninitialized_copy(src, src + 5, dst) == dst + 5);
+        test(dst[0] == 1 && dst[4] == 5);
+        test(uninitialized_copy_n(src, 3, dst) == dst + 3);
+        test(uninitialized_move(src + 2, src + 5, dst) == dst + 3 && dst[0] == 3);
+
+        uninitialized_fill(dst, dst + 5, 0);
+        test(dst[0] == 0 && dst[4] == 0);
+        uninitialized_fill_n(dst, 5, 9);
+        test(dst[0] == 9 && dst[4] == 9);
+        destroy(dst, dst + 5);
+        ::operator delete(dst);
+
+        char* bytes = raw<char>(16);
+        uninitialized_fill(bytes, bytes + 16, 'x');
+        test(bytes[0] == 'x' && bytes[15] == 'x');
+        ::operator delete(bytes);
+    }
+
+    // value construction zeroes trivial types, default construction leaves them alone
+    {
+        Pod* p = raw<Pod>(4);
+        p[3].a = 5;
+        uninitialized_default_construct(p, p + 4);
+        test(p[3].a == 5);
+        uninitialized_value_construct_n(p, 4);
+        test(p[0].a == 0 && p[3].a == 0 && p[3].b == 0.0);
+        ::operator delete(p);
+    }
+
+    // non-trivial types, from a non-pointer range
+    {
+        std::list<std::string> words = { "a", "bb", "ccc" };
+        std::string* s = raw<std::string>(3);
+        test(uninitialized_copy(words.begin(), words.end(), s) == s + 3);
+        test(s[2] == "ccc" && words.back() == "ccc");
+        destroy(s, s + 3);
+        test(uninitialized_move(words.begin(), words.end(), s) == s + 3);
+        test(s[1] == "bb");
+        destroy_n(s, 3);
+        ::operator delete(s);
+    }
+
+    // a throwing constructor destroys what was built so far
+    {
+        Tracked* t = raw<Tracked>(5);
+        throw_after = 3;
+        bool thrown = false;
+        try { uninitialized_value_construct(t, t + 5); }
+        catch(int) { thrown = true; }
+        test(thrown && live == 0);
+
+        throw_after = -1;
+        uninitialized_fill(t, t + 5, Tracked(3));
+        test(live == 5 && t[4].v == 3);
+
+        Tracked* u = raw<Tracked>(5);
+        throw_after = 2;
+        thrown = false;
+        try { uninitialized_copy(t, t + 5, u); }
+        catch(int) { thrown = true; }
+        test(thrown && live == 5);
+        throw_after = -1;
+
+        uninitialized_move(t, t + 5, u);
+        test(live == 10 && u[0].v == 3 && t[0].v == -1);
+        destroy(t, t + 5);
+        destroy(u, u + 5);
+        test(live == 0);
+        ::operator delete(t);
+        ::operator delete(u);
+    }
+
+    // allocator-aware overloads only go element by element when construct/destroy are customized
+    {
+        counting_allocator<int> a;
+        int src[4] = { 1, 2, 3, 4 };
+        int* p = raw<int>(4);
+        uninitialized_copy(src, src + 4, p, a);
+        test(constructed == 4 && p[3] == 4);
+        destroy(p, p + 4, a);
+        test(destroyed == 4);
+        uninitialized_fill(p, p + 4, 6, a);
+        uninitialized_value_construct(p, p + 4, a);
+        test(constructed == 12 && p[0] == 0);
+        uninitialized_move(src, src + 4, p, a);
+        test(constructed == 16 && p[2] == 3);
+
+        allocator<int> plain;
+        uninitialized_copy(src, src + 4, p, plain);
+        uninitialized_default_construct(p, p + 4, plain);
+        test(p[1] == 2);
+        destroy(p, p + 4, plain);
+        test(constructed == 16 && destroyed == 4);
+        ::operator delete(p);
+
+        counting_allocator<Tracked> ta;
+        Tracked* t = raw<Tracked>(4);
+        throw_after = 2;
+        bool thrown = false;
+        try { uninitialized_default_construct(t, t + 4, ta); }
+        catch(int) { thrown = true; }
+        test(thrown && live == 0 && destroyed == 6);
+        throw_after = -1;
+        ::operator delete(t);
+    }
+
+    return 0;
+}
@@ -1,7 +1,12 @@
 #include "test.h"
 
+#include <inner/memory/unique_ptr.h>
+
 #include <iostream>
 #include <memory>
+#include <new>
+#include <cstdlib>
+#include <cstring>
 
 
 struct Foo { // object to manage
@@ -11,6 +16,28 @@ struct Foo { // object to manage
     ~Foo() { std::cout << "~Foo dtor\n"; }
 };
  
+int live_bars = 0;
+
+struct Bar {
+    int value;
+    Bar() : value(7) { ++live_bars; }
+    ~Bar() { --live_bars; }
+};
+
+// remembers what the last array new[] returned, to look at the memory before it is initialized
+void* last_array = nullptr;
+void* operator new[](std::size_t size)
+{
+    void* p = std::malloc(size);
+    if(p == nullptr)
+        throw std::bad_alloc();
+    std::memset(p, 0xab, size);
+    last_array = p;
+    return p;
+}
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
 struct D { // deleter
     D() {};
     D(const D&) { std::cout << "D copy ctor\n"; }
@@ -68,6 +95,42 @@ int main()
     //     std::auto_ptr<Foo> up7a(new Foo);
     //     unique_ptr<Foo> up7b(std::move(up7a)); // ownership transfer
     // }
-    unique_ptr<int[]> tem();
+
+    std::cout << "Array specialization...\n";
+    {
+        unique_ptr<Bar[]> bars(new Bar[3]);
+        test(live_bars == 3 && bars[2].value == 7);
+        bars[1].value = 1;
+        test(bars.get()[1].value == 1);
+
+        unique_ptr<const Bar[]> moved(std::move(bars));
+        test(!bars && moved && moved[1].value == 1);
+        moved.reset(new Bar[2]);
+        test(live_bars == 2);
+        moved = nullptr;
+        test(live_bars == 0 && moved == nullptr);
+    }
+
+    std::cout << "make_unique...\n";
+    {
+        unique_ptr<Foo> foo = make_unique<Foo>();
+        test(foo != nullptr);
+
+        unique_ptr<int[]> zeros = make_unique<int[]>(16);
+        test(zeros[0] == 0 && zeros[15] == 0);
+
+        // for_overwrite leaves trivial elements as operator new[] returned them
+        unique_ptr<unsigned char[]> raw = make_unique_for_overwrite<unsigned char[]>(64);
+        test(raw.get() == last_array && raw[0] == 0xab && raw[63] == 0xab);
+
+        unique_ptr<Bar[]> built = make_unique_for_overwrite<Bar[]>(4);
+        test(live_bars == 4 && built[3].value == 7);
+        built.reset();
+        test(live_bars == 0);
+
+        unique_ptr<long> one = make_unique_for_overwrite<long>();
+        *one = 3;
+        test(*one == 3);
+    }
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "test.h"
+
+#include <inner/containers/vector.h>
+#include <inner/memory/stats_allocator.h>
+
+#include <sstream>
+#include <string>
+
+
+static int copies = 0;
+static int moves = 0;
+static int live = 0;
+static int throw_after = -1; // copies left before a copy throws, -1 for never
+
+// Movable with a throwing move constructor, so vector relocates it by copy.
+struct Tracked
+{
+    int value;
+    Tracked(int v = 0) : value(v) { ++live; }
+    Tracked(const Tracked& other) : value(other.value)
+    {
+        if(throw_after == 0)
+            throw 1;
+        if(throw_after > 0)
+            --throw_after;
+        ++copies;
+        ++live;
+    }
+    Tracked(Tracked&& other) : value(other.value) { ++moves; ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { --live; }
+};
+
+struct NothrowMove
+{
+    int value;
+    NothrowMove(int v = 0) : value(v) {}
+    NothrowMove(const NothrowMove& other) : value(other.value) { ++copies; }
+    NothrowMove(NothrowMove&& other) noexcept : value(other.value) { ++moves; }
+    NothrowMove& operator=(const NothrowMove&) = default;
+    NothrowMove& operator=(NothrowMove&&) = default;
+};
+
+struct vector_tag {};
+
+template<typename T>
+bool equals(const vector<T>& v, std::initializer_list<T> expected)
+{
+    return v.size() == expected.size() && std::equal(v.begin(), v.end(), expected.begin());
+}
+
+
+int main()
+{
+    // construction, access, growth
+    {
+        vector<int> v;
+        test(v.empty() && v.capacity() == 0 && v.data() == nullptr);
+        for(int i = 0; i < 100; ++i)
+            v.push_back(i);
+        test(v.size() == 100 && v.front() == 0 && v.back() == 99 && v[42] == 42 && v.capacity() >= 100);
+
+        bool thrown = false;
+        try
+        {
+            v.at(100);
+        }
+        catch(const std::out_of_range&)
+        {
+            thrown = true;
+        }
+        test(thrown);
+
+        vector<int> filled(3, 7);
+        test(equals(filled, {7, 7, 7}));
+        vector<int> zeros(4);
+        test(equals(zeros, {0, 0, 0, 0}));
+        vector<int> listed = {1, 2, 3};
+        test(equals(listed, {1, 2, 3}));
+        vector<int> sized(5, 5); // (count, value), not an iterator range
+        test(sized.size() == 5);
+
+        std::istringstream in("4 5 6");
+        vector<int> streamed((std::istream_iterator<int>(in)), std::istream_iterator<int>());
+        test(equals(streamed, {4, 5, 6}));
+
+        test(vector<int>(v.rbegin(), v.rend()).front() == 99);
+    }
+
+    // the growth factor is a policy
+    {
+        // the allocator may hand out more than asked for, and vector keeps it as capacity
+        vector<int, allocator<int>, growth_factor<3, 2>> v;
+        v.reserve(100);
+        size_t full = v.capacity();
+        test(full >= 100);
+        v.resize(full);
+        v.push_back(0);
+        test(v.capacity() >= full * 3 / 2 && v.capacity() < full * 2);
+
+        vector<int> d(full);
+        d.shrink_to_fit();
+        full = d.capacity();
+        d.resize(full + 1);
+        test(d.capacity() >= full * 2);
+        test(growth_factor<3, 2>::grow<size_t>(1, 2, 100) == 2);
+        test(growth_factor<2, 1>::grow<size_t>(60, 61, 100) == 100);
+    }
+
+    // insert and erase
+    {
+        vector<int> v = {1, 2, 3, 4, 5};
+        v.reserve(20);
+        test(*v.insert(v.begin() + 1, 9) == 9 && equals(v, {1, 9, 2, 3, 4, 5}));
+        v.erase(v.begin() + 1);
+        v.insert(v.begin() + 1, 2, 0);           // fewer than the elements after pos
+        test(equals(v, {1, 0, 0, 2, 3, 4, 5}));
+        v.insert(v.end() - 1, 3, 8);             // more than the elements after pos
+        test(equals(v, {1, 0, 0, 2, 3, 4, 8, 8, 8, 5}));
+        v.erase(v.begin() + 1, v.begin() + 3);
+        v.erase(v.begin() + 4, v.begin() + 7);
+        test(equals(v, {1, 2, 3, 4, 5}));
+
+        int extra[] = {6, 7, 8};
+        v.insert(v.begin(), extra, extra + 3);
+        v.insert(v.end() - 1, {10, 11});
+        test(equals(v, {6, 7, 8, 1, 2, 3, 4, 10, 11, 5}));
+
+        std::istringstream in("-1 -2");
+        v.insert(v.begin() + 2, std::istream_iterator<int>(in), std::istream_iterator<int>());
+        test(equals(v, {6, 7, -1, -2, 8, 1, 2, 3, 4, 10, 11, 5}));
+
+        // through a reallocation
+        vector<int> small = {1, 2};
+        small.shrink_to_fit();
+        small.insert(small.begin() + 1, {5, 6, 7});
+        test(equals(small, {1, 5, 6, 7, 2}));
+
+        // an argument referring to an element of the vector itself
+        vector<std::string> s = {"a", "b", "c"};
+        s.shrink_to_fit();
+        s.push_back(s[0]);
+        s.reserve(10);
+        s.insert(s.begin(), s[2]);
+        s.insert(s.begin(), 2, s.back());
+        test(s.size() == 7 && s[0] == "a" && s[1] == "a" && s[2] == "c" && s[6] == "a");
+    }
+
+    // assignment
+    {
+        vector<int> a = {1, 2, 3};
+        vector<int> b;
+        b = a;
+        test(a == b);
+        b.assign(2, 4);
+        test(equals(b, {4, 4}) && a != b && b > a);
+        b.assign({5, 6, 7, 8});
+        test(equals(b, {5, 6, 7, 8}));
+        vector<int> c(std::move(b));
+        test(b.empty() && equals(c, {5, 6, 7, 8}));
+        a = std::move(c);
+        test(equals(a, {5, 6, 7, 8}) && c.empty());
+        swap(a, c);
+        test(a.empty() && c.size() == 4);
+        c.resize(2);
+        c.resize(3, 9);
+        test(equals(c, {5, 6, 9}));
+    }
+
+    // reallocation moves noexcept movables and copies the others
+    {
+        copies = moves = 0;
+        vector<NothrowMove> n(4);
+        n.resize(n.capacity());
+        int count = (int)n.size();
+        n.push_back(NothrowMove(1));
+        test(copies == 0 && moves == count + 1);
+
+        copies = moves = 0;
+        vector<Tracked> t(4);
+        t.resize(t.capacity());
+        count = (int)t.size();
+        t.push_back(Tracked(1));
+        test(copies == count && moves == 1);
+    }
+
+    // emplace_back and reserve are all-or-nothing when relocation copies
+    live = 0;
+    {
+        vector<Tracked> v;
+        for(int i = 0; i < 4; ++i)
+            v.emplace_back(i);
+        v.shrink_to_fit();
+        while(v.size() < v.capacity())
+            v.emplace_back(3);
+        size_t count = v.size();
+        const Tracked* old = v.data();
+
+        throw_after = 2;
+        bool thrown = false;
+        try
+        {
+            v.emplace_back(4);
+        }
+        catch(int)
+        {
+            thrown = true;
+        }
+        throw_after = -1;
+        test(thrown && v.size() == count && v.capacity() == count && v.data() == old);
+        test(v[0].value == 0 && v[3].value == 3 && live == (int)count);
+
+        throw_after = 0;
+        thrown = false;
+        try
+        {
+            v.reserve(100);
+        }
+        catch(int)
+        {
+            thrown = true;
+        }
+        throw_after = -1;
+        test(thrown && v.capacity() == count && live == (int)count);
+    }
+    test(live == 0);
+
+    // default-initialized growth leaves trivial elements as the memory was
+    {
+        vector<int> v(8, 0x5a5a);
+        v.clear();
+        v.resize_for_overwrite(6);
+        test(v.size() == 6 && v[0] == 0x5a5a && v[5] == 0x5a5a);
+        v.resize_for_overwrite(2);
+        test(v.size() == 2);
+
+        int* tail = v.append_uninit(3);
+        test(v.size() == 5 && tail == v.data() + 2 && tail[2] == 0x5a5a);
+        tail[0] = tail[1] = tail[2] = 1;
+        test(v[4] == 1);
+
+        // past the capacity too
+        size_t cap = v.capacity();
+        int* more = v.append_uninit(cap);
+        test(v.size() == 5 + cap && more == v.data() + 5);
+
+        // other types are still constructed
+        vector<std::string> s = {"a"};
+        std::string* fresh = s.append_uninit(2);
+        test(s.size() == 3 && fresh[0].empty() && fresh[1].empty() && s[0] == "a");
+        s.resize_for_overwrite(4);
+        test(s.size() == 4 && s[3].empty());
+    }
+
+    // storage comes from the allocator and goes back to it
+    {
+        typedef stats_allocator<allocator<int>, vector_tag> Alloc;
+        {
+            vector<int, Alloc> v;
+            for(int i = 0; i < 1000; ++i)
+                v.push_back(i);
+            vector<int, Alloc> copy(v);
+            test(copy == v);
+            v.clear();
+            v.shrink_to_fit();
+            test(v.capacity() == 0);
+        }
+        allocation_stats_snapshot s = allocation_stats<vector_tag>::snapshot();
+        test(s.allocations == s.deallocations && s.live_bytes == 0);
+    }
+
+    return 0;
+}